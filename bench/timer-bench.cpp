@@ -0,0 +1,936 @@
+//
+// Timer latency and throughput benchmark.
+//
+// Usage: timer-bench [--quick] [--max-timers N]
+//
+#include <algorithm>
+#include <cerrno>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "precision_dispatcher.h"
+#include "timeout_manager.h"
+#include "timer.h"
+#include "timer_epoll.h"
+#include "timer_dispatcher.h"
+#include "timer_group.h"
+#include "timer_pool.h"
+#include "timer_service.h"
+#include "timer_signalfd.h"
+#include "timer_uring.h"
+#include "timer_wheel.h"
+#include "trace.h"
+#include "tsc_clock.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+namespace
+{
+  /**
+   * Log-linear histogram of nanosecond values, 16 sub-buckets per power of two, i.e. values are kept with at
+   * least 1/16 relative precision. Recording is a single array increment, so it's usable from a signal handler.
+   */
+  class histogram
+  {
+    static constexpr unsigned sub_bits = 5;
+    static constexpr uint64_t sub_count = uint64_t(1) << sub_bits;
+    static constexpr uint64_t half_count = sub_count / 2;
+    static constexpr size_t bucket_count = sub_count + (64 - sub_bits) * half_count;
+
+    array<uint64_t, bucket_count> _counts{};
+    uint64_t _total = 0;
+    uint64_t _max = 0;
+    long double _sum = 0;
+
+    static size_t index(uint64_t v) noexcept
+    {
+      if (v < sub_count)
+      {
+        return v;
+      }
+      unsigned msb = 63 - __builtin_clzll(v);
+      unsigned shift = msb - (sub_bits - 1);
+      return sub_count + (shift - 1) * half_count + ((v >> shift) - half_count);
+    }
+
+    static uint64_t highest(size_t i) noexcept
+    {
+      if (i < sub_count)
+      {
+        return i;
+      }
+      unsigned shift = (i - sub_count) / half_count + 1;
+      uint64_t m = (i - sub_count) % half_count + half_count;
+      return ((m + 1) << shift) - 1;
+    }
+
+    public:
+    void record(int64_t v) noexcept
+    {
+      auto u = static_cast<uint64_t>(max<int64_t>(v, 0));
+      _counts[index(u)]++;
+      _total++;
+      _sum += u;
+      _max = max(_max, u);
+    }
+
+    void clear() noexcept
+    {
+      _counts.fill(0);
+      _total = _max = 0;
+      _sum = 0;
+    }
+
+    uint64_t count() const noexcept
+    {
+      return _total;
+    }
+
+    uint64_t max_value() const noexcept
+    {
+      return _max;
+    }
+
+    double mean() const noexcept
+    {
+      return _total ? static_cast<double>(_sum / _total) : 0;
+    }
+
+    uint64_t percentile(double p) const noexcept
+    {
+      if (_total == 0)
+      {
+        return 0;
+      }
+      auto rank = static_cast<uint64_t>(p / 100.0 * _total + 0.5);
+      rank = max<uint64_t>(rank, 1);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < bucket_count; i++)
+      {
+        seen += _counts[i];
+        if (seen >= rank)
+        {
+          return min(highest(i), _max);
+        }
+      }
+      return _max;
+    }
+  };
+
+  struct options
+  {
+    bool quick = false;
+    size_t max_timers = 100000;
+  };
+
+  int64_t now_ns(clockid_t clock = CLOCK_MONOTONIC) noexcept
+  {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+  }
+
+  string human(double ns)
+  {
+    char buf[32];
+    if (ns < 1e3)
+    {
+      snprintf(buf, sizeof(buf), "%.0fns", ns);
+    }
+    else if (ns < 1e6)
+    {
+      snprintf(buf, sizeof(buf), "%.1fus", ns / 1e3);
+    }
+    else if (ns < 1e9)
+    {
+      snprintf(buf, sizeof(buf), "%.2fms", ns / 1e6);
+    }
+    else
+    {
+      snprintf(buf, sizeof(buf), "%.2fs", ns / 1e9);
+    }
+    return buf;
+  }
+
+  /**
+   * Sleeps until the absolute CLOCK_MONOTONIC deadline. The deadline is absolute, so a relative sleep restarted after
+   * every timer signal can't keep sleeping forever at high signal rates.
+   */
+  void sleep_until(int64_t deadline)
+  {
+    struct timespec ts;
+    ts.tv_sec = deadline / 1000000000;
+    ts.tv_nsec = deadline % 1000000000;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+    {}
+  }
+
+  /**
+   * Lateness of every expiration against the ideal grid epoch + k * period. The timer is started phase locked at a
+   * known epoch, coalesced expirations are accounted with timer::expirations, so overruns count as late samples.
+   */
+  struct lateness_probe
+  {
+    timer* _timer = nullptr;
+    int64_t _epoch = 0;
+    int64_t _period = 0;
+    uint64_t _expirations = 0;
+    uint64_t _overruns = 0;
+    histogram _histogram;
+
+    static void expired(void* data)
+    {
+      auto probe = static_cast<lateness_probe*>(data);
+      auto now = now_ns();
+      auto n = probe->_timer->expirations();
+      probe->_expirations += n;
+      probe->_overruns += n - 1;
+      probe->_histogram.record(now - (probe->_epoch + static_cast<int64_t>(probe->_expirations - 1) * probe->_period));
+    }
+  };
+
+  void bench_lateness(const options& opt, timer::backend be)
+  {
+    const nanoseconds periods[] = {microseconds(10), microseconds(100), milliseconds(1), milliseconds(10),
+      milliseconds(100), seconds(1)};
+
+    printf("\nwakeup lateness, %s backend\n", be == timer::backend::signal ? "signal" : "timerfd");
+    printf("%10s %10s %10s %10s %10s %10s %10s %10s\n", "period", "samples", "overruns", "mean", "p50", "p99",
+        "p99.9", "max");
+
+    for (auto period : periods)
+    {
+      auto run = opt.quick ? max<nanoseconds>(milliseconds(200), period * 3) : max<nanoseconds>(seconds(1), period * 5);
+      if (opt.quick && period >= seconds(1))
+      {
+        continue;
+      }
+
+      // keep the probe off the stack of the timer callback path, the histogram is big
+      auto probe = make_unique<lateness_probe>();
+      probe->_period = period.count();
+
+      timer tm(be, duration_cast<seconds>(period), period % seconds(1), &lateness_probe::expired, probe.get(),
+          false, CLOCK_MONOTONIC);
+      probe->_timer = &tm;
+
+      timer_epoll poller;
+      if (be == timer::backend::timerfd)
+      {
+        poller.add(tm);
+      }
+
+      probe->_epoch = now_ns() + period.count();
+      tm.start_at(nanoseconds(probe->_epoch));
+
+      auto deadline = now_ns() + run.count();
+      if (be == timer::backend::timerfd)
+      {
+        while (now_ns() < deadline)
+        {
+          poller.dispatch(milliseconds(10));
+        }
+        poller.remove(tm);
+      }
+      else
+      {
+        sleep_until(deadline);
+      }
+      tm.stop();
+
+      auto& h = probe->_histogram;
+      printf("%10s %10lu %10lu %10s %10s %10s %10s %10s\n", human(period.count()).c_str(),
+          static_cast<unsigned long>(h.count()), static_cast<unsigned long>(probe->_overruns), human(h.mean()).c_str(),
+          human(h.percentile(50)).c_str(), human(h.percentile(99)).c_str(), human(h.percentile(99.9)).c_str(),
+          human(h.max_value()).c_str());
+    }
+  }
+
+  void bench_precision(const options& opt)
+  {
+    const nanoseconds period = microseconds(100);
+    const nanoseconds windows[] = {nanoseconds(0), microseconds(10), microseconds(20), microseconds(50),
+      microseconds(100)};
+    const nanoseconds run = opt.quick ? milliseconds(200) : seconds(2);
+
+    printf("\nwakeup lateness, precision mode, period %s\n", human(period.count()).c_str());
+    printf("%10s %10s %10s %10s %10s %10s %10s %10s %10s %10s\n", "window", "samples", "overruns", "mean", "p50", "p99",
+        "p99.9", "max", "<16us", "spin cpu");
+
+    for (auto window : windows)
+    {
+      precision_dispatcher dispatcher(window);
+      auto probe = make_unique<lateness_probe>();
+      probe->_period = period.count();
+
+      timer tm(dispatcher, duration_cast<seconds>(period), period % seconds(1), &lateness_probe::expired, probe.get(),
+          false, CLOCK_MONOTONIC);
+      probe->_timer = &tm;
+
+      probe->_epoch = now_ns() + period.count();
+      tm.start_at(nanoseconds(probe->_epoch));
+      sleep_until(now_ns() + run.count());
+      tm.stop();
+
+      // the price of the precision, the share of the dispatcher thread spent spinning
+      auto st = tm.stats();
+      auto spin = 100.0 * static_cast<double>(st.spin_total.count()) / static_cast<double>(run.count());
+
+      // the share of the expirations delivered within the clock read granularity, the rest has been preempted for
+      // longer than the spin window
+      std::uint64_t punctual = 0;
+      for (std::size_t i = 0; timer_stats::bucket_bound(i) <= microseconds(16); i++)
+      {
+        punctual += st.lateness[i];
+      }
+      auto share = st.fires ? 100.0 * static_cast<double>(punctual) / static_cast<double>(st.fires) : 0.0;
+
+      auto& h = probe->_histogram;
+      printf("%10s %10lu %10lu %10s %10s %10s %10s %10s %9.1f%% %9.1f%%\n", human(window.count()).c_str(),
+          static_cast<unsigned long>(h.count()), static_cast<unsigned long>(probe->_overruns), human(h.mean()).c_str(),
+          human(h.percentile(50)).c_str(), human(h.percentile(99)).c_str(), human(h.percentile(99.9)).c_str(),
+          human(h.max_value()).c_str(), share, spin);
+    }
+  }
+
+  template <typename Timer>
+  void bench_calls(const char* name, Timer& tm, size_t iterations)
+  {
+    histogram start, suspend, resume, reset, stop, refused;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+      auto t0 = now_ns();
+      tm.start();
+      auto t1 = now_ns();
+      tm.suspend();
+      auto t2 = now_ns();
+      tm.resume();
+      auto t3 = now_ns();
+      tm.reset();
+      auto t4 = now_ns();
+      tm.stop();
+      auto t5 = now_ns();
+      // stopping it again is refused with a warning code, nothing is thrown
+      tm.try_stop();
+      auto t6 = now_ns();
+
+      start.record(t1 - t0);
+      suspend.record(t2 - t1);
+      resume.record(t3 - t2);
+      reset.record(t4 - t3);
+      stop.record(t5 - t4);
+      refused.record(t6 - t5);
+    }
+
+    auto row = [name](const char* op, const histogram& h) {
+        printf("%-10s %-8s %10s %10s %10s %10s\n", name, op, human(h.mean()).c_str(), human(h.percentile(50)).c_str(),
+            human(h.percentile(99)).c_str(), human(h.max_value()).c_str());
+      };
+    row("start", start);
+    row("suspend", suspend);
+    row("resume", resume);
+    row("reset", reset);
+    row("stop", stop);
+    row("refused", refused);
+  }
+
+  void bench_calls(const options& opt)
+  {
+    auto iterations = opt.quick ? size_t(2000) : size_t(100000);
+
+    printf("\nper call cost, %lu iterations\n", static_cast<unsigned long>(iterations));
+    printf("%-10s %-8s %10s %10s %10s %10s\n", "timer", "call", "mean", "p50", "p99", "max");
+
+    // the period is long enough for no expiration to happen during the measurement
+    {
+      timer tm(seconds(10));
+      bench_calls("signal", tm, iterations);
+    }
+    {
+      timer tm(timer::backend::timerfd, seconds(10));
+      bench_calls("timerfd", tm, iterations);
+    }
+    {
+      timer_wheel wheel;
+      timer_wheel::timer tm(wheel, seconds(10));
+      bench_calls("wheel", tm, iterations);
+    }
+  }
+
+  volatile int64_t read_sink;                  /**< keeps the measured reads from being optimized out */
+
+  template <typename Read>
+  void bench_read(const char* name, size_t iterations, Read read)
+  {
+    // a single read is below the resolution of the clock, time batches of reads
+    constexpr size_t batch = 100;
+    histogram h;
+
+    for (size_t i = 0; i < iterations / batch; i++)
+    {
+      auto t0 = now_ns();
+      for (size_t j = 0; j < batch; j++)
+      {
+        read_sink = read();
+      }
+      h.record((now_ns() - t0) / static_cast<int64_t>(batch));
+    }
+
+    printf("%-20s %10s %10s %10s %10s\n", name, human(h.mean()).c_str(), human(h.percentile(50)).c_str(),
+        human(h.percentile(99)).c_str(), human(h.max_value()).c_str());
+  }
+
+  void bench_clocks(const options& opt)
+  {
+    auto iterations = opt.quick ? size_t(100000) : size_t(10000000);
+
+    printf("\nclock read cost, %lu iterations, tsc %s\n", static_cast<unsigned long>(iterations),
+        tsc_clock::uses_tsc() ? "calibrated" : "unavailable");
+    printf("%-20s %10s %10s %10s %10s\n", "read", "mean", "p50", "p99", "max");
+
+    bench_read("tsc_clock::now", iterations, [] {
+        return tsc_clock::now().time_since_epoch().count();
+      });
+    bench_read("clock_gettime", iterations, [] {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_nsec);
+      });
+
+    timer tm(seconds(10));
+    tm.start();
+    bench_read("timer::remaining", iterations, [&tm] {
+        return tm.remaining().count();
+      });
+    tm.stop();
+  }
+
+  void bench_timeouts(const options& opt)
+  {
+    // RPC like: a ring of in flight requests, each one's timeout is cancelled and re-armed by the next request
+    constexpr size_t in_flight = 1024;
+    auto pairs = opt.quick ? size_t(200000) : size_t(10000000);
+
+    printf("\ntimeout arm and cancel, %lu pairs, %lu in flight\n", static_cast<unsigned long>(pairs),
+        static_cast<unsigned long>(in_flight));
+    printf("%-16s %10s %12s %10s %10s\n", "timeouts", "per pair", "pairs/s", "settimes", "wakeups");
+
+    {
+      timeout_manager manager;
+      std::deque<timeout_manager::timeout> timeouts;
+      for (size_t i = 0; i < in_flight; i++)
+      {
+        timeouts.emplace_back(manager);
+      }
+
+      auto t0 = now_ns();
+      for (size_t i = 0; i < pairs; i++)
+      {
+        auto& to = timeouts[i % in_flight];
+        to.cancel();
+        to.arm(seconds(1));
+      }
+      auto elapsed = now_ns() - t0;
+
+      auto stats = manager.stats();
+      printf("%-16s %10s %12.0f %10lu %10lu\n", "timeout_manager", human(elapsed / static_cast<int64_t>(pairs)).c_str(),
+          1e9 * static_cast<double>(pairs) / static_cast<double>(elapsed), static_cast<unsigned long>(stats.settimes),
+          static_cast<unsigned long>(stats.wakeups));
+    }
+
+    {
+      // the same workload on kernel timers, two syscalls per pair
+      auto n = pairs / 100;
+      std::deque<timer> timers;
+      for (size_t i = 0; i < in_flight; i++)
+      {
+        timers.emplace_back(seconds(1), nanoseconds(0), nullptr, nullptr, true);
+      }
+
+      auto t0 = now_ns();
+      for (size_t i = 0; i < n; i++)
+      {
+        auto& tm = timers[i % in_flight];
+        tm.try_stop();
+        tm.try_start();
+      }
+      auto elapsed = now_ns() - t0;
+
+      printf("%-16s %10s %12.0f %10lu %10s\n", "timer", human(elapsed / static_cast<int64_t>(n)).c_str(),
+          1e9 * static_cast<double>(n) / static_cast<double>(elapsed), static_cast<unsigned long>(2 * n), "-");
+    }
+  }
+
+  template <typename Make>
+  void bench_lifetime(const char* name, size_t iterations, Make make)
+  {
+    histogram h;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+      auto t0 = now_ns();
+      {
+        auto tm = make();
+        tm->start();
+      }
+      h.record(now_ns() - t0);
+    }
+
+    printf("%-10s %10s %10s %10s %10s\n", name, human(h.mean()).c_str(), human(h.percentile(50)).c_str(),
+        human(h.percentile(99)).c_str(), human(h.max_value()).c_str());
+  }
+
+  void bench_lifetime(const options& opt)
+  {
+    auto iterations = opt.quick ? size_t(2000) : size_t(100000);
+
+    printf("\nshort lived timer, construct, start and destroy, %lu iterations\n", static_cast<unsigned long>(iterations));
+    printf("%-10s %10s %10s %10s %10s\n", "timer", "mean", "p50", "p99", "max");
+
+    // the storage is reused, so only the timer itself is measured
+    alignas(timer) unsigned char storage[sizeof(timer)];
+    auto deleter = [](timer* tm) { tm->~timer(); };
+
+    bench_lifetime("created", iterations, [&storage, &deleter] {
+        return std::unique_ptr<timer, decltype(deleter)>(new (&storage) timer(seconds(10), nanoseconds(0), nullptr,
+              nullptr, true, SIGRTMAX, CLOCK_MONOTONIC), deleter);
+      });
+
+    timer_pool pool(16);
+    bench_lifetime("pooled", iterations, [&storage, &deleter, &pool] {
+        return std::unique_ptr<timer, decltype(deleter)>(new (&storage) timer(pool, seconds(10), nanoseconds(0),
+              nullptr, nullptr, true), deleter);
+      });
+  }
+
+  struct counter
+  {
+    uint64_t _callbacks = 0;
+
+    static void expired(void* data)
+    {
+      static_cast<counter*>(data)->_callbacks++;
+    }
+  };
+
+  template <typename Make>
+  bool bench_scaling_row(const char* name, size_t n, nanoseconds period, nanoseconds run, Make make)
+  {
+    counter cnt;
+    deque<decltype(make(0, cnt))> owners;
+
+    auto t0 = now_ns();
+    try
+    {
+      for (size_t i = 0; i < n; i++)
+      {
+        owners.emplace_back(make(i, cnt));
+      }
+    }
+    catch (const system_error& e)
+    {
+      // POSIX timers are accounted against RLIMIT_SIGPENDING
+      printf("%-8s %8lu %s after %lu timers\n", name, static_cast<unsigned long>(n), e.what(),
+          static_cast<unsigned long>(owners.size()));
+      return false;
+    }
+    auto t1 = now_ns();
+    for (auto& tm : owners)
+    {
+      tm->start();
+    }
+    auto t2 = now_ns();
+
+    // half a period of margin, the expiry due at the very end of the run does not race the measurement
+    sleep_until(t2 + run.count() + period.count() / 2);
+    auto callbacks = cnt._callbacks;
+
+    auto t3 = now_ns();
+    owners.clear();
+    auto t4 = now_ns();
+
+    double expected = static_cast<double>(n) * run.count() / period.count();
+    printf("%-8s %8lu %10s %10s %10s %12.0f %8.1f%%\n", name, static_cast<unsigned long>(n),
+        human(static_cast<double>(t1 - t0) / n).c_str(), human(static_cast<double>(t2 - t1) / n).c_str(),
+        human(static_cast<double>(t4 - t3) / n).c_str(), callbacks * 1e9 / (t3 - t2),
+        expected > 0 ? 100.0 * callbacks / expected : 0.0);
+    return true;
+  }
+
+  void bench_scaling(const options& opt)
+  {
+    auto period = opt.quick ? milliseconds(100) : milliseconds(500);
+    auto run = opt.quick ? milliseconds(300) : milliseconds(2000);
+
+    printf("\nscaling with live timers, period %s, run %s\n", human(nanoseconds(period).count()).c_str(),
+        human(nanoseconds(run).count()).c_str());
+    printf("%-8s %8s %10s %10s %10s %12s %9s\n", "timer", "count", "create", "start", "destroy", "callbacks/s",
+        "delivered");
+
+    for (size_t n = 1; n <= opt.max_timers; n *= 10)
+    {
+      auto ok = bench_scaling_row("signal", n, period, run, [period](size_t, counter& cnt) {
+          return make_unique<timer>(seconds(0), nanoseconds(period), &counter::expired, &cnt);
+        });
+      if (!ok)
+      {
+        break;
+      }
+    }
+
+    for (size_t n = 1; n <= opt.max_timers; n *= 10)
+    {
+      timer_wheel wheel;
+      bench_scaling_row("wheel", n, period, run, [&wheel, period](size_t, counter& cnt) {
+          return make_unique<timer_wheel::timer>(wheel, seconds(0), nanoseconds(period), &counter::expired, &cnt);
+        });
+    }
+  }
+
+  double bench_sharding_run(size_t shards, size_t per_shard, nanoseconds run)
+  {
+    timer_service service(shards);
+    std::atomic<bool> running(true);
+    deque<unique_ptr<timer_service::timeout>> timeouts;
+
+    // every expiry re-arms its timeout at once, so a shard thread does nothing but expire and re-arm
+    for (size_t i = 0; i < shards * per_shard; i++)
+    {
+      timeouts.emplace_back(new timer_service::timeout(service, [&timeouts, &running](void* index) {
+          if (running.load(std::memory_order_relaxed))
+          {
+            timeouts[reinterpret_cast<size_t>(index)]->arm(nanoseconds(0));
+          }
+        }, reinterpret_cast<void*>(i), i % shards));
+    }
+
+    for (auto& to : timeouts)
+    {
+      to->arm(nanoseconds(0));
+    }
+    auto t0 = now_ns();
+    auto e0 = service.stats().expirations;
+    sleep_until(t0 + run.count());
+    auto expirations = service.stats().expirations - e0;
+    auto elapsed = now_ns() - t0;
+
+    // the callbacks running now see the flag before the timeouts go away
+    running.store(false);
+    std::this_thread::sleep_for(milliseconds(10));
+    timeouts.clear();
+
+    return 1e9 * static_cast<double>(expirations) / static_cast<double>(elapsed);
+  }
+
+  void bench_sharding(const options& opt)
+  {
+    constexpr size_t per_shard = 64;
+    auto run = opt.quick ? milliseconds(100) : milliseconds(1000);
+
+    // a single shard serialises the expiries like a single signal handler thread does
+    printf("\nsharded timer_service expiry throughput, %lu timeouts per thread, run %s, %u cores\n",
+        static_cast<unsigned long>(per_shard), human(nanoseconds(run).count()).c_str(),
+        std::max(std::thread::hardware_concurrency(), 1u));
+    printf("%8s %14s %14s %10s\n", "threads", "sharded/s", "one shard/s", "speedup");
+
+    for (size_t threads = 1; threads <= 64; threads *= 2)
+    {
+      auto sharded = bench_sharding_run(threads, per_shard, run);
+      auto single = bench_sharding_run(1, threads * per_shard, run);
+      printf("%8lu %14.0f %14.0f %9.2fx\n", static_cast<unsigned long>(threads), sharded, single,
+          single > 0 ? sharded / single : 0.0);
+    }
+  }
+
+  void bench_signalfd(const options& opt)
+  {
+    auto n = std::min<size_t>(opt.max_timers, 1000);
+    auto period = milliseconds(10);
+    auto run = opt.quick ? milliseconds(300) : milliseconds(2000);
+
+    printf("\nsignalfd batched delivery, %lu timers, period %s, run %s\n", static_cast<unsigned long>(n),
+        human(nanoseconds(period).count()).c_str(), human(nanoseconds(run).count()).c_str());
+    printf("%10s %10s %12s %10s\n", "delivered", "reads", "per read", "per call");
+
+    timer_signalfd sfd;
+    counter cnt;
+    deque<timer> timers;
+    for (size_t i = 0; i < n; i++)
+    {
+      timers.emplace_back(sfd, seconds(0), nanoseconds(period), &counter::expired, &cnt, false, CLOCK_MONOTONIC);
+      timers.back().start();
+    }
+
+    size_t delivered = 0;
+    int64_t busy = 0;
+    auto end = now_ns() + nanoseconds(run).count();
+    while (now_ns() < end)
+    {
+      // the wait is left out, only the reads and the callbacks are timed
+      struct pollfd pfd = {sfd.fd(), POLLIN, 0};
+      if (poll(&pfd, 1, static_cast<int>(period.count())) > 0)
+      {
+        auto t0 = now_ns();
+        delivered += sfd.dispatch();
+        busy += now_ns() - t0;
+      }
+    }
+
+    for (auto& tm : timers)
+    {
+      tm.try_stop();
+    }
+
+    printf("%10lu %10lu %12.1f %10s\n", static_cast<unsigned long>(delivered), static_cast<unsigned long>(sfd.reads()),
+        sfd.reads() ? static_cast<double>(delivered) / static_cast<double>(sfd.reads()) : 0.0,
+        human(delivered ? busy / static_cast<int64_t>(delivered) : 0).c_str());
+  }
+
+  void bench_uring(const options& opt)
+  {
+    auto n = std::min<size_t>(opt.max_timers, 1000);
+    auto period = milliseconds(10);
+    auto run = opt.quick ? milliseconds(300) : milliseconds(2000);
+
+    printf("\nio_uring timeouts, %lu timers, period %s, run %s\n", static_cast<unsigned long>(n),
+        human(nanoseconds(period).count()).c_str(), human(nanoseconds(run).count()).c_str());
+    printf("%10s %10s %12s %10s %14s\n", "delivered", "enters", "per enter", "per call", "start+stop");
+
+    timer_uring uring;
+    counter cnt;
+    deque<timer> timers;
+    for (size_t i = 0; i < n; i++)
+    {
+      timers.emplace_back(uring, seconds(0), nanoseconds(period), &counter::expired, &cnt);
+    }
+
+    // an arm cancelled before the flush never reaches the kernel
+    auto t0 = now_ns();
+    for (auto& tm : timers)
+    {
+      tm.start();
+      tm.stop();
+    }
+    auto pair = (now_ns() - t0) / static_cast<int64_t>(n);
+
+    for (auto& tm : timers)
+    {
+      tm.start();
+    }
+    // the arms are submitted in one batch, every dispatch below submits the periodic re-arms
+    uring.dispatch();
+
+    size_t delivered = 0;
+    int64_t busy = 0;
+    auto enters = uring.stats().enters;
+    auto end = now_ns() + nanoseconds(run).count();
+    while (now_ns() < end)
+    {
+      // the wait is left out, only the submissions, reaping and callbacks are timed
+      struct pollfd pfd = {uring.fd(), POLLIN, 0};
+      if (poll(&pfd, 1, static_cast<int>(period.count())) > 0)
+      {
+        auto t1 = now_ns();
+        delivered += uring.dispatch();
+        busy += now_ns() - t1;
+      }
+    }
+    enters = uring.stats().enters - enters;
+
+    for (auto& tm : timers)
+    {
+      tm.try_stop();
+    }
+    uring.dispatch();
+
+    printf("%10lu %10lu %12.1f %10s %14s\n", static_cast<unsigned long>(delivered), static_cast<unsigned long>(enters),
+        enters ? static_cast<double>(delivered) / static_cast<double>(enters) : 0.0,
+        human(delivered ? busy / static_cast<int64_t>(delivered) : 0).c_str(), human(pair).c_str());
+  }
+
+  void bench_realtime_row(const char* name, timer_dispatcher& dispatcher, nanoseconds run)
+  {
+    auto stats = dispatcher.self_test(run, milliseconds(1));
+    auto status = dispatcher.realtime();
+    auto mean = stats.lateness_total.count() / static_cast<int64_t>(stats.fires ? stats.fires : 1);
+
+    printf("%-10s %10lu %10lu %10s %10s %10s %10s   %c%c%c\n", name, static_cast<unsigned long>(stats.fires),
+        static_cast<unsigned long>(stats.overruns), human(mean).c_str(),
+        human(timer_stats::percentile(stats.lateness, 99).count()).c_str(),
+        human(timer_stats::percentile(stats.lateness, 99.9).count()).c_str(), human(stats.lateness_max.count()).c_str(),
+        status.pinned ? 'P' : '-', status.scheduled ? 'S' : '-', status.locked ? 'L' : '-');
+  }
+
+  void bench_realtime(const options& opt)
+  {
+    auto run = opt.quick ? milliseconds(500) : milliseconds(5000);
+
+    // percentiles are histogram bucket bounds, P pinned, S real-time scheduled, L memory locked
+    printf("\ndispatcher self test, period 1.00ms, run %s\n", human(nanoseconds(run).count()).c_str());
+    printf("%-10s %10s %10s %10s %10s %10s %10s %7s\n", "dispatcher", "fires", "overruns", "mean", "p99<", "p99.9<",
+        "max", "profile");
+
+    {
+      timer_dispatcher dispatcher;
+      bench_realtime_row("default", dispatcher, run);
+    }
+    {
+      timer_dispatcher::realtime_profile profile;
+      profile.cpus = {0};
+      timer_dispatcher dispatcher(profile);
+      bench_realtime_row("realtime", dispatcher, run);
+    }
+  }
+
+  double bench_trace_row(size_t n) noexcept
+  {
+    int id = 0;
+    auto t0 = now_ns();
+    for (size_t i = 0; i < n; i++)
+    {
+      POSIXCPP_TRACE(trace::event::expire, &id, i);
+    }
+    return static_cast<double>(now_ns() - t0) / static_cast<double>(n);
+  }
+
+  void bench_trace(const options& opt)
+  {
+    auto n = opt.quick ? size_t(1000000) : size_t(10000000);
+    char path[] = "/tmp/posixcpp-bench-trace-XXXXXX";
+
+    printf("\ntrace event cost, %lu events\n", static_cast<unsigned long>(n));
+    printf("%-10s %12s\n", "buffer", "per event");
+
+    printf("%-10s %10.1fns\n", "stopped", bench_trace_row(n));
+    trace::start();
+    printf("%-10s %10.1fns\n", "memory", bench_trace_row(n));
+
+    int fd = mkstemp(path);
+    if (fd != -1)
+    {
+      close(fd);
+      trace::start({8192, 64, path});
+      printf("%-10s %10.1fns\n", "file", bench_trace_row(n));
+      unlink(path);
+    }
+    trace::stop();
+  }
+
+  void bench_group(const options& opt)
+  {
+    // POSIX timers count against RLIMIT_SIGPENDING, stay well below the usual default
+    auto n = min<size_t>(opt.max_timers, 10000);
+    deque<timer> timers;
+    timer_group group;
+
+    for (size_t i = 0; i < n; i++)
+    {
+      timers.emplace_back(seconds(10));
+      group.add(timers.back());
+    }
+
+    printf("\ngroup operations, %lu timers\n", static_cast<unsigned long>(n));
+    printf("%-16s %12s %12s\n", "operation", "total", "per timer");
+
+    auto row = [n](const char* op, int64_t t0, int64_t t1) {
+        printf("%-16s %12s %12s\n", op, human(static_cast<double>(t1 - t0)).c_str(),
+            human(static_cast<double>(t1 - t0) / n).c_str());
+      };
+
+    auto t0 = now_ns();
+    for (auto& tm : timers)
+    {
+      tm.start();
+    }
+    auto t1 = now_ns();
+    for (auto& tm : timers)
+    {
+      tm.reset();
+    }
+    auto t2 = now_ns();
+    for (auto& tm : timers)
+    {
+      tm.stop();
+    }
+    auto t3 = now_ns();
+    row("start each", t0, t1);
+    row("reset each", t1, t2);
+    row("stop each", t2, t3);
+
+    t0 = now_ns();
+    group.start_all();
+    t1 = now_ns();
+    group.reset_all();
+    t2 = now_ns();
+    group.set_period_all(seconds(20));
+    t3 = now_ns();
+    group.stop_all();
+    auto t4 = now_ns();
+    row("start_all", t0, t1);
+    row("reset_all", t1, t2);
+    row("set_period_all", t2, t3);
+    row("stop_all", t3, t4);
+  }
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  options opt;
+
+  // results are useful even if a long run is interrupted
+  setvbuf(stdout, nullptr, _IOLBF, 0);
+
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--quick") == 0)
+    {
+      opt.quick = true;
+      opt.max_timers = min<size_t>(opt.max_timers, 1000);
+    }
+    else if (strcmp(argv[i], "--max-timers") == 0 && i + 1 < argc)
+    {
+      opt.max_timers = strtoul(argv[++i], nullptr, 10);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [--quick] [--max-timers N]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  bench_lateness(opt, timer::backend::signal);
+  bench_lateness(opt, timer::backend::timerfd);
+  bench_precision(opt);
+  bench_calls(opt);
+  bench_clocks(opt);
+  bench_timeouts(opt);
+  bench_lifetime(opt);
+  bench_scaling(opt);
+  bench_sharding(opt);
+  bench_group(opt);
+  bench_signalfd(opt);
+  bench_uring(opt);
+  bench_realtime(opt);
+  bench_trace(opt);
+
+  return 0;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+// C++ STL headers
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+// Local headers
+#include "inplace_function.h"
+
+namespace posixcpp
+{
+  /**
+   * Executor interface, runs tasks on behalf of the timers bound to it, see timer::set_executor.
+   */
+  class executor
+  {
+    public:
+    static constexpr std::size_t any = static_cast<std::size_t>(-1);   /**< no worker affinity */
+    static constexpr std::size_t task_capacity = 64;                   /**< maximum task size in bytes */
+    using task_t = inplace_function<void(), task_capacity>;            /**< task type, it never allocates */
+
+    virtual ~executor() = default;
+
+    /**
+     * Schedules *task*. It's called from the timer signal handler, so an implementation must be async-signal-safe.
+     *
+     * @param task    Task to run.
+     * @param worker  Index of the worker the task must run on, or executor::any.
+     * @return false if the task could not be queued, the caller runs it in place then.
+     */
+    virtual bool execute(task_t task, std::size_t worker = any) noexcept = 0;
+
+    /**
+     * @return number of tasks the executor can run in parallel
+     */
+    virtual std::size_t concurrency() const noexcept = 0;
+  }; // class executor
+
+  /**
+   * Work-stealing thread pool, the default posixcpp::executor.
+   *
+   * Every worker owns a bounded lock-free queue. Tasks without affinity are spread round robin over the workers and an
+   * idle worker steals queued tasks from the busy ones, so the expirations of many timers fan out across the cores
+   * and one slow callback does not delay the others. A task with affinity is kept in a separate queue of its worker
+   * and is never stolen. Queuing a task only touches atomics and posts a semaphore to wake a sleeping worker up, it's
+   * async-signal-safe.
+   *
+   * The executor must outlive the timers bound to it. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class work_stealing_executor : public executor
+  {
+    class work_stealing_executor_;                      /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<work_stealing_executor_> _executor; /**< pointer to PIMPL work_stealing_executor_ object */
+
+    public:
+    /**
+     * @brief The explicit work_stealing_executor constructor, it starts the worker threads.
+     *
+     * @param workers     Number of worker threads, by default one per core.
+     * @param queue_size  Capacity of every worker queue.
+     * @param pin         Pins worker i to core i modulo the number of cores.
+     */
+    explicit work_stealing_executor(std::size_t workers = std::thread::hardware_concurrency(),
+        std::size_t queue_size = 1024, bool pin = true);
+
+    ~work_stealing_executor() override;
+
+    work_stealing_executor(const work_stealing_executor&) = delete;
+    work_stealing_executor(work_stealing_executor&&) = delete;
+    work_stealing_executor& operator=(const work_stealing_executor&) = delete;
+    work_stealing_executor& operator=(work_stealing_executor&&) = delete;
+
+    bool execute(task_t task, std::size_t worker = any) noexcept override;
+    std::size_t concurrency() const noexcept override;
+
+    /**
+     * @return number of tasks run by a worker other than the one they were queued to
+     */
+    std::uint64_t stolen() const noexcept;
+
+    /**
+     * @return number of tasks rejected because the queues were full
+     */
+    std::uint64_t rejected() const noexcept;
+  }; // class work_stealing_executor
+
+} // namespace posixcpp
@@ -0,0 +1,180 @@
+#pragma once
+
+// C++ STL headers
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace posixcpp
+{
+  template <typename Signature, std::size_t Capacity = 64>
+  class inplace_function;
+
+  /**
+   * Small buffer, fixed capacity replacement for std::function.
+   *
+   * The callable is always stored inside the object, so constructing, copying and calling an inplace_function never
+   * allocates. A callable bigger than *Capacity* bytes is rejected at compile time. A null function pointer or an
+   * empty std::function result in an empty inplace_function.
+   */
+  template <typename R, typename... Args, std::size_t Capacity>
+  class inplace_function<R(Args...), Capacity>
+  {
+    enum class operation
+    {
+      copy,
+      move,
+      destroy
+    };
+
+    using invoke_t = R (*)(void* callable, Args... args);
+    using manage_t = void (*)(operation op, void* dst, void* src);
+
+    alignas(std::max_align_t) unsigned char _storage[Capacity];
+    invoke_t _invoke;
+    manage_t _manage;
+
+    template <typename F>
+    static R invoke(void* callable, Args... args)
+    {
+      return (*static_cast<F*>(callable))(std::forward<Args>(args)...);
+    }
+
+    template <typename F>
+    static void manage(operation op, void* dst, void* src)
+    {
+      switch (op)
+      {
+        case operation::copy:
+          new (dst) F(*static_cast<const F*>(src));
+          break;
+        case operation::move:
+          new (dst) F(std::move(*static_cast<F*>(src)));
+          break;
+        case operation::destroy:
+          static_cast<F*>(dst)->~F();
+          break;
+      }
+    }
+
+    template <typename F>
+    static bool is_null(const F& f) noexcept
+    {
+      if constexpr (std::is_pointer<F>::value || std::is_member_pointer<F>::value)
+      {
+        return f == nullptr;
+      }
+      else if constexpr (std::is_same<F, std::function<R(Args...)>>::value)
+      {
+        return !f;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    public:
+    static constexpr std::size_t capacity = Capacity;
+
+    inplace_function() noexcept :
+      _invoke(nullptr),
+      _manage(nullptr)
+    {}
+
+    inplace_function(std::nullptr_t) noexcept :
+      inplace_function()
+    {}
+
+    template <typename F, typename C = typename std::decay<F>::type,
+             typename = typename std::enable_if<!std::is_same<C, inplace_function>::value>::type,
+             typename = typename std::enable_if<std::is_invocable_r<R, C&, Args...>::value>::type>
+    inplace_function(F&& f) :
+      inplace_function()
+    {
+      static_assert(sizeof(C) <= Capacity, "callable does not fit into inplace_function capacity");
+      static_assert(alignof(C) <= alignof(std::max_align_t), "callable alignment is not supported");
+
+      if (is_null(f))
+      {
+        return;
+      }
+
+      new (_storage) C(std::forward<F>(f));
+      _invoke = &invoke<C>;
+      _manage = &manage<C>;
+    }
+
+    inplace_function(const inplace_function& other) :
+      _invoke(other._invoke),
+      _manage(other._manage)
+    {
+      if (_manage)
+      {
+        _manage(operation::copy, _storage, const_cast<unsigned char*>(other._storage));
+      }
+    }
+
+    inplace_function(inplace_function&& other) noexcept :
+      _invoke(other._invoke),
+      _manage(other._manage)
+    {
+      if (_manage)
+      {
+        _manage(operation::move, _storage, other._storage);
+      }
+    }
+
+    ~inplace_function()
+    {
+      if (_manage)
+      {
+        _manage(operation::destroy, _storage, nullptr);
+      }
+    }
+
+    inplace_function& operator=(const inplace_function& other)
+    {
+      // a throwing copy of the callable leaves this function untouched
+      inplace_function copy(other);
+      return *this = std::move(copy);
+    }
+
+    inplace_function& operator=(inplace_function&& other) noexcept
+    {
+      if (this != &other)
+      {
+        this->~inplace_function();
+        new (this) inplace_function(std::move(other));
+      }
+      return *this;
+    }
+
+    R operator()(Args... args) const
+    {
+      if (!_invoke)
+      {
+        throw std::bad_function_call();
+      }
+      return _invoke(const_cast<unsigned char*>(_storage), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const noexcept
+    {
+      return _invoke != nullptr;
+    }
+
+    friend bool operator==(const inplace_function& f, std::nullptr_t) noexcept
+    {
+      return !f;
+    }
+
+    friend bool operator!=(const inplace_function& f, std::nullptr_t) noexcept
+    {
+      return static_cast<bool>(f);
+    }
+  }; // class inplace_function
+
+} // namespace posixcpp
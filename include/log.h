@@ -0,0 +1,244 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <system_error>
+#include <type_traits>
+
+// Linux system headers
+#include <syslog.h>
+
+/**
+ * Compile time log threshold, syslog priorities above it compile away completely, arguments are not even evaluated.
+ * Release builds keep errors and warnings only, debug builds keep informational messages as well. Per expiry
+ * messages are logged with LOG_DEBUG, define POSIXCPP_LOG_LEVEL=LOG_DEBUG to see them.
+ */
+#ifndef POSIXCPP_LOG_LEVEL
+#ifdef NDEBUG
+#define POSIXCPP_LOG_LEVEL LOG_WARNING
+#else
+#define POSIXCPP_LOG_LEVEL LOG_INFO
+#endif
+#endif
+
+/**
+ * Logs a printf like message with syslog priority *lvl* through the current posixcpp::log::sink.
+ * The message is not formatted at the call site, *fmt* and string arguments must be string literals or have static
+ * storage duration. A std::error_code argument is printed with its message for %s.
+ */
+#define POSIXCPP_LOG(lvl, fmt, ...) \
+  do \
+  { \
+    if constexpr ((lvl) <= POSIXCPP_LOG_LEVEL) \
+    { \
+      ::posixcpp::log::write((lvl), (fmt), ##__VA_ARGS__); \
+    } \
+  } while (0)
+
+namespace posixcpp
+{
+  namespace log
+  {
+    static constexpr std::size_t max_args = 6;  /**< maximum number of arguments of a single message */
+
+    /**
+     * Unformatted message argument
+     */
+    struct arg
+    {
+      enum class type : unsigned char
+      {
+        integer,
+        unsigned_integer,
+        pointer,
+        string,
+        error
+      };
+
+      type _type;
+      union
+      {
+        long long _integer;
+        unsigned long long _unsigned;
+        const void* _pointer;
+        const char* _string;
+        const std::error_category* _category;
+      };
+      int _code;                                /**< error code value for type::error */
+    };
+
+    /**
+     * Fixed size, unformatted log message. Records are formatted only when a sink writes them out.
+     */
+    struct record
+    {
+      int _level;                               /**< syslog priority */
+      const char* _format;
+      std::uint64_t _timestamp;                 /**< CLOCK_REALTIME nanoseconds */
+      std::size_t _argc;
+      arg _args[max_args];
+    };
+
+    /**
+     * Log sink interface, *write* might be called in signal context and must not block.
+     */
+    class sink
+    {
+      public:
+      virtual ~sink() = default;
+      virtual void write(const record& r) noexcept = 0;
+    };
+
+    /**
+     * Formats the record into *buf*, a printf subset is supported: %d, %i, %u, %x, %X, %p, %s and %%, with the h, l,
+     * ll and z length modifiers.
+     *
+     * @return number of characters written, without the terminating zero
+     */
+    std::size_t format(const record& r, char* buf, std::size_t size) noexcept;
+
+    /**
+     * Formats every record and passes it to syslog synchronously.
+     */
+    class syslog_sink : public sink
+    {
+      public:
+      void write(const record& r) noexcept override;
+    };
+
+    /**
+     * Lock-free in-memory ring of unformatted records. Writing only copies the record into the ring, it's safe in
+     * signal context and from any number of threads. The records are formatted and passed to syslog by
+     * ring_sink::drain, which a background thread calls every *drain_interval*. When the ring is full new records are
+     * dropped and counted.
+     */
+    class ring_sink : public sink
+    {
+      class ring_sink_;                         /**< Forward class reference to PIMPL implementation */
+      std::shared_ptr<ring_sink_> _sink;        /**< pointer to PIMPL ring_sink_ object */
+
+      public:
+      /**
+       * @param capacity        Number of records the ring can hold, rounded up to a power of two.
+       * @param drain_interval  Background thread drain period, 0 disables the thread and ring_sink::drain has to be
+       *                        called by the user.
+       */
+      explicit ring_sink(std::size_t capacity = 4096,
+          std::chrono::milliseconds drain_interval = std::chrono::milliseconds(100));
+
+      ~ring_sink() override;
+
+      ring_sink(const ring_sink&) = delete;
+      ring_sink(ring_sink&&) = delete;
+      ring_sink& operator=(const ring_sink&) = delete;
+      ring_sink& operator=(ring_sink&&) = delete;
+
+      void write(const record& r) noexcept override;
+
+      /**
+       * Moves all pending records to syslog.
+       *
+       * @return number of records drained
+       */
+      std::size_t drain() noexcept;
+
+      /**
+       * Moves all pending records to *to*.
+       *
+       * @return number of records drained
+       */
+      std::size_t drain(sink& to) noexcept;
+
+      /**
+       * @return number of records dropped because the ring was full
+       */
+      std::uint64_t dropped() const noexcept;
+    };
+
+    /**
+     * Installs the sink all posixcpp messages are written to, nullptr restores the default one. The sink must
+     * outlive its use.
+     */
+    void set_sink(sink* s) noexcept;
+
+    /**
+     * Creates the default sink and its drain thread unless they exist already. It's created on first use, so a process
+     * which never logs has no drain thread; every signal handler installer calls this first, so it's never created
+     * from a signal handler.
+     */
+    void prepare_default_sink() noexcept;
+
+    /**
+     * @return the current sink, by default a process wide ring_sink drained to syslog, created on first use
+     */
+    sink& current_sink() noexcept;
+
+    template <typename T>
+    inline arg make_arg(const T& value) noexcept
+    {
+      arg a{};
+
+      if constexpr (std::is_same<T, std::error_code>::value)
+      {
+        a._type = arg::type::error;
+        a._category = &value.category();
+        a._code = value.value();
+      }
+      else if constexpr (std::is_same<typename std::decay<T>::type, const char*>::value ||
+          std::is_same<typename std::decay<T>::type, char*>::value)
+      {
+        a._type = arg::type::string;
+        a._string = value;
+      }
+      else if constexpr (std::is_pointer<T>::value)
+      {
+        a._type = arg::type::pointer;
+        a._pointer = value;
+      }
+      else if constexpr (std::is_enum<T>::value)
+      {
+        a._type = arg::type::integer;
+        a._integer = static_cast<long long>(value);
+      }
+      else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value)
+      {
+        a._type = arg::type::integer;
+        a._integer = value;
+      }
+      else
+      {
+        static_assert(std::is_integral<T>::value, "unsupported log argument type");
+        a._type = arg::type::unsigned_integer;
+        a._unsigned = value;
+      }
+
+      return a;
+    }
+
+    template <typename... Args>
+    inline void write(int level, const char* format, const Args&... args) noexcept
+    {
+      static_assert(sizeof...(Args) <= max_args, "too many log arguments");
+
+      struct timespec ts;
+      clock_gettime(CLOCK_REALTIME, &ts);
+
+      record r;
+      r._level = level;
+      r._format = format;
+      r._timestamp = static_cast<std::uint64_t>(ts.tv_sec) * 1000000000 + static_cast<std::uint64_t>(ts.tv_nsec);
+      r._argc = sizeof...(Args);
+
+      std::size_t i = 0;
+      ((r._args[i++] = make_arg(args)), ...);
+      (void)i;
+
+      current_sink().write(r);
+    }
+
+  } // namespace log
+} // namespace posixcpp
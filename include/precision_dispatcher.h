@@ -0,0 +1,69 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <csignal>
+#include <memory>
+
+namespace posixcpp
+{
+  /**
+   * Dedicated thread delivering high precision timer expirations.
+   *
+   * Signal delivery and scheduler wakeup add tens of microseconds of jitter to every expiration. A timer constructed
+   * with a precision_dispatcher is armed *spin window* ahead of each deadline, its signal is targeted at the
+   * dispatcher thread (SIGEV_THREAD_ID) and received there with sigwaitinfo, then the thread spins on the vDSO
+   * clock_gettime until the exact deadline and runs the callback in place. The wakeup jitter is absorbed as long as
+   * it stays within the spin window, at the price of burning the CPU for the rest of the window.
+   *
+   * The thread can be pinned to a core so the spinning does not compete with other work. The callbacks of all
+   * precision timers share the thread, they must be short and a slow one delays the others. The lateness and the
+   * time spent spinning are reported per timer by timer::stats, see timer_stats::spin_total. The slack of a precision
+   * timer is ignored. The dispatcher must outlive all of its timers.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  class precision_dispatcher
+  {
+    friend class timer;
+
+    class precision_dispatcher_;              /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<precision_dispatcher_> _dispatcher; /**< pointer to PIMPL precision_dispatcher_ object */
+
+    public:
+    static constexpr int any_cpu = -1;
+
+    /**
+     * @brief The explicit precision_dispatcher constructor, it starts the dispatcher thread.
+     *
+     * @param spin_window Time the timers are armed ahead of their deadlines and spun out, should cover the wakeup
+     *                    jitter of the system.
+     * @param cpu         Core the thread is pinned to, any_cpu leaves it unpinned.
+     * @param sig         Signal targeted at the dispatcher thread, by default it's **SIGRTMAX**.
+     */
+    explicit precision_dispatcher(std::chrono::nanoseconds spin_window = std::chrono::microseconds(50),
+        int cpu = any_cpu, int sig = SIGRTMAX);
+
+    ~precision_dispatcher();
+
+    precision_dispatcher(const precision_dispatcher&) = delete;
+    precision_dispatcher(precision_dispatcher&&) = delete;
+    precision_dispatcher& operator=(const precision_dispatcher&) = delete;
+    precision_dispatcher& operator=(precision_dispatcher&&) = delete;
+
+    /**
+     * Changes the spin window, it takes effect from the next deadline of every timer.
+     */
+    void set_spin_window(std::chrono::nanoseconds spin_window) noexcept;
+
+    std::chrono::nanoseconds spin_window() const noexcept;
+
+    /**
+     * @return the core the thread is pinned to, or any_cpu
+     */
+    int cpu() const noexcept;
+  }; // class precision_dispatcher
+
+} // namespace posixcpp
@@ -0,0 +1,126 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Local headers
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Timeouts optimised for the cancel before fire case, e.g. RPC deadlines.
+   *
+   * Arming and cancelling a timeout are user space operations on an intrusive handle: a cancel only marks the handle,
+   * and re-arming a queued handle to a later deadline only updates it; the stale queue entry is dropped or moved when
+   * it reaches the head of the queue (lazy deletion). The kernel timer is re-programmed only when the earliest
+   * deadline moves ahead of the programmed wakeup, so a steady arm and cancel workload costs no syscall at all.
+   *
+   * The wakeups are aligned to a grid of *slack*, so many lazily deleted entries are dropped by a single wakeup; a
+   * timeout fires at most *slack* after its deadline plus the scheduling latency. The deadlines are measured with
+   * posixcpp::tsc_clock. The callbacks run on the manager thread without the manager lock, they may arm, cancel and
+   * destroy any timeout; destroying a timeout from another thread while its callback runs waits for the callback.
+   *
+   * The operations take a short user space lock, use one manager per core for the best scaling. The manager must
+   * outlive all of its timeouts. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timeout_manager
+  {
+    class timeout_manager_;                   /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timeout_manager_> _manager; /**< pointer to PIMPL timeout_manager_ object */
+
+    public:
+    using callback_t = posixcpp::timer::callback_t;    /**< User provided callback function type*/
+
+    /**
+     * Activity counters of a manager, see timeout_manager::stats
+     */
+    struct counters
+    {
+      std::uint64_t arms;                     /**< arm calls */
+      std::uint64_t cancels;                  /**< cancel calls which cancelled an armed timeout */
+      std::uint64_t expirations;              /**< timeouts fired */
+      std::uint64_t wakeups;                  /**< wakeups of the manager thread */
+      std::uint64_t settimes;                 /**< kernel timer re-programming */
+    };
+
+    /**
+     * Intrusive timeout handle, reusable for any number of arm and cancel cycles.
+     *
+     * It is not:
+     * - copyable;
+     * - movable;
+     */
+    class timeout
+    {
+      friend class timeout_manager::timeout_manager_;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      timeout_manager_& _manager;
+      callback_t _callback;
+      void* _data;
+      std::int64_t _deadline;                 /**< tsc_clock nanoseconds, 0 when not armed */
+      std::int64_t _key;                      /**< deadline the queue entry is ordered by, at most _deadline */
+      std::size_t _index;                     /**< position in the queue, npos when not queued */
+
+      public:
+      /**
+       * @brief The explicit timeout constructor.
+       *
+       * @param manager   The manager driving this timeout, it must outlive the timeout.
+       * @param callback  User specified callback function, which is called when the timeout fires.
+       * @param data      User specified pointer passed as argument to the callback function.
+       */
+      explicit timeout(timeout_manager& manager, callback_t callback = nullptr, void* data = nullptr);
+
+      ~timeout();
+
+      timeout(const timeout&) = delete;
+      timeout(timeout&&) = delete;
+      timeout& operator=(const timeout&) = delete;
+      timeout& operator=(timeout&&) = delete;
+
+      /**
+       * Arms the timeout to fire after *duration*, an armed timeout is re-armed.
+       */
+      void arm(std::chrono::nanoseconds duration);
+
+      /**
+       * @return true if an armed timeout was cancelled, false if it was not armed or has already fired
+       */
+      bool cancel() noexcept;
+
+      bool armed() const noexcept;
+    }; // class timeout
+
+    /**
+     * @brief The explicit timeout_manager constructor, it starts the manager thread.
+     *
+     * @param slack  Wakeup grid, timeouts fire at most this late.
+     */
+    explicit timeout_manager(std::chrono::nanoseconds slack = std::chrono::milliseconds(1));
+
+    ~timeout_manager();
+
+    timeout_manager(const timeout_manager&) = delete;
+    timeout_manager(timeout_manager&&) = delete;
+    timeout_manager& operator=(const timeout_manager&) = delete;
+    timeout_manager& operator=(timeout_manager&&) = delete;
+
+    std::chrono::nanoseconds slack() const noexcept;
+
+    /**
+     * @return the number of armed timeouts
+     */
+    std::size_t size() const noexcept;
+
+    counters stats() const noexcept;
+  }; // class timeout_manager
+
+} // namespace posixcpp
@@ -1,30 +1,99 @@
 // C++ STL headers
 #include <csignal>
 #include <chrono>
+#include <ctime>
+#include <cstddef>
+#include <cstdint>
 #include <ratio>
 #include <memory>
 #include <functional>
-#include <map>
 #include <system_error>
 
+// Local headers
+#include "executor.h"
+#include "inplace_function.h"
+#include "timer_registry.h"
+
 #pragma once
 namespace posixcpp {
 
+  class precision_dispatcher;
+  class timer_dispatcher;
+  class timer_group;
+  class timer_pool;
+  class timer_signalfd;
+  class timer_uring;
+  class virtual_clock;
+
   /**
    * C++17 wrapper for POSIX Interval Timer API.
    *
+   * Constructing a timer never allocates: the implementation object lives inside the timer itself and the callback is
+   * stored in a fixed capacity inplace_function.
+   *
+   * The timer state (idle, armed, suspended, expired) is an atomic updated by the operations and by the expiry path,
+   * so checking it costs no syscall. start, reset, suspend, resume and stop may be called from any thread and from
+   * the callback. They are lock-free: an operation racing another one on the same timer never waits for it, it
+   * fails with the timer::error::operation_in_progress warning instead.
+   *
    * It is not:
-   * - thread safe;
    * - copyable;
    * - movable;
    */
   class timer {
 
+    friend class precision_dispatcher;
+    friend class timer_dispatcher;
+    friend class timer_group;
+    friend class timer_pool;
+    friend class timer_registry;
+    friend class timer_signalfd;
+    friend class timer_uring;
+    friend class virtual_clock;
+
     class timer_;                             /**< Forward class reference to PIMPL implementation */
-    std::shared_ptr<timer_> _timer; /**< pointer to PIMPL timer_ object */
+    static constexpr std::size_t impl_size = 1024; /**< storage reserved for the PIMPL timer_ object */
+    alignas(64) unsigned char _storage[impl_size]; /**< in-place storage of the PIMPL timer_ object, cache line aligned */
+    timer_* _timer;                           /**< pointer to PIMPL timer_ object, constructed in _storage */
 
     public:
-    using callback_t = std::function<void(void*)>; /**< User provided callback function type*/
+    static constexpr std::size_t callback_capacity = 64; /**< maximum size of the callback function object */
+    using callback_t = inplace_function<void(void*), callback_capacity>; /**< User provided callback function type*/
+
+    /**
+     * Defines how the timer expiration is delivered to the user
+     */
+    enum class backend : int
+    {
+      signal,                                 /**< POSIX timer, callback is called from the signal handler */
+      timerfd                                 /**< Linux timerfd, callback is called by timer::dispatch */
+    };
+
+    /**
+     * Defines how the expirations coalesced by the kernel are delivered to the user callback
+     */
+    enum class overrun_policy : int
+    {
+      coalesce,                               /**< callback is called once per delivery, see timer::expirations */
+      catch_up                                /**< callback is called once per elapsed period in a tight batch */
+    };
+
+    /**
+     * Process wide accounting of the timers with slack, see timer::set_slack
+     */
+    struct coalescing_stats
+    {
+      std::uint64_t expirations;              /**< expirations of timers with slack, i.e. wakeups without coalescing */
+      std::uint64_t wakeups;                  /**< distinct wakeup instants these expirations were delivered at */
+
+      /**
+       * @return number of wakeups saved by coalescing
+       */
+      std::uint64_t saved() const noexcept
+      {
+        return expirations > wakeups ? expirations - wakeups : 0;
+      }
+    };
 
     /**
      * Defines all error codes for the timer class implementation
@@ -32,6 +101,15 @@ namespace posixcpp {
     enum class error : int
     {
       // critical errors, decrease negative number to add a new error
+      trace_failed = -15,                     /**< The trace buffer could not be mapped */
+      uring_failed = -14,                     /**< Linux io_uring setup or io_uring_enter call has failed */
+      realtime_setup_failed = -13,            /**< The timer_dispatcher real-time profile could not be applied */
+      signalfd_failed = -12,                  /**< Linux signalfd function call or reading the descriptor has failed */
+      pool_exhausted = -11,                   /**< All kernel timers of the timer_pool are in use */
+      posix_clock_gettime = -10,              /**< POSIX clock_gettime function call has failed */
+      epoll_failed = -9,                      /**< epoll_create1, epoll_ctl or epoll_wait call has failed */
+      posix_timerfd_read = -8,                /**< reading the timerfd expiration counter has failed */
+      posix_timerfd_creation = -7,            /**< Linux timerfd_create function call has failed */
       posix_timer_creation = -6,              /**< POSIX timer_create function call has failed */
       memcpy_failed = -5,                     /**< C-stdlib memcpy function call has failed */
       posix_timer_gettime = -4,               /**< POSIX timer_gettime function call has failed */
@@ -45,7 +123,8 @@ namespace posixcpp {
       start_already_started = 3,              /**< User's attempt to start timer which is already running */
       resume_already_running = 4,             /**< User's attempt to resume timer which is already running */
       stop_while_not_running = 5,             /**< User's attempt to stop timer which is not running */
-      suspend_while_not_running = 6           /**< User's attempt to suspend timer which is not running */
+      suspend_while_not_running = 6,          /**< User's attempt to suspend timer which is not running */
+      operation_in_progress = 7               /**< Another thread is starting, stopping or suspending the timer */
     };
 
     /**
@@ -65,32 +144,58 @@ namespace posixcpp {
       }
 
       /**
-       * Overridden method return error message string for the given error from timer::error enum
+       * Returns the static message of the given error from timer::error enum, without any allocation
+       *
+       * @return  "Unknown error" for a code out of the enum
        */
-      std::string message(int err) const override
+      static constexpr const char* describe(int err) noexcept
       {
-        static std::map<int, std::string> err2str =
+        // indexed by err - first, 0 is not an error
+        constexpr int first = static_cast<int>(error::trace_failed);
+        constexpr const char* messages[] =
         {
-          {static_cast<int>(error::posix_timer_creation), "POSIX timer_create has failed"},
-          {static_cast<int>(error::memcpy_failed), "std::memcpy has failed"},
-          {static_cast<int>(error::posix_timer_gettime), "POSIX timer_gettime has failed"},
-          {static_cast<int>(error::posix_timer_settime), "POSIX timer_settime has failed"},
-          {static_cast<int>(error::signal_handler_registration), "SYSTEM sigaction has failed"},
-          {static_cast<int>(error::unknown_error), "unknown error"},
-          {static_cast<int>(error::signal_handler_timer_null_pointer), "signal_handler timer pointer is null"},
-          {static_cast<int>(error::signal_handler_unexpected_signal), "signal_handler unexpected signal"},
-          {static_cast<int>(error::start_already_started), "an attempt to start already running timer"},
-          {static_cast<int>(error::resume_already_running), "an attempt to resume already running timer"},
-          {static_cast<int>(error::stop_while_not_running), "an attempt to stop already stopped timer "},
-          {static_cast<int>(error::suspend_while_not_running), "an attempt to stop already stopped timer "}
+          "trace buffer could not be mapped",
+          "io_uring has failed",
+          "real-time profile could not be applied",
+          "signalfd has failed",
+          "timer_pool has no free kernel timer",
+          "POSIX clock_gettime has failed",
+          "epoll has failed",
+          "timerfd read has failed",
+          "timerfd_create has failed",
+          "POSIX timer_create has failed",
+          "std::memcpy has failed",
+          "POSIX timer_gettime has failed",
+          "POSIX timer_settime has failed",
+          "SYSTEM sigaction has failed",
+          "unknown error",
+          nullptr,
+          "signal_handler timer pointer is null",
+          "signal_handler unexpected signal",
+          "an attempt to start already running timer",
+          "an attempt to resume already running timer",
+          "an attempt to stop already stopped timer ",
+          "an attempt to stop already stopped timer ",
+          "another operation on the timer is in progress"
         };
+        static_assert(sizeof(messages) / sizeof(messages[0]) ==
+            static_cast<std::size_t>(static_cast<int>(error::operation_in_progress) - first + 1),
+            "every timer::error needs a message");
 
-        if (!err2str.count(err))
+        if (err < first || err - first >= static_cast<int>(sizeof(messages) / sizeof(messages[0])) ||
+            !messages[err - first])
         {
-          return std::string("Unknown error");
+          return "Unknown error";
         }
+        return messages[err - first];
+      }
 
-        return err2str[err];
+      /**
+       * Overridden method return error message string for the given error from timer::error enum
+       */
+      std::string message(int err) const override
+      {
+        return describe(err);
       }
 
 
@@ -124,9 +229,13 @@ namespace posixcpp {
      *
      * @sa timer::suspend,  timer::stop.
      *
-     * The last parameter *sig* specified signal can be used by POSIX library when the timer expires. By default it's
+     * The parameter *sig* specified signal can be used by POSIX library when the timer expires. By default it's
      * **SIGRTMAX**.
      *
+     * The last parameter *clock* selects the clock the timer is measured against. By default it's **CLOCK_REALTIME**,
+     * which is affected by NTP steps and settime calls, prefer **CLOCK_MONOTONIC** or **CLOCK_BOOTTIME** for periodic
+     * work. **CLOCK_TAI** and the **\*_ALARM** variants are accepted as well, the latter need CAP_WAKE_ALARM.
+     *
      * @param period_sec      First part of timeout period in seconds, use literal 's' for std::chrono::seconds.
      * @param period_nsec     Second part of timeout period in nanoseconds, use literal 'ns' for
      *                        std::chrono::nanoseconds.
@@ -136,11 +245,145 @@ namespace posixcpp {
      * @param is_single_shot  If this argument is true, then timer runs only once 
      * @param sig             It sets up the signal used by POSIX library, this signal is risen in the context of user
      *                        process.
+     * @param clock           Clock the timer is measured against.
      */
     explicit timer(std::chrono::seconds period_sec,
         std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
         callback_t callback = nullptr, void* data = nullptr,
-        bool is_single_shot = false, int sig = SIGRTMAX
+        bool is_single_shot = false, int sig = SIGRTMAX,
+        clockid_t clock = CLOCK_REALTIME
+        );
+
+    /**
+     * @brief The explicit timer constructor with selectable expiration delivery.
+     * With backend::signal it's identical to the constructor above using **SIGRTMAX**.
+     * With backend::timerfd no signal is involved, the timer exposes a pollable file descriptor, see timer::fd, and
+     * the callback is called from timer::dispatch in the caller's thread.
+     *
+     * @param be              Expiration delivery backend.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     * @param clock           Clock the timer is measured against.
+     */
+    explicit timer(backend be, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false, clockid_t clock = CLOCK_REALTIME
+        );
+
+    /**
+     * @brief The explicit timer constructor for the dispatcher thread delivery.
+     * The expiration signal is targeted at the dispatcher thread only and the callback is called on one of the
+     * dispatcher worker threads, see posixcpp::timer_dispatcher.
+     *
+     * @param dispatcher      Dispatcher delivering the expirations, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     * @param clock           Clock the timer is measured against.
+     */
+    explicit timer(timer_dispatcher& dispatcher, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false, clockid_t clock = CLOCK_REALTIME
+        );
+
+    /**
+     * @brief The explicit timer constructor for the precision mode.
+     * The timer is armed a spin window ahead of every deadline and the dispatcher thread spins until the exact
+     * deadline before calling the callback, see posixcpp::precision_dispatcher.
+     *
+     * @param dispatcher      Dispatcher delivering the expirations, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     * @param clock           Clock the timer is measured against.
+     */
+    explicit timer(precision_dispatcher& dispatcher, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false, clockid_t clock = CLOCK_REALTIME
+        );
+
+    /**
+     * @brief The explicit timer constructor for a pre-created kernel timer.
+     * The timer takes a kernel timer from the pool instead of creating one, it uses the pool clock and signal, see
+     * posixcpp::timer_pool. It throws timer::error::pool_exhausted when the pool has no free kernel timer.
+     *
+     * @param pool            Pool providing the kernel timer, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     */
+    explicit timer(timer_pool& pool, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false
+        );
+
+    /**
+     * @brief The explicit timer constructor for the signalfd delivery.
+     * The expiration signal is targeted at the thread owning the timer_signalfd, where it stays blocked, and the
+     * callback is called from timer_signalfd::dispatch, see posixcpp::timer_signalfd.
+     *
+     * @param signalfd        signalfd delivering the expirations, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     * @param clock           Clock the timer is measured against.
+     */
+    explicit timer(timer_signalfd& signalfd, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false, clockid_t clock = CLOCK_REALTIME
+        );
+
+    /**
+     * @brief The explicit timer constructor for the io_uring timeout delivery.
+     * No kernel timer is created, the timer is armed and cancelled by submission entries of the ring and the callback
+     * is called from timer_uring::dispatch or timer_uring::complete, see posixcpp::timer_uring.
+     *
+     * @param uring           timer_uring delivering the expirations, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     * @param clock           CLOCK_MONOTONIC, CLOCK_BOOTTIME or CLOCK_REALTIME.
+     */
+    explicit timer(timer_uring& uring, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false, clockid_t clock = CLOCK_MONOTONIC
+        );
+
+    /**
+     * @brief The explicit timer constructor for the simulated time.
+     * No kernel timer is created, the timer runs on the virtual time and the callback is called from
+     * virtual_clock::advance, see posixcpp::virtual_clock. The timer reports CLOCK_MONOTONIC as its clock.
+     *
+     * @param clock           virtual_clock driving the timer, it must outlive the timer.
+     * @param period_sec      First part of timeout period in seconds.
+     * @param period_nsec     Second part of timeout period in nanoseconds.
+     * @param callback        User specified callback function, which is called when timer expires.
+     * @param data            User specified pointer passed as argument to the callback function.
+     * @param is_single_shot  If this argument is true, then timer runs only once
+     */
+    explicit timer(virtual_clock& clock, std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+        callback_t callback = nullptr, void* data = nullptr,
+        bool is_single_shot = false
         );
 
     ~timer();
@@ -151,6 +394,20 @@ namespace posixcpp {
     timer& operator=(timer&&) = delete;
 
     void start();
+
+    /**
+     * Phase locked start. The timer expires at *epoch* + k * period, where *epoch* is an absolute time of the timer
+     * clock and k is the smallest number giving a deadline in the future. The timer is armed with TIMER_ABSTIME, so
+     * the call latency does not shift the phase and no jitter accumulates over time. The timer stays phase locked
+     * after reset and resume, which re-arm it at the next deadline of the same grid.
+     *
+     * @param epoch   time since the timer clock epoch, as returned by clock_gettime.
+     */
+    void start_at(std::chrono::nanoseconds epoch);
+
+    /**
+     * Restarts a running, suspended or expired timer with a single settime, the previous expiry is replaced in place.
+     */
     void reset();
 
     /**
@@ -165,11 +422,104 @@ namespace posixcpp {
      */
     void stop();
 
+    /**
+     * Non throwing variants of the calls above, the core of the throwing ones. A warning such as
+     * timer::error::stop_while_not_running is just returned, a critical error is logged as well.
+     *
+     * @return  an empty std::error_code on success
+     */
     std::error_code try_start() noexcept;
+    std::error_code try_start_at(std::chrono::nanoseconds epoch) noexcept;
     std::error_code try_reset() noexcept;
     std::error_code try_suspend() noexcept;
     std::error_code try_resume() noexcept;
     std::error_code try_stop() noexcept;
+
+    /**
+     * @return the clock the timer is measured against
+     */
+    clockid_t clock() const noexcept;
+
+    /**
+     * Pollable file descriptor, it becomes readable when the timer expires.
+     * Register it with select, poll or epoll and call timer::dispatch once it's readable.
+     *
+     * @return timerfd descriptor, or -1 for backend::signal
+     */
+    int fd() const noexcept;
+
+    /**
+     * Reads the expiration counter and calls the user callback in the caller's thread. It never blocks, if the timer
+     * has not expired since the last call the callback is not called.
+     *
+     * @return number of expirations since the last call, always 0 for backend::signal
+     */
+    std::uint64_t dispatch();
+
+    /**
+     * Sets how expirations coalesced by the kernel are delivered. When the process is descheduled or a callback runs
+     * longer than the period, the kernel delivers several elapsed periods at once. By default the callback is called
+     * once and timer::expirations reports the number of periods, with overrun_policy::catch_up the callback is called
+     * once per elapsed period.
+     */
+    void set_overrun_policy(overrun_policy policy) noexcept;
+
+    /**
+     * Number of periods elapsed since the previous delivery, it's 1 unless the kernel has coalesced expirations.
+     * Call it from the callback to keep rate based accounting correct under load.
+     *
+     * @return number of periods covered by the current, or the last, callback delivery
+     */
+    std::uint64_t expirations() const noexcept;
+
+    /**
+     * Binds the timer to an executor, the callbacks are then run by the executor instead of the thread the expiration
+     * was delivered to. A timer never runs on two workers at once, the periods elapsed while its callback is queued
+     * or running are delivered by the next run, see timer::expirations. Bind the timer before it's started, the
+     * executor must outlive it and the timer must not be destroyed from its own callback.
+     *
+     * @param ex      Executor running the callbacks, nullptr runs them in place again.
+     * @param worker  Executor worker the callbacks must run on, by default any.
+     */
+    void set_executor(executor* ex, std::size_t worker = executor::any) noexcept;
+
+    /**
+     * Sets how late the timer is allowed to expire, it takes effect the next time the timer is started or resumed.
+     *
+     * A timer with slack expires at the first point of a process wide grid at or after its deadline. The grid step is
+     * the largest power of two nanoseconds not above the slack, so the timers of the same clock with overlapping
+     * tolerance windows are armed at the very same instant and the kernel wakes the process up once for all of them.
+     * Every deadline is computed from the ideal one, so the rounding does not accumulate. A timer with zero slack, the
+     * default, is armed exactly as before.
+     *
+     * @param slack   maximum delay of every expiration.
+     */
+    void set_slack(std::chrono::nanoseconds slack) noexcept;
+
+    /**
+     * @return the timer slack, see timer::set_slack
+     */
+    std::chrono::nanoseconds slack() const noexcept;
+
+    /**
+     * @return wakeups of the timers with slack versus their expirations, since the process start
+     */
+    static coalescing_stats coalescing() noexcept;
+
+    /**
+     * Time left to the next expiration, computed from the deadline recorded when the timer was armed and
+     * posixcpp::tsc_clock, no syscall is made. A suspended timer reports the time left when it was suspended, a
+     * stopped or expired one 0. For a timer with slack it's the time to the ideal deadline.
+     */
+    std::chrono::nanoseconds remaining() const noexcept;
+
+    /**
+     * Runtime statistics of this timer. The counters live on their own cache lines, apart for the expiry path, the
+     * callback and the API callers, so updating them costs a few relaxed atomic additions and a clock read.
+     *
+     * @return copy of the counters since the timer construction, see also timer_registry::snapshot
+     */
+    timer_stats stats() const noexcept;
   }; // class timer
 
   inline std::error_code make_error_code(timer::error err) noexcept
@@ -177,7 +527,7 @@ namespace posixcpp {
     return std::error_code(static_cast<int>(err), timer::error_category::instance());
   }
 
-  inline bool is_warning(std::error_code ec)
+  inline bool is_warning(std::error_code ec) noexcept
   {
     return (ec && ec.value() > 0);
   }
@@ -0,0 +1,339 @@
+#pragma once
+
+// C++20 coroutine support is optional, the header is empty for older standards
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define POSIXCPP_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(POSIXCPP_HAS_COROUTINES) || defined(POSIXCPP_DOXYGEN)
+
+// C++ STL headers
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <thread>
+
+// POSIX headers
+#include <semaphore.h>
+
+// Local headers
+#include "executor.h"
+#include "timer_wheel.h"
+
+namespace posixcpp
+{
+  /**
+   * Drives the timer awaitables.
+   *
+   * Every suspended coroutine owns a logical timer of the *wheel*, so any number of them share the single POSIX timer
+   * of the wheel. Expired coroutines are never resumed in the wheel tick, i.e. in signal context, they are handed to
+   * the user supplied *scheduler*, which resumes them on its own threads. The coroutines the scheduler refuses, when
+   * its queues are full, go to the resume queue of the context, drained by a thread of its own.
+   *
+   * The first context constructed becomes the default one, used by the awaitables created without a context. The
+   * context must outlive all of its suspended coroutines. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class coroutine_context
+  {
+    public:
+    /**
+     * Entry of the resume queue, embedded in the awaitables, so queuing never allocates
+     */
+    struct resumption
+    {
+      std::coroutine_handle<> _handle;
+      resumption* _next = nullptr;
+    };
+
+    private:
+    timer_wheel& _wheel;
+    executor& _scheduler;
+    std::atomic<resumption*> _queue;          /**< LIFO of the coroutines refused by the scheduler */
+    std::atomic<bool> _running;
+    sem_t _ready;                             /**< posted once per queued coroutine and by the destructor */
+    std::thread _thread;
+
+    static std::atomic<coroutine_context*>& default_context() noexcept
+    {
+      static std::atomic<coroutine_context*> instance(nullptr);
+      return instance;
+    }
+
+    void drain() noexcept
+    {
+      do
+      {
+        while (sem_wait(&_ready) != 0)
+        {
+          // EINTR, try again
+        }
+
+        // the oldest coroutine is resumed first, the entry is gone once its coroutine is resumed
+        resumption* fifo = nullptr;
+        for (auto r = _queue.exchange(nullptr, std::memory_order_acquire); r; )
+        {
+          auto next = r->_next;
+          r->_next = fifo;
+          fifo = r;
+          r = next;
+        }
+        while (fifo)
+        {
+          auto next = fifo->_next;
+          fifo->_handle.resume();
+          fifo = next;
+        }
+      }
+      while (_running.load());
+    }
+
+    public:
+    /**
+     * @param wheel       Wheel the awaitable timers are created on, its resolution rounds every wait up.
+     * @param scheduler   Executor resuming the expired coroutines.
+     */
+    explicit coroutine_context(timer_wheel& wheel, executor& scheduler) :
+      _wheel(wheel),
+      _scheduler(scheduler),
+      _queue(nullptr),
+      _running(true)
+    {
+      sem_init(&_ready, 0, 0);
+      _thread = std::thread(&coroutine_context::drain, this);
+
+      coroutine_context* expected = nullptr;
+      default_context().compare_exchange_strong(expected, this);
+    }
+
+    ~coroutine_context()
+    {
+      coroutine_context* expected = this;
+      default_context().compare_exchange_strong(expected, nullptr);
+
+      _running.store(false);
+      sem_post(&_ready);
+      _thread.join();
+      sem_destroy(&_ready);
+    }
+
+    coroutine_context(const coroutine_context&) = delete;
+    coroutine_context(coroutine_context&&) = delete;
+    coroutine_context& operator=(const coroutine_context&) = delete;
+    coroutine_context& operator=(coroutine_context&&) = delete;
+
+    /**
+     * @return the default context, it throws std::logic_error if there is none
+     */
+    static coroutine_context& current()
+    {
+      auto ctx = default_context().load();
+      if (!ctx)
+      {
+        throw std::logic_error("no posixcpp::coroutine_context has been constructed");
+      }
+      return *ctx;
+    }
+
+    timer_wheel& wheel() noexcept
+    {
+      return _wheel;
+    }
+
+    /**
+     * Resumes the coroutine of *r* through the scheduler, or through the resume queue if the scheduler is saturated.
+     * *r* must stay valid until the coroutine is resumed. It's async-signal-safe.
+     */
+    void schedule(resumption& r) noexcept
+    {
+      auto handle = r._handle;
+      if (_scheduler.execute([handle]() { handle.resume(); }))
+      {
+        return;
+      }
+
+      auto head = _queue.load(std::memory_order_relaxed);
+      do
+      {
+        r._next = head;
+      }
+      while (!_queue.compare_exchange_weak(head, &r, std::memory_order_release, std::memory_order_relaxed));
+      sem_post(&_ready);
+    }
+  }; // class coroutine_context
+
+  /**
+   * Awaitable suspending the coroutine for a duration, see posixcpp::sleep_for and posixcpp::until.
+   */
+  class sleep_awaiter
+  {
+    coroutine_context& _context;
+    std::chrono::nanoseconds _duration;
+    coroutine_context::resumption _resumption;
+    std::optional<timer_wheel::timer> _timer;
+
+    public:
+    sleep_awaiter(coroutine_context& context, std::chrono::nanoseconds duration) noexcept :
+      _context(context),
+      _duration(duration)
+    {}
+
+    bool await_ready() const noexcept
+    {
+      return _duration.count() <= 0;
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+      _resumption._handle = handle;
+      _timer.emplace(_context.wheel(), std::chrono::duration_cast<std::chrono::seconds>(_duration),
+          _duration % std::chrono::seconds(1),
+          [this](void*) { _context.schedule(_resumption); }, nullptr, true);
+      _timer->start();
+    }
+
+    void await_resume() const noexcept
+    {}
+  }; // class sleep_awaiter
+
+  /**
+   * @return awaitable resuming the coroutine after *duration*, rounded up to the wheel resolution
+   */
+  template <typename Rep, typename Period>
+  inline sleep_awaiter sleep_for(coroutine_context& context, std::chrono::duration<Rep, Period> duration)
+  {
+    return sleep_awaiter(context, std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+  }
+
+  template <typename Rep, typename Period>
+  inline sleep_awaiter sleep_for(std::chrono::duration<Rep, Period> duration)
+  {
+    return sleep_for(coroutine_context::current(), duration);
+  }
+
+  /**
+   * @return awaitable resuming the coroutine at *deadline*, rounded up to the wheel resolution
+   */
+  template <typename Clock, typename Duration>
+  inline sleep_awaiter until(coroutine_context& context, std::chrono::time_point<Clock, Duration> deadline)
+  {
+    return sleep_for(context, deadline - Clock::now());
+  }
+
+  template <typename Clock, typename Duration>
+  inline sleep_awaiter until(std::chrono::time_point<Clock, Duration> deadline)
+  {
+    return until(coroutine_context::current(), deadline);
+  }
+
+  /**
+   * Periodic tick source for coroutines, an asynchronous generator of ticks.
+   *
+   * Every co_await on it suspends until the next tick and returns the number of periods elapsed since the previous
+   * one, ticks are never lost when the coroutine is slower than the period. Only one coroutine may await it at a
+   * time. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class periodic
+  {
+    coroutine_context& _context;
+    std::atomic<std::uint64_t> _pending;
+    std::atomic<void*> _waiter;               /**< address of the suspended coroutine handle */
+    coroutine_context::resumption _resumption; /**< the waiter is taken back once, so one entry is enough */
+    timer_wheel::timer _timer;
+
+    void tick() noexcept
+    {
+      _pending++;
+      if (auto address = _waiter.exchange(nullptr))
+      {
+        _resumption._handle = std::coroutine_handle<>::from_address(address);
+        _context.schedule(_resumption);
+      }
+    }
+
+    public:
+    class awaiter
+    {
+      periodic& _periodic;
+
+      public:
+      explicit awaiter(periodic& p) noexcept :
+        _periodic(p)
+      {}
+
+      bool await_ready() const noexcept
+      {
+        return _periodic._pending.load() != 0;
+      }
+
+      bool await_suspend(std::coroutine_handle<> handle) noexcept
+      {
+        _periodic._waiter.store(handle.address());
+
+        // a tick may have arrived before the waiter was published, whoever takes the waiter back resumes it
+        if (_periodic._pending.load() != 0 && _periodic._waiter.exchange(nullptr) != nullptr)
+        {
+          return false;
+        }
+        return true;
+      }
+
+      std::uint64_t await_resume() noexcept
+      {
+        return _periodic._pending.exchange(0);
+      }
+    };
+
+    /**
+     * Starts ticking immediately.
+     *
+     * @param context   Context driving the ticks.
+     * @param period    Tick period, rounded up to the wheel resolution.
+     */
+    template <typename Rep, typename Ratio>
+    periodic(coroutine_context& context, std::chrono::duration<Rep, Ratio> period) :
+      _context(context),
+      _pending(0),
+      _waiter(nullptr),
+      _timer(context.wheel(), std::chrono::duration_cast<std::chrono::seconds>(period),
+          std::chrono::duration_cast<std::chrono::nanoseconds>(period) % std::chrono::seconds(1),
+          [this](void*) { tick(); })
+    {
+      _timer.start();
+    }
+
+    template <typename Rep, typename Ratio>
+    explicit periodic(std::chrono::duration<Rep, Ratio> period) :
+      periodic(coroutine_context::current(), period)
+    {}
+
+    periodic(const periodic&) = delete;
+    periodic(periodic&&) = delete;
+    periodic& operator=(const periodic&) = delete;
+    periodic& operator=(periodic&&) = delete;
+
+    /**
+     * @return awaitable of the next tick
+     */
+    awaiter next() noexcept
+    {
+      return awaiter(*this);
+    }
+
+    awaiter operator co_await() noexcept
+    {
+      return next();
+    }
+  }; // class periodic
+
+} // namespace posixcpp
+
+#endif
@@ -0,0 +1,132 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Local headers
+#include "timer_registry.h"
+
+namespace posixcpp
+{
+  /**
+   * Dedicated timer expiration dispatcher.
+   *
+   * Timers constructed with a dispatcher target their signal at the dispatcher thread only (SIGEV_THREAD_ID), where
+   * it is received synchronously with sigwaitinfo, so no other thread is ever interrupted by a timer expiration and
+   * no user code runs in signal context. The dispatcher thread only hands the expired timer over to a worker through
+   * a wait-free single producer, single consumer ring; the callbacks run on the worker threads.
+   *
+   * Workers are picked round robin. If every worker queue is full the wakeup is dropped and counted, see
+   * timer_dispatcher::dropped, its periods are still reported by the next delivery, see timer::expirations. The
+   * dispatcher must outlive all of its timers.
+   *
+   * A dispatcher constructed with a realtime_profile pins the dispatcher and the worker threads to the profile CPUs,
+   * runs them with a real-time scheduling policy and pre-faults and locks their stacks and queues in memory, see
+   * timer_dispatcher::realtime and timer_dispatcher::self_test.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_dispatcher
+  {
+    friend class timer;
+
+    class timer_dispatcher_;                      /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_dispatcher_> _dispatcher; /**< pointer to PIMPL timer_dispatcher_ object */
+
+    public:
+    /**
+     * Real-time configuration of the dispatcher and worker threads
+     */
+    struct realtime_profile
+    {
+      enum class policy : int
+      {
+        other,                                /**< the default time sharing scheduler */
+        fifo,                                 /**< SCHED_FIFO at *priority* */
+        deadline                              /**< SCHED_DEADLINE reservation, *cpus* must span a root domain */
+      };
+
+      std::vector<int> cpus;                  /**< CPUs the threads are pinned to, empty leaves them unpinned */
+      policy scheduling = policy::fifo;
+      int priority = 80;                      /**< SCHED_FIFO priority, 1 to 99 */
+      std::chrono::nanoseconds runtime = std::chrono::microseconds(100); /**< SCHED_DEADLINE budget per period */
+      std::chrono::nanoseconds deadline = std::chrono::milliseconds(1);
+      std::chrono::nanoseconds period = std::chrono::milliseconds(1);
+      bool lock_memory = true;                /**< pre-fault and lock the thread stacks and the worker queues */
+      std::size_t stack_prefault = 64 * 1024; /**< stack bytes pre-faulted and locked per thread */
+      bool strict = false;                    /**< throw timer::error::realtime_setup_failed if anything fails */
+    };
+
+    /**
+     * What the real-time profile has achieved on every thread, see timer_dispatcher::realtime
+     */
+    struct realtime_status
+    {
+      bool pinned;                            /**< the threads run on the profile CPUs */
+      bool scheduled;                         /**< the threads run with the profile policy */
+      bool locked;                            /**< the stacks and the queues are locked in memory */
+    };
+
+    /**
+     * @brief The explicit timer_dispatcher constructor, it starts the dispatcher and the worker threads.
+     *
+     * @param workers     Number of worker threads running the timer callbacks, at least one.
+     * @param sig         Signal targeted at the dispatcher thread, by default it's **SIGRTMAX**.
+     * @param queue_size  Capacity of every worker queue.
+     */
+    explicit timer_dispatcher(std::size_t workers = 1, int sig = SIGRTMAX, std::size_t queue_size = 1024);
+
+    /**
+     * @brief The real-time timer_dispatcher constructor, every thread applies the profile before it starts working.
+     * Without the needed privileges (CAP_SYS_NICE, RLIMIT_MEMLOCK) the settings that fail are skipped and logged,
+     * unless the profile is strict, see timer_dispatcher::realtime.
+     *
+     * @param profile     Real-time configuration of the threads.
+     * @param workers     Number of worker threads running the timer callbacks, at least one.
+     * @param sig         Signal targeted at the dispatcher thread, by default it's **SIGRTMAX**.
+     * @param queue_size  Capacity of every worker queue.
+     */
+    explicit timer_dispatcher(const realtime_profile& profile, std::size_t workers = 1, int sig = SIGRTMAX,
+        std::size_t queue_size = 1024);
+
+    ~timer_dispatcher();
+
+    timer_dispatcher(const timer_dispatcher&) = delete;
+    timer_dispatcher(timer_dispatcher&&) = delete;
+    timer_dispatcher& operator=(const timer_dispatcher&) = delete;
+    timer_dispatcher& operator=(timer_dispatcher&&) = delete;
+
+    /**
+     * @return number of worker threads
+     */
+    std::size_t workers() const noexcept;
+
+    /**
+     * @return number of wakeups dropped because all worker queues were full
+     */
+    std::uint64_t dropped() const noexcept;
+
+    /**
+     * @return what the real-time profile has achieved, all false for a dispatcher without a profile
+     */
+    realtime_status realtime() const noexcept;
+
+    /**
+     * Latency self test: runs a periodic CLOCK_MONOTONIC probe timer on the dispatcher for *duration* and reports its
+     * statistics, timer_stats::lateness measures how late the worker has run the callback.
+     *
+     * @param duration  How long the probe runs.
+     * @param period    Probe timer period.
+     */
+    timer_stats self_test(std::chrono::nanoseconds duration = std::chrono::seconds(1),
+        std::chrono::nanoseconds period = std::chrono::milliseconds(1));
+  }; // class timer_dispatcher
+
+} // namespace posixcpp
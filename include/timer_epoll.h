@@ -0,0 +1,65 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <system_error>
+
+// Local headers
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * epoll set shared by many timer::backend::timerfd timers.
+   *
+   * A single timer_epoll::dispatch call waits once and dispatches every timer that has expired meanwhile. The epoll
+   * descriptor itself is pollable, so the whole set can be nested into an existing event loop as one descriptor.
+   *
+   * It is not:
+   * - thread safe;
+   * - copyable;
+   * - movable;
+   */
+  class timer_epoll
+  {
+    static constexpr int max_events = 64;     /**< maximum number of timers dispatched per epoll_wait */
+
+    int _fd;                                  /**< epoll descriptor */
+
+    public:
+    timer_epoll();
+
+    ~timer_epoll();
+
+    timer_epoll(const timer_epoll&) = delete;
+    timer_epoll(timer_epoll&&) = delete;
+    timer_epoll& operator=(const timer_epoll&) = delete;
+    timer_epoll& operator=(timer_epoll&&) = delete;
+
+    /**
+     * Adds a timer::backend::timerfd timer to the set, the timer must be removed before it is destroyed.
+     */
+    void add(timer& tm);
+
+    /**
+     * Removes the timer from the set. Called by a callback of the set, it also drops the timer from the batch being
+     * dispatched, so the timer may be destroyed right after.
+     */
+    void remove(timer& tm);
+
+    /**
+     * Waits for expired timers and calls timer::dispatch for each of them in the caller's thread.
+     *
+     * @param timeout   maximum time to wait, 0 returns immediately and a negative value waits forever.
+     * @return number of timers dispatched, a timer whose expiration has been read meanwhile is not counted
+     */
+    std::size_t dispatch(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * @return epoll descriptor, it becomes readable when any timer in the set has expired
+     */
+    int fd() const noexcept;
+  }; // class timer_epoll
+
+} // namespace posixcpp
@@ -0,0 +1,82 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <system_error>
+#include <vector>
+
+// Local headers
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Bulk operations on a set of timers.
+   *
+   * A group operation reads every clock once for the whole batch and arms each member with a single absolute
+   * timer_settime, the member state is checked without a syscall. So a batch costs at most one syscall per member,
+   * and all members restarted by one batch share the same phase. Linux has no interface arming several POSIX timers
+   * or timerfds in one syscall, so one syscall per member is the floor here.
+   *
+   * Every operation returns the per member results in insertion order, the same codes the try_* methods of
+   * posixcpp::timer return. The array is owned by the group and valid until the next operation.
+   *
+   * The members must outlive the group or be removed first. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_group
+  {
+    class timer_group_;                       /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_group_> _group;     /**< pointer to PIMPL timer_group_ object */
+
+    public:
+    using results_t = std::vector<std::error_code>;
+
+    timer_group();
+
+    ~timer_group();
+
+    timer_group(const timer_group&) = delete;
+    timer_group(timer_group&&) = delete;
+    timer_group& operator=(const timer_group&) = delete;
+    timer_group& operator=(timer_group&&) = delete;
+
+    void add(timer& tm);
+    void remove(timer& tm) noexcept;
+
+    /**
+     * @return number of member timers
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * Arms every member from the same point in time. A member already running is restarted and reported with the
+     * timer::error::start_already_started warning.
+     */
+    const results_t& start_all() noexcept;
+
+    /**
+     * Disarms every member. A member which is not running is reported with the timer::error::stop_while_not_running
+     * warning, as by timer::stop.
+     */
+    const results_t& stop_all() noexcept;
+
+    /**
+     * Restarts every running or suspended member from the same point in time, phase locked members stay on their
+     * grid. A stopped member is left stopped and reported with the timer::error::stop_while_not_running warning, as
+     * by timer::reset.
+     */
+    const results_t& reset_all() noexcept;
+
+    /**
+     * Changes the period of every member. Running members are restarted with the new period from the same point in
+     * time, the others use it from their next start or resume.
+     */
+    const results_t& set_period_all(std::chrono::seconds period_sec,
+        std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0)) noexcept;
+  }; // class timer_group
+
+} // namespace posixcpp
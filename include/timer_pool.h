@@ -0,0 +1,62 @@
+#pragma once
+
+// C++ STL headers
+#include <csignal>
+#include <cstddef>
+#include <ctime>
+#include <memory>
+
+namespace posixcpp
+{
+  /**
+   * Pool of pre-created POSIX kernel timers.
+   *
+   * A posixcpp::timer normally calls sigaction and timer_create when it's constructed and timer_delete when it's
+   * destroyed. The pool creates *capacity* kernel timers and registers the signal handler once, up front; a timer
+   * constructed with the pool takes a free kernel timer from a lock-free ring and gives it back when it's destroyed,
+   * along with the timer_registry slot the pool has reserved for it, so constructing and destroying a pooled timer
+   * costs no syscall, no lock and no heap allocation, with a bounded latency.
+   * Constructing a timer from an exhausted pool fails with the timer::error::pool_exhausted error.
+   *
+   * A kernel timer which has been armed is re-created when its timer is destroyed, and its signal carries a slot
+   * generation, so a stale signal still pending for the destroyed timer is dropped rather than delivered to the next
+   * owner of the kernel timer; destroying a pooled timer which has never been armed costs no syscall. All pooled
+   * timers share the pool clock and signal. The pool must outlive all of its timers. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_pool
+  {
+    friend class timer;
+
+    class timer_pool_;                        /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_pool_> _pool;       /**< pointer to PIMPL timer_pool_ object */
+
+    public:
+    /**
+     * @brief The explicit timer_pool constructor, it creates all the kernel timers.
+     *
+     * @param capacity  Number of kernel timers, i.e. the maximum number of live pooled timers.
+     * @param clock     Clock the kernel timers are measured against.
+     * @param sig       Signal used by the kernel timers, by default it's **SIGRTMAX**.
+     */
+    explicit timer_pool(std::size_t capacity, clockid_t clock = CLOCK_MONOTONIC, int sig = SIGRTMAX);
+
+    ~timer_pool();
+
+    timer_pool(const timer_pool&) = delete;
+    timer_pool(timer_pool&&) = delete;
+    timer_pool& operator=(const timer_pool&) = delete;
+    timer_pool& operator=(timer_pool&&) = delete;
+
+    std::size_t capacity() const noexcept;
+
+    /**
+     * @return the number of kernel timers not used by a timer
+     */
+    std::size_t available() const noexcept;
+
+    clockid_t clock() const noexcept;
+  }; // class timer_pool
+
+} // namespace posixcpp
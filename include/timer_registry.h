@@ -0,0 +1,110 @@
+#pragma once
+
+// C++ STL headers
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+namespace posixcpp
+{
+  /**
+   * Runtime statistics of a single posixcpp::timer, a copy of its counters taken by timer::stats or
+   * timer_registry::snapshot.
+   *
+   * Durations are also kept in log2 histograms: bucket 0 counts the values below 1us, bucket k the values in
+   * [2^(k-1)us, 2^k us), the last bucket everything above.
+   */
+  struct timer_stats
+  {
+    static constexpr std::size_t buckets = 16;
+    using histogram_t = std::array<std::uint64_t, buckets>;
+
+    const void* id;                           /**< address of the timer, stable for its lifetime */
+    clockid_t clock;
+    std::chrono::nanoseconds period;
+    std::uint64_t starts;                     /**< successful start, start_at, reset and resume calls */
+    std::uint64_t stops;                      /**< successful stop and suspend calls */
+    std::uint64_t fires;                      /**< wakeups delivering at least one expiration */
+    std::uint64_t overruns;                   /**< expirations missed on top of the first one of every wakeup */
+    std::chrono::nanoseconds lateness_total;  /**< delivery time behind the ideal deadline, summed over the fires */
+    std::chrono::nanoseconds lateness_max;
+    histogram_t lateness;
+    std::chrono::nanoseconds spin_total;      /**< busy waiting for the exact deadline, see precision_dispatcher */
+    std::uint64_t callbacks;                  /**< callback runs, a catch up delivery runs several */
+    std::chrono::nanoseconds callback_total;  /**< time spent in the callback of every delivery */
+    std::chrono::nanoseconds callback_max;
+    histogram_t callback_duration;
+
+    /**
+     * @return the upper bound of histogram bucket *i*, the last bucket is unbounded
+     */
+    static constexpr std::chrono::nanoseconds bucket_bound(std::size_t i) noexcept
+    {
+      return std::chrono::microseconds(std::int64_t(1) << i);
+    }
+
+    /**
+     * @return the upper bound of the bucket holding the *p* percentile of *histogram*, 0 if it's empty
+     */
+    static std::chrono::nanoseconds percentile(const histogram_t& histogram, double p) noexcept
+    {
+      std::uint64_t total = 0;
+      for (auto n : histogram)
+      {
+        total += n;
+      }
+
+      std::uint64_t seen = 0;
+      for (std::size_t i = 0; i < buckets; i++)
+      {
+        seen += histogram[i];
+        if (total != 0 && static_cast<double>(seen) >= p / 100.0 * static_cast<double>(total))
+        {
+          return bucket_bound(i);
+        }
+      }
+      return std::chrono::nanoseconds(0);
+    }
+
+    /**
+     * @return the histogram bucket of *value*
+     */
+    static std::size_t bucket(std::chrono::nanoseconds value) noexcept
+    {
+      std::size_t i = 0;
+      while (i + 1 < buckets && value >= bucket_bound(i))
+      {
+        i++;
+      }
+      return i;
+    }
+  };
+
+  /**
+   * Process wide registry of the live posixcpp::timer objects.
+   *
+   * The expiry path only updates per timer atomic counters, it never touches the registry, so a snapshot does not
+   * delay any expiration. The registry takes no lock: a timer constructor pops a slot of a lock-free table, only one
+   * in 256 allocates a new chunk of slots, and size() reads an atomic counter. A snapshot pins one slot at a time
+   * while it copies the counters of its timer, a timer destroyed meanwhile waits for that copy only.
+   */
+  class timer_registry
+  {
+    public:
+    timer_registry() = delete;
+
+    /**
+     * @return statistics of every live timer, in construction order
+     */
+    static std::vector<timer_stats> snapshot();
+
+    /**
+     * @return number of live timers
+     */
+    static std::size_t size() noexcept;
+  };
+
+} // namespace posixcpp
@@ -0,0 +1,148 @@
+#pragma once
+
+// C++ STL headers
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Local headers
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Per-core sharded timeouts, expiry handling scales with the cores.
+   *
+   * The service runs one shard per CPU: a thread pinned to the CPU with its own timeout queue and timerfd. Nothing is
+   * shared between the shards, a timeout belongs to the shard of the core it's constructed on and its callbacks run
+   * on that shard's thread. Arming and cancelling a timeout only flip an atomic on the handle and post a message to
+   * the inbox of its shard, a lock-free ring the shard thread drains before it handles its expirations; a timeout
+   * used on its own core never touches a cache line of another core, one cancelled from another core costs a single
+   * message. The shard thread is woken up only when a new deadline is earlier than its programmed wakeup.
+   *
+   * The deadlines are measured with posixcpp::tsc_clock. The callbacks may arm, cancel and destroy any timeout;
+   * destroying a timeout of another shard waits for that shard to drop it, meanwhile the waiting shard keeps handling
+   * its own inbox, so two shards destroying each other's timeouts don't deadlock. The service must outlive all of its
+   * timeouts. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_service
+  {
+    class timer_service_;                     /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_service_> _service; /**< pointer to PIMPL timer_service_ object */
+
+    public:
+    using callback_t = posixcpp::timer::callback_t;    /**< User provided callback function type*/
+
+    static constexpr std::size_t local = static_cast<std::size_t>(-1); /**< the shard of the calling thread's core */
+
+    /**
+     * Activity counters of a shard or of the whole service, see timer_service::stats
+     */
+    struct counters
+    {
+      std::uint64_t arms;                     /**< arm messages handled */
+      std::uint64_t cancels;                  /**< cancel messages handled */
+      std::uint64_t remote;                   /**< messages posted from a thread on another core */
+      std::uint64_t expirations;              /**< timeouts fired */
+      std::uint64_t wakeups;                  /**< wakeups of the shard threads */
+    };
+
+    /**
+     * Intrusive timeout handle, reusable for any number of arm and cancel cycles.
+     *
+     * It is not:
+     * - copyable;
+     * - movable;
+     */
+    class timeout
+    {
+      friend class timer_service::timer_service_;
+
+      static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+      timer_service_& _service;
+      std::size_t _shard;
+      callback_t _callback;
+      void* _data;
+      std::atomic<std::uint64_t> _word;       /**< generation << 1 | armed bit, flipped by the users and the shard */
+      std::atomic<unsigned> _refs;            /**< messages and queue entries of the shard referring to the timeout */
+
+      /* owned by the shard thread */
+      std::int64_t _deadline;                 /**< tsc_clock nanoseconds of the queued entry */
+      std::uint64_t _generation;              /**< generation of the queued entry */
+      std::size_t _index;                     /**< position in the shard queue, npos when not queued */
+
+      public:
+      /**
+       * @brief The explicit timeout constructor.
+       *
+       * @param service   The service driving this timeout, it must outlive the timeout.
+       * @param callback  User specified callback function, which is called when the timeout fires.
+       * @param data      User specified pointer passed as argument to the callback function.
+       * @param shard     Shard owning the timeout, by default the one of the calling thread's core.
+       */
+      explicit timeout(timer_service& service, callback_t callback = nullptr, void* data = nullptr,
+          std::size_t shard = local);
+
+      ~timeout();
+
+      timeout(const timeout&) = delete;
+      timeout(timeout&&) = delete;
+      timeout& operator=(const timeout&) = delete;
+      timeout& operator=(timeout&&) = delete;
+
+      /**
+       * Arms the timeout to fire after *duration*, an armed timeout is re-armed.
+       */
+      void arm(std::chrono::nanoseconds duration) noexcept;
+
+      /**
+       * @return true if an armed timeout was cancelled, false if it was not armed or has already fired
+       */
+      bool cancel() noexcept;
+
+      bool armed() const noexcept;
+
+      std::size_t shard() const noexcept;
+    }; // class timeout
+
+    /**
+     * @brief The explicit timer_service constructor, it starts the shard threads.
+     *
+     * @param shards      Number of shards, 0 runs one per CPU of the process affinity mask.
+     * @param queue_size  Inbox capacity of every shard, a full inbox makes the posting thread wait.
+     */
+    explicit timer_service(std::size_t shards = 0, std::size_t queue_size = 4096);
+
+    ~timer_service();
+
+    timer_service(const timer_service&) = delete;
+    timer_service(timer_service&&) = delete;
+    timer_service& operator=(const timer_service&) = delete;
+    timer_service& operator=(timer_service&&) = delete;
+
+    std::size_t shards() const noexcept;
+
+    /**
+     * @return the shard of the calling thread's core
+     */
+    std::size_t local_shard() const noexcept;
+
+    /**
+     * @return the number of queued timeouts, including the cancelled ones whose message is not handled yet
+     */
+    std::size_t size() const noexcept;
+
+    /**
+     * @return the counters summed over all shards
+     */
+    counters stats() const noexcept;
+
+    counters stats(std::size_t shard) const;
+  }; // class timer_service
+
+} // namespace posixcpp
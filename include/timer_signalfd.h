@@ -0,0 +1,71 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace posixcpp
+{
+  /**
+   * signalfd expiration delivery for event loops, without any signal handler.
+   *
+   * The constructor blocks the timer signal in the calling thread and opens a signalfd for it. Timers constructed
+   * with a timer_signalfd target their signal at that thread only (SIGEV_THREAD_ID), where it stays pending until
+   * timer_signalfd::dispatch reads it: every read pulls a whole batch of signalfd_siginfo records, and the ssi_ptr of
+   * each record maps back to its timer, so one syscall delivers dozens of expirations and no code runs in signal
+   * context. The descriptor is pollable, so it can be nested into an existing event loop.
+   *
+   * Construct it in the thread calling dispatch. It must outlive all of its timers; the timers may be destroyed from
+   * any thread, a destructor waits for the callback of its timer being dispatched.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_signalfd
+  {
+    friend class timer;
+
+    class timer_signalfd_;                    /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_signalfd_> _signalfd; /**< pointer to PIMPL timer_signalfd_ object */
+
+    public:
+    static constexpr std::size_t batch = 64;  /**< maximum number of signalfd_siginfo records per read */
+
+    /**
+     * @brief The explicit timer_signalfd constructor.
+     *
+     * @param sig   Signal targeted at the calling thread and read from the descriptor, by default it's **SIGRTMAX**.
+     */
+    explicit timer_signalfd(int sig = SIGRTMAX);
+
+    ~timer_signalfd();
+
+    timer_signalfd(const timer_signalfd&) = delete;
+    timer_signalfd(timer_signalfd&&) = delete;
+    timer_signalfd& operator=(const timer_signalfd&) = delete;
+    timer_signalfd& operator=(timer_signalfd&&) = delete;
+
+    /**
+     * Waits for expirations and delivers all of them in the caller's thread, reading them in batches.
+     *
+     * @param timeout   maximum time to wait, 0 returns immediately and a negative value waits forever.
+     * @return number of expiration signals delivered
+     */
+    std::size_t dispatch(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * @return signalfd descriptor, it becomes readable when any timer has expired
+     */
+    int fd() const noexcept;
+
+    /**
+     * @return number of read calls which returned at least one expiration
+     */
+    std::uint64_t reads() const noexcept;
+  }; // class timer_signalfd
+
+} // namespace posixcpp
@@ -0,0 +1,125 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Local headers
+#include "inplace_function.h"
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+namespace posixcpp
+{
+  /**
+   * io_uring timeout delivery, timers armed and expired without per timer syscalls.
+   *
+   * Starting, resetting, suspending or stopping a timer constructed with a timer_uring only queues an
+   * IORING_OP_TIMEOUT or IORING_OP_TIMEOUT_REMOVE submission entry, the entries are flushed in a batch by the next
+   * submission of the ring; an arm cancelled before it's flushed costs nothing at all. The deadlines are absolute,
+   * so the flush delay doesn't shift them, and the expirations are reaped as completions. Periodic timers are
+   * re-armed from the completion on the same deadline grid, missed periods are reported as overruns.
+   *
+   * The timer_uring either owns a ring, driven by timer_uring::dispatch, or shares the application's ring: with
+   * timer_uring::shared_ring the application calls timer_uring::prepare before it submits its ring and hands every
+   * completion over to timer_uring::complete. The timer completions carry user_tag in the top byte of their
+   * user_data, the application's own user_data must not.
+   *
+   * The callbacks run in the thread dispatching the ring. Timers may be started and stopped from any thread; with an
+   * own ring a dispatch waiting for completions is woken up through an eventfd, with a shared ring the entries are
+   * flushed by the next prepare. It must outlive all of its timers.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_uring
+  {
+    friend class timer;
+
+    class timer_uring_;                       /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_uring_> _uring;     /**< pointer to PIMPL timer_uring_ object */
+
+    public:
+    static constexpr std::uint64_t user_tag = 0xa5; /**< top byte of the user_data of every timer submission */
+
+    /**
+     * Tag type of the shared ring constructor
+     */
+    struct shared_ring_t
+    {
+      explicit shared_ring_t() = default;
+    };
+    static constexpr shared_ring_t shared_ring{};
+
+    using sqe_source_t = inplace_function<io_uring_sqe*()>; /**< returns a free submission entry or nullptr */
+
+    /**
+     * Ring activity counters, see timer_uring::stats
+     */
+    struct counters
+    {
+      std::uint64_t submissions;              /**< submission entries prepared */
+      std::uint64_t completions;              /**< timer completions reaped */
+      std::uint64_t enters;                   /**< io_uring_enter calls of the own ring */
+      std::uint64_t wakeups;                  /**< eventfd writes waking a waiting dispatch up */
+    };
+
+    /**
+     * @brief The explicit timer_uring constructor, it sets up its own ring.
+     *
+     * @param entries   Submission queue size of the ring, the completion queue is 8 times larger.
+     */
+    explicit timer_uring(unsigned entries = 256);
+
+    /**
+     * @brief The timer_uring constructor for the application's ring, see timer_uring::prepare and
+     * timer_uring::complete.
+     */
+    explicit timer_uring(shared_ring_t);
+
+    ~timer_uring();
+
+    timer_uring(const timer_uring&) = delete;
+    timer_uring(timer_uring&&) = delete;
+    timer_uring& operator=(const timer_uring&) = delete;
+    timer_uring& operator=(timer_uring&&) = delete;
+
+    /**
+     * Own ring only: flushes the queued entries, waits for completions and delivers the expirations in the caller's
+     * thread, with a single io_uring_enter. The re-arms of the delivered periodic timers are submitted before it
+     * returns, so the caller may wait for fd() readiness in its own event loop; timers started meanwhile are
+     * submitted by the next dispatch.
+     *
+     * @param timeout   maximum time to wait, 0 returns immediately and a negative value waits forever.
+     * @return number of expirations delivered
+     */
+    std::size_t dispatch(std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+    /**
+     * Shared ring: fills the queued timer entries into the submission entries returned by *source*, it stops when
+     * *source* returns nullptr and the rest is kept for the next call.
+     *
+     * @return number of submission entries filled
+     */
+    std::size_t prepare(const sqe_source_t& source);
+
+    /**
+     * Shared ring: delivers a timer completion.
+     *
+     * @return false if *cqe* isn't a timer completion
+     */
+    bool complete(const io_uring_cqe& cqe);
+
+    /**
+     * @return ring descriptor, it becomes readable when a completion is ready, -1 with a shared ring
+     */
+    int fd() const noexcept;
+
+    counters stats() const noexcept;
+  }; // class timer_uring
+
+} // namespace posixcpp
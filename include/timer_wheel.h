@@ -0,0 +1,139 @@
+#pragma once
+
+// C++ STL headers
+#include <csignal>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <system_error>
+
+// Local headers
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Hierarchical hashed timing wheel.
+   *
+   * The wheel multiplexes any number of logical timers onto a single POSIX interval timer, which ticks every
+   * *resolution* while at least one logical timer is armed. Logical timer periods are rounded up to a whole number of
+   * ticks. A timer started between two ticks expires on the first tick at least its period later, so it's never early
+   * and late by less than a tick. Inserting and cancelling a logical timer is O(1) and never touches the kernel.
+   *
+   * The wheel has four levels of 256 slots each, so a timer can be up to 2^32 ticks ahead (49 days at 1ms resolution),
+   * longer timeouts are re-cascaded until they fit.
+   *
+   * The wheel must outlive all of its logical timers. It is not:
+   * - copyable;
+   * - movable;
+   */
+  class timer_wheel
+  {
+    class timer_wheel_;                       /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<timer_wheel_> _wheel;     /**< pointer to PIMPL timer_wheel_ object */
+
+    /**
+     * Intrusive doubly linked list hook, every logical timer is linked into one wheel slot while running.
+     */
+    struct hook
+    {
+      hook* _prev = nullptr;
+      hook* _next = nullptr;
+    };
+
+    public:
+    using callback_t = posixcpp::timer::callback_t;    /**< User provided callback function type*/
+
+    /**
+     * Logical timer driven by a timer_wheel.
+     *
+     * It follows posixcpp::timer semantics for start, reset, suspend, resume and stop, and reports the same
+     * timer::error codes. The callback is called from the wheel tick, i.e. in the context of the backing POSIX timer
+     * signal handler.
+     */
+    class timer : private hook
+    {
+      friend class timer_wheel::timer_wheel_;
+
+      enum class state : unsigned char
+      {
+        idle,                                 /**< never started or stopped */
+        running,                              /**< linked into the wheel */
+        suspended,                            /**< unlinked, _remaining ticks are kept */
+        expired                               /**< single shot timer has fired */
+      };
+
+      timer_wheel_& _wheel;
+      std::uint64_t _period;                  /**< period in wheel ticks */
+      callback_t _callback;
+      void* _data;
+      bool _is_single_shot;
+      std::uint64_t _expires;                 /**< absolute wheel tick of the next expiry */
+      std::uint64_t _remaining;               /**< ticks left to expiry when suspended */
+      state _state;
+
+      public:
+      /**
+       * @brief The explicit logical timer constructor.
+       * Parameters follow posixcpp::timer, except the signal, which is owned by the wheel.
+       *
+       * @param wheel           The wheel driving this timer, it must outlive the timer.
+       * @param period_sec      First part of timeout period in seconds.
+       * @param period_nsec     Second part of timeout period in nanoseconds.
+       * @param callback        User specified callback function, which is called when timer expires.
+       * @param data            User specified pointer passed as argument to the callback function.
+       * @param is_single_shot  If this argument is true, then timer runs only once
+       */
+      explicit timer(timer_wheel& wheel, std::chrono::seconds period_sec,
+          std::chrono::nanoseconds period_nsec = static_cast<std::chrono::seconds>(0),
+          callback_t callback = nullptr, void* data = nullptr,
+          bool is_single_shot = false
+          );
+
+      ~timer();
+
+      timer(const timer&) = delete;
+      timer(timer&&) = delete;
+      timer& operator=(const timer&) = delete;
+      timer& operator=(timer&&) = delete;
+
+      void start();
+      void reset();
+      void suspend();
+      void resume();
+      void stop();
+
+      std::error_code try_start() noexcept;
+      std::error_code try_reset() noexcept;
+      std::error_code try_suspend() noexcept;
+      std::error_code try_resume() noexcept;
+      std::error_code try_stop() noexcept;
+    }; // class timer
+
+    /**
+     * @brief The explicit timer_wheel constructor.
+     *
+     * @param resolution  Wheel tick, logical timer periods are rounded up to it.
+     * @param sig         Signal used by the backing POSIX timer, by default it's **SIGRTMAX**.
+     */
+    explicit timer_wheel(std::chrono::nanoseconds resolution = std::chrono::milliseconds(1), int sig = SIGRTMAX);
+
+    ~timer_wheel();
+
+    timer_wheel(const timer_wheel&) = delete;
+    timer_wheel(timer_wheel&&) = delete;
+    timer_wheel& operator=(const timer_wheel&) = delete;
+    timer_wheel& operator=(timer_wheel&&) = delete;
+
+    /**
+     * @return the wheel tick duration
+     */
+    std::chrono::nanoseconds resolution() const noexcept;
+
+    /**
+     * @return the number of currently running logical timers
+     */
+    std::size_t size() const noexcept;
+  }; // class timer_wheel
+
+} // namespace posixcpp
@@ -0,0 +1,171 @@
+#pragma once
+
+// C++ STL headers
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Compile time trace switch, 0 compiles the trace points away completely, arguments are not even evaluated. The trace
+ * points are compiled in by default and cost a relaxed load while tracing is stopped.
+ */
+#ifndef POSIXCPP_TRACE_ENABLED
+#define POSIXCPP_TRACE_ENABLED 1
+#endif
+
+/**
+ * Records a posixcpp::trace::event of the timer *id* with the event argument *arg*, if tracing is started.
+ */
+#define POSIXCPP_TRACE(evt, id, arg) \
+  do \
+  { \
+    if constexpr (POSIXCPP_TRACE_ENABLED) \
+    { \
+      if (::posixcpp::trace::enabled()) \
+      { \
+        ::posixcpp::trace::write((evt), (id), (arg)); \
+      } \
+    } \
+  } while (0)
+
+namespace posixcpp
+{
+  /**
+   * Binary timer event trace, a flight recorder for latency spikes.
+   *
+   * Every thread records fixed size events into its own ring, so recording is lock-free, wait-free and safe in signal
+   * context: a raw time stamp counter read and a 32 byte store. A full ring overwrites its oldest events, the rings
+   * always hold the latest timeline. The ring of a thread which has exited is handed over to the next thread left
+   * without one. The rings may be backed by a shared file mapping, which survives a crash of the process; the
+   * trace2chrome tool converts such a file into Chrome trace JSON for chrome://tracing or Perfetto.
+   *
+   * The buffer holds raw counter values, converted to posixcpp::tsc_clock nanoseconds, i.e. CLOCK_MONOTONIC, by
+   * trace::snapshot and trace2chrome with the calibration kept in the file_header.
+   */
+  namespace trace
+  {
+    /**
+     * Traced timer events
+     */
+    enum class event : std::uint32_t
+    {
+      arm,                                    /**< the kernel timer is armed, arg is the relative or absolute value */
+      disarm,                                 /**< the kernel timer is disarmed */
+      expire,                                 /**< an expiry is handled, arg is the number of elapsed periods */
+      callback_begin,                         /**< the callback is called, arg is the number of calls */
+      callback_end                            /**< the callback has returned */
+    };
+
+    /**
+     * Fixed size binary event
+     */
+    struct record
+    {
+      std::uint64_t _timestamp;               /**< counter value in the buffer, tsc_clock nanoseconds in a snapshot */
+      std::uint64_t _id;                      /**< address of the timer implementation object */
+      std::uint64_t _arg;
+      event _event;
+      std::uint32_t _tid;                     /**< recording thread */
+    };
+    static_assert(sizeof(record) == 32, "trace::record must stay 32 bytes");
+
+    static constexpr char magic[8] = {'P', 'X', 'T', 'R', 'A', 'C', 'E', '2'};
+
+    /**
+     * Layout of the trace buffer: a file_header followed by file_header::_threads rings, each of them a ring_header
+     * followed by file_header::_capacity records.
+     */
+    struct alignas(64) file_header
+    {
+      char _magic[8];                         /**< trace::magic */
+      std::uint32_t _record_size;             /**< sizeof(record) */
+      std::uint32_t _threads;                 /**< number of rings */
+      std::uint64_t _capacity;                /**< records per ring, a power of two */
+      std::uint32_t _pid;                     /**< recording process */
+      std::atomic<std::uint32_t> _claimed;    /**< rings handed out to threads, it may exceed _threads */
+      std::atomic<std::uint64_t> _dropped;    /**< events of threads left without a ring */
+      std::uint64_t _counter;                 /**< counter value at _origin */
+      std::int64_t _origin;                   /**< tsc_clock nanoseconds at _counter */
+      double _frequency;                      /**< counter frequency in Hz, 0 if the records hold nanoseconds */
+    };
+    static_assert(sizeof(file_header) == 64, "trace::file_header must stay 64 bytes");
+
+    struct alignas(64) ring_header
+    {
+      std::atomic<std::uint64_t> _head;       /**< events ever written, the latest _capacity of them are kept */
+      std::atomic<std::uint32_t> _tid;        /**< owning thread, the ring is reclaimed once it has exited */
+      char _name[16];                         /**< thread name */
+    };
+
+    /**
+     * @return the tsc_clock nanoseconds of the time stamp of a record in the buffer *h*
+     */
+    inline std::uint64_t nanoseconds(const file_header& h, std::uint64_t timestamp) noexcept
+    {
+      if (h._frequency == 0)
+      {
+        return timestamp;
+      }
+
+      // the events recorded before the calibration point have a negative delta
+      auto delta = static_cast<double>(static_cast<std::int64_t>(timestamp - h._counter));
+      return static_cast<std::uint64_t>(h._origin + static_cast<std::int64_t>(delta * 1e9 / h._frequency));
+    }
+
+    /**
+     * Trace buffer configuration, see trace::start
+     */
+    struct options
+    {
+      std::size_t capacity = 8192;            /**< events kept per thread, rounded up to a power of two */
+      std::size_t threads = 64;               /**< number of rings, the events of further live threads are dropped */
+      const char* path = nullptr;             /**< file backing the rings, nullptr keeps them in anonymous memory */
+    };
+
+    namespace detail
+    {
+      extern std::atomic<bool> _enabled;
+    }
+
+    /**
+     * @return true while tracing is started
+     */
+    inline bool enabled() noexcept
+    {
+      return detail::_enabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Sets the trace buffer up and starts recording, it throws timer::error::trace_failed if the buffer can't be
+     * created. Starting again replaces the previous buffer, the threads recording into it must have stopped.
+     */
+    void start(const options& opt = options());
+
+    /**
+     * Stops recording, the buffer is kept for trace::snapshot and a file backed buffer is flushed.
+     */
+    void stop() noexcept;
+
+    /**
+     * Records an event into the calling thread's ring, use POSIXCPP_TRACE at the trace points.
+     */
+    void write(event e, const void* id, std::uint64_t arg) noexcept;
+
+    /**
+     * @return the events of all rings in time stamp order
+     */
+    std::vector<record> snapshot();
+
+    /**
+     * @return number of events dropped because there were more live threads than rings
+     */
+    std::uint64_t dropped() noexcept;
+
+    /**
+     * @return the event name used in the trace exports
+     */
+    const char* name(event e) noexcept;
+
+  } // namespace trace
+} // namespace posixcpp
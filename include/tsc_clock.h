@@ -0,0 +1,148 @@
+#pragma once
+
+// C++ STL headers
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <ratio>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace posixcpp
+{
+  /**
+   * std::chrono compatible clock reading the CPU time stamp counter, calibrated against CLOCK_MONOTONIC.
+   *
+   * The clock shares the CLOCK_MONOTONIC epoch, so its time points can be compared with clock_gettime values. A read
+   * costs the counter read and a multiplication, no syscall and no vDSO call. The conversion is recalibrated every
+   * recalibration_interval by the first reader past it, over the whole time since the first calibration point, so
+   * the rate error keeps shrinking. A recalibration never steps the clock, its offset against CLOCK_MONOTONIC is
+   * slewed out over the following interval. Readers never wait for a recalibration, the clock is safe to read in
+   * signal context.
+   *
+   * The clock reads CLOCK_MONOTONIC through the vDSO until the first calibration, a few milliseconds after the first
+   * read, and for good when the CPU has no invariant counter, see tsc_clock::uses_tsc.
+   */
+  class tsc_clock
+  {
+    public:
+    using rep = std::int64_t;
+    using period = std::nano;
+    using duration = std::chrono::nanoseconds;
+    using time_point = std::chrono::time_point<tsc_clock>;
+
+    static constexpr bool is_steady = true;
+    static constexpr std::chrono::nanoseconds recalibration_interval = std::chrono::seconds(1);
+
+    static time_point now() noexcept
+    {
+      if (!_state._ready.load(std::memory_order_acquire))
+      {
+        return time_point(warmup());
+      }
+
+      auto tsc = ticks();
+      auto ns = convert(tsc);
+      if (tsc >= _state._next.load(std::memory_order_relaxed))
+      {
+        recalibrate();
+      }
+      return time_point(ns);
+    }
+
+    /**
+     * Recalibrates the clock right away, it does nothing if another thread is recalibrating it. The correction takes
+     * the next recalibration_interval to complete.
+     */
+    static void recalibrate() noexcept;
+
+    /**
+     * @return true if the clock reads the time stamp counter, false while it reads CLOCK_MONOTONIC
+     */
+    static bool uses_tsc() noexcept
+    {
+      return _state._ready.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @return the calibrated counter frequency in Hz, 0 while the clock reads CLOCK_MONOTONIC
+     */
+    static double frequency() noexcept;
+
+    /**
+     * @return the raw counter value, meaningful only if the clock reads the counter, see tsc_clock::frequency
+     */
+    static std::uint64_t counter() noexcept
+    {
+      return ticks();
+    }
+
+    private:
+    static constexpr unsigned shift = 32;     /**< fixed point of the nanoseconds per tick multiplier */
+
+    struct calibration
+    {
+      std::atomic<std::uint64_t> _tsc;        /**< counter value at _ns */
+      std::atomic<std::int64_t> _ns;          /**< CLOCK_MONOTONIC nanoseconds at _tsc */
+      std::atomic<std::uint64_t> _mult;       /**< nanoseconds per tick << shift, slewing the offset out */
+    };
+
+    /**
+     * Constant initialized, so the clock can be read during the static initialization of other translation units
+     */
+    struct state
+    {
+      std::atomic<int> _support;              /**< 0 not probed yet, 1 invariant counter, -1 none */
+      std::atomic<bool> _ready;               /**< calibrated, now() reads the counter */
+      std::atomic<bool> _writing;             /**< a recalibration is in progress */
+      std::atomic<std::uint64_t> _origin_tsc; /**< first calibration point, the rate is measured from it */
+      std::atomic<std::int64_t> _origin_ns;
+      std::atomic<std::uint64_t> _generation; /**< the active slot is _slots[_generation & 1] */
+      std::atomic<std::uint64_t> _next;       /**< counter value triggering the next recalibration */
+      calibration _slots[2];
+    };
+
+    static state _state;
+
+    static std::chrono::nanoseconds warmup() noexcept;
+
+    static std::chrono::nanoseconds convert(std::uint64_t tsc) noexcept
+    {
+      std::uint64_t generation;
+      std::int64_t ns;
+
+      do
+      {
+        // the writer fills the inactive slot and then publishes it, a reader only retries after two recalibrations
+        generation = _state._generation.load(std::memory_order_acquire);
+        auto& c = _state._slots[generation & 1];
+        auto base = c._tsc.load(std::memory_order_relaxed);
+        auto delta = tsc > base ? tsc - base : 0;
+        ns = c._ns.load(std::memory_order_relaxed) +
+          static_cast<std::int64_t>((static_cast<unsigned __int128>(delta) * c._mult.load(std::memory_order_relaxed))
+              >> shift);
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+      while (_state._generation.load(std::memory_order_relaxed) != generation);
+
+      return std::chrono::nanoseconds(ns);
+    }
+
+    static std::uint64_t ticks() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#elif defined(__aarch64__)
+      std::uint64_t v;
+      asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+      return v;
+#else
+      return 0;
+#endif
+    }
+  }; // class tsc_clock
+
+} // namespace posixcpp
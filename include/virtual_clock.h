@@ -0,0 +1,99 @@
+#pragma once
+
+// C++ STL headers
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace posixcpp
+{
+  /**
+   * Simulated time for deterministic timer tests, no kernel timer and no real waiting is involved.
+   *
+   * A timer constructed with a virtual_clock is armed, suspended and stopped exactly like a kernel timer, but its
+   * deadlines are points of the virtual time, which only moves forward with virtual_clock::advance. An advance
+   * fires every timer due up to the new time in deadline order, timers due at the same instant in the order they
+   * have been armed; every callback sees virtual_clock::now at its deadline. A periodic timer passed over by a
+   * single advance fires once per period, like a kernel timer handled in time.
+   *
+   * A callback calling virtual_clock::advance itself models a callback running for that long: the other timers fire
+   * meanwhile, the periods its own timer misses are delivered as overruns by one expiry once it returns, following
+   * the timer's overrun_policy, the same as the kernel does.
+   *
+   * The callbacks run in the thread calling advance, the timer operations may be called from any thread and from the
+   * callbacks; the delivery is deterministic as long as a single thread advances the clock. The timers report
+   * CLOCK_MONOTONIC as their clock, absolute times such as the timer::start_at epoch are virtual times. It must
+   * outlive all of its timers.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  class virtual_clock
+  {
+    friend class timer;
+
+    class virtual_clock_;                     /**< Forward class reference to PIMPL implementation */
+    std::shared_ptr<virtual_clock_> _clock;   /**< pointer to PIMPL virtual_clock_ object */
+
+    public:
+    /**
+     * Delivery counters, see virtual_clock::stats
+     */
+    struct counters
+    {
+      std::uint64_t advances;                 /**< advance calls, including the nested ones */
+      std::uint64_t deliveries;               /**< expiries delivered, one per timer wakeup */
+      std::uint64_t expirations;              /**< periods delivered, more than deliveries when there are overruns */
+    };
+
+    /**
+     * @brief The explicit virtual_clock constructor.
+     *
+     * @param start   Initial virtual time, away from 0 so an absolute deadline never means disarming the timer.
+     */
+    explicit virtual_clock(std::chrono::nanoseconds start = std::chrono::seconds(1));
+
+    ~virtual_clock();
+
+    virtual_clock(const virtual_clock&) = delete;
+    virtual_clock(virtual_clock&&) = delete;
+    virtual_clock& operator=(const virtual_clock&) = delete;
+    virtual_clock& operator=(virtual_clock&&) = delete;
+
+    /**
+     * @return the virtual time
+     */
+    std::chrono::nanoseconds now() const noexcept;
+
+    /**
+     * Moves the virtual time *duration* forward and fires the timers due meanwhile. A callback exception is passed
+     * on to the caller, the virtual time stays at the deadline of the throwing timer then.
+     *
+     * @return number of expiries delivered
+     */
+    std::size_t advance(std::chrono::nanoseconds duration);
+
+    /**
+     * Moves the virtual time forward to *instant* and fires the timers due meanwhile, an instant in the past only
+     * fires the timers which are due already.
+     *
+     * @return number of expiries delivered
+     */
+    std::size_t advance_to(std::chrono::nanoseconds instant);
+
+    /**
+     * @return deadline of the earliest armed timer, std::chrono::nanoseconds::max() when no timer is armed
+     */
+    std::chrono::nanoseconds next_deadline() const noexcept;
+
+    /**
+     * @return number of armed timers
+     */
+    std::size_t size() const noexcept;
+
+    counters stats() const noexcept;
+  }; // class virtual_clock
+
+} // namespace posixcpp
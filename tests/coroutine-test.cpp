@@ -0,0 +1,168 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <signal.h>
+
+#include <gtest/gtest.h>
+
+#include "executor.h"
+#include "timer_coroutine.h"
+#include "timer_wheel.h"
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using namespace posixcpp;
+
+namespace
+{
+  /**
+   * Fire and forget coroutine, the frame is destroyed when the coroutine finishes
+   */
+  struct detached
+  {
+    struct promise_type
+    {
+      detached get_return_object() noexcept { return {}; }
+      std::suspend_never initial_suspend() noexcept { return {}; }
+      std::suspend_never final_suspend() noexcept { return {}; }
+      void return_void() noexcept {}
+      void unhandled_exception() noexcept { std::terminate(); }
+    };
+  };
+
+  detached sleeper(std::atomic<int>& done, milliseconds d)
+  {
+    co_await sleep_for(d);
+    done++;
+  }
+
+  detached waiter(coroutine_context& ctx, std::atomic<int>& done, steady_clock::time_point deadline,
+      std::atomic<bool>& on_time)
+  {
+    co_await until(ctx, deadline);
+    if (steady_clock::now() < deadline)
+    {
+      on_time = false;
+    }
+    done++;
+  }
+
+  /**
+   * Executor with full queues, it refuses every task
+   */
+  struct saturated : executor
+  {
+    bool execute(task_t, std::size_t) noexcept override { return false; }
+    std::size_t concurrency() const noexcept override { return 1; }
+  };
+
+  detached resumer(coroutine_context& ctx, std::atomic<std::thread::id>& resumed_on)
+  {
+    co_await sleep_for(ctx, 10ms);
+    resumed_on = std::this_thread::get_id();
+  }
+
+  detached ticker(coroutine_context& ctx, std::atomic<std::uint64_t>& ticks, std::atomic<bool>& finished)
+  {
+    periodic p(ctx, 20ms);
+    while (ticks.load() < 10)
+    {
+      ticks += co_await p;
+    }
+    finished = true;
+  }
+}
+
+TEST(CoroutineTest, SleepFor)
+{
+  timer_wheel wheel(1ms);
+  work_stealing_executor scheduler(2, 4096, false);
+  coroutine_context ctx(wheel, scheduler);
+  std::atomic<int> done{0};
+
+  auto start = steady_clock::now();
+  for (int i = 0; i < 2000; i++)
+  {
+    sleeper(done, milliseconds(50 + i % 50));
+  }
+  EXPECT_EQ(wheel.size(), 2000u);
+
+  while (done.load() != 2000 && steady_clock::now() - start < 2s)
+  {
+    std::this_thread::sleep_for(5ms);
+  }
+  EXPECT_EQ(done.load(), 2000);
+  EXPECT_GE(steady_clock::now() - start, 100ms);
+  EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST(CoroutineTest, Until)
+{
+  timer_wheel wheel(1ms);
+  work_stealing_executor scheduler(1, 64, false);
+  coroutine_context ctx(wheel, scheduler);
+  std::atomic<int> done{0};
+  std::atomic<bool> on_time{true};
+
+  waiter(ctx, done, steady_clock::now() + 30ms, on_time);
+  waiter(ctx, done, steady_clock::now() - 30ms, on_time);
+  EXPECT_EQ(done.load(), 1);
+
+  while (done.load() != 2)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(on_time.load());
+}
+
+TEST(CoroutineTest, Periodic)
+{
+  timer_wheel wheel(1ms);
+  work_stealing_executor scheduler(1, 64, false);
+  coroutine_context ctx(wheel, scheduler);
+  std::atomic<std::uint64_t> ticks{0};
+  std::atomic<bool> finished{false};
+
+  auto start = steady_clock::now();
+  ticker(ctx, ticks, finished);
+
+  while (!finished.load() && steady_clock::now() - start < 2s)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_TRUE(finished.load());
+  EXPECT_GE(steady_clock::now() - start, 190ms);
+}
+
+TEST(CoroutineTest, SaturatedScheduler)
+{
+  // the context thread inherits the blocked signal, so the wheel tick can only run in the ticking thread below
+  sigset_t set, previous;
+  sigemptyset(&set);
+  sigaddset(&set, SIGRTMAX);
+  pthread_sigmask(SIG_BLOCK, &set, &previous);
+
+  timer_wheel wheel(1ms);
+  saturated scheduler;
+  coroutine_context ctx(wheel, scheduler);
+  std::atomic<std::thread::id> resumed_on{};
+  std::atomic<std::thread::id> ticking_on{};
+
+  std::thread ticking([&set, &resumed_on, &ticking_on]() {
+      ticking_on = std::this_thread::get_id();
+      pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+      while (resumed_on.load() == std::thread::id())
+      {
+        std::this_thread::sleep_for(1ms);
+      }
+    });
+
+  // a refused coroutine is resumed by the context thread rather than inline in the wheel tick
+  resumer(ctx, resumed_on);
+  ticking.join();
+  EXPECT_NE(resumed_on.load(), ticking_on.load());
+  EXPECT_NE(resumed_on.load(), std::this_thread::get_id());
+
+  pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
@@ -0,0 +1,97 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "executor.h"
+#include "timer.h"
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using namespace posixcpp;
+
+TEST(ExecutorTest, FanOut)
+{
+  work_stealing_executor ex(4, 64, false);
+  EXPECT_EQ(ex.concurrency(), 4u);
+
+  std::atomic<int> done{0};
+  auto start = steady_clock::now();
+
+  // the sleeping tasks overlap, unless they are serialised on a single worker
+  for (int i = 0; i < 4; i++)
+  {
+    EXPECT_TRUE(ex.execute([&done]() { std::this_thread::sleep_for(100ms); done++; }));
+  }
+
+  while (done.load() != 4)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_LT(steady_clock::now() - start, 300ms);
+}
+
+TEST(ExecutorTest, Affinity)
+{
+  work_stealing_executor ex(3, 64, false);
+  std::mutex mutex;
+  std::set<std::thread::id> threads;
+  std::atomic<int> done{0};
+
+  for (int i = 0; i < 20; i++)
+  {
+    EXPECT_TRUE(ex.execute([&]() {
+          {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+          }
+          done++;
+        }, 1));
+  }
+
+  while (done.load() != 20)
+  {
+    std::this_thread::sleep_for(1ms);
+  }
+  EXPECT_EQ(threads.size(), 1u);
+  EXPECT_EQ(threads.count(std::this_thread::get_id()), 0u);
+}
+
+TEST(ExecutorTest, BoundTimers)
+{
+  work_stealing_executor ex(2, 64, false);
+  std::atomic<int> slow{0};
+  std::atomic<int> fast{0};
+  std::atomic<bool> off_thread{true};
+  auto main_id = std::this_thread::get_id();
+
+  // the slow callback would hold the fast timer back if both ran in the signal handler
+  timer slow_timer(0s, 50ms, [&](void*) { std::this_thread::sleep_for(200ms); slow++; });
+  timer fast_timer(0s, 10ms, [&](void*) {
+        if (std::this_thread::get_id() == main_id)
+        {
+          off_thread = false;
+        }
+        fast++;
+      });
+  slow_timer.set_executor(&ex);
+  fast_timer.set_executor(&ex);
+
+  slow_timer.start();
+  fast_timer.start();
+
+  auto end = steady_clock::now() + 500ms;
+  while (steady_clock::now() < end)
+  {
+    std::this_thread::sleep_until(end);
+  }
+  slow_timer.stop();
+  fast_timer.stop();
+
+  EXPECT_TRUE(off_thread.load());
+  EXPECT_GE(fast.load(), 35);
+  EXPECT_GE(slow.load(), 1);
+}
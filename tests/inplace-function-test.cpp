@@ -0,0 +1,84 @@
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+#include <gtest/gtest.h>
+
+#include "inplace_function.h"
+
+using namespace posixcpp;
+
+TEST(InplaceFunctionTest, Empty)
+{
+  inplace_function<int(int)> f;
+  EXPECT_FALSE(f);
+  EXPECT_TRUE(f == nullptr);
+  EXPECT_THROW(f(1), std::bad_function_call);
+
+  int (*fp)(int) = nullptr;
+  inplace_function<int(int)> g(fp);
+  EXPECT_FALSE(g);
+
+  inplace_function<int(int)> h(std::function<int(int)>{});
+  EXPECT_FALSE(h);
+}
+
+TEST(InplaceFunctionTest, Call)
+{
+  int base = 40;
+  inplace_function<int(int)> f = [&base](int n) { return base + n; };
+  EXPECT_TRUE(f);
+  EXPECT_EQ(f(2), 42);
+
+  inplace_function<int(int)> g = std::function<int(int)>([](int n) { return n * 2; });
+  EXPECT_EQ(g(21), 42);
+}
+
+TEST(InplaceFunctionTest, CopyMove)
+{
+  auto counter = std::make_shared<int>(0);
+  inplace_function<void()> f = [counter]() { (*counter)++; };
+  EXPECT_EQ(counter.use_count(), 2);
+
+  inplace_function<void()> g = f;
+  EXPECT_EQ(counter.use_count(), 3);
+
+  inplace_function<void()> h = std::move(g);
+  h();
+  f();
+  EXPECT_EQ(*counter, 2);
+
+  f = nullptr;
+  h = nullptr;
+  EXPECT_FALSE(f);
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
+TEST(InplaceFunctionTest, ThrowingCopy)
+{
+  struct fragile
+  {
+    int _value;
+    bool _throws;
+
+    fragile(int value, bool throws) : _value(value), _throws(throws) {}
+    fragile(fragile&&) = default;
+    fragile(const fragile& other) : _value(other._value), _throws(other._throws)
+    {
+      if (_throws)
+      {
+        throw std::runtime_error("copy");
+      }
+    }
+    int operator()() const { return _value; }
+  };
+
+  inplace_function<int()> f = fragile(1, false);
+  inplace_function<int()> g = fragile(2, true);
+
+  // the failed assignment keeps the previous callable
+  EXPECT_THROW(f = g, std::runtime_error);
+  ASSERT_TRUE(f);
+  EXPECT_EQ(f(), 1);
+  EXPECT_EQ(g(), 2);
+}
@@ -0,0 +1,101 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+
+#include <gtest/gtest.h>
+
+#include "log.h"
+#include "timer.h"
+
+using namespace posixcpp;
+
+namespace
+{
+  class capture_sink : public log::sink
+  {
+    public:
+    std::vector<std::string> _lines;
+
+    void write(const log::record& r) noexcept override
+    {
+      char buf[256];
+      log::format(r, buf, sizeof(buf));
+      _lines.emplace_back(buf);
+    }
+  };
+}
+
+TEST(LogTest, LazyDefaultSink)
+{
+  // runs first, nothing has logged through the default sink yet: linking the library starts no drain thread
+  auto threads = []() {
+      std::size_t n = 0;
+      if (auto dir = opendir("/proc/self/task"))
+      {
+        while (auto entry = readdir(dir))
+        {
+          n += entry->d_name[0] != '.';
+        }
+        closedir(dir);
+      }
+      return n;
+    };
+
+  EXPECT_EQ(threads(), 1u);
+  log::prepare_default_sink();
+  EXPECT_EQ(threads(), 2u);
+  EXPECT_EQ(&log::current_sink(), &log::current_sink());
+}
+
+TEST(LogTest, Format)
+{
+  capture_sink sink;
+  log::set_sink(&sink);
+
+  int value = -42;
+  void* ptr = nullptr;
+  POSIXCPP_LOG(LOG_ERR, "int %d unsigned %lu hex 0x%lx string %s %%", value, 7ul, 255ul, "text");
+  POSIXCPP_LOG(LOG_ERR, "error %d: %s,", 1, make_error_code(timer::error::start_already_started));
+  POSIXCPP_LOG(LOG_ERR, "pointer %p", ptr);
+  log::set_sink(nullptr);
+
+  ASSERT_EQ(sink._lines.size(), 3);
+  EXPECT_EQ(sink._lines[0], "int -42 unsigned 7 hex 0xff string text %");
+  EXPECT_EQ(sink._lines[1], "error 1: " + make_error_code(timer::error::start_already_started).message() + ",");
+  EXPECT_EQ(sink._lines[2].find("pointer "), 0);
+}
+
+TEST(LogTest, CompiledOut)
+{
+  capture_sink sink;
+  log::set_sink(&sink);
+
+  int evaluated = 0;
+  POSIXCPP_LOG(POSIXCPP_LOG_LEVEL + 1, "never %d", ++evaluated);
+  log::set_sink(nullptr);
+
+  EXPECT_EQ(evaluated, 0);
+  EXPECT_TRUE(sink._lines.empty());
+}
+
+TEST(LogTest, RingSink)
+{
+  log::ring_sink ring(4, std::chrono::milliseconds(0));
+  capture_sink sink;
+  log::set_sink(&ring);
+
+  for (int i = 0; i < 6; i++)
+  {
+    POSIXCPP_LOG(LOG_ERR, "record %d", i);
+  }
+  log::set_sink(nullptr);
+
+  EXPECT_EQ(ring.drain(sink), 4);
+  EXPECT_EQ(ring.dropped(), 2);
+  ASSERT_EQ(sink._lines.size(), 4);
+  EXPECT_EQ(sink._lines[0], "record 0");
+  EXPECT_EQ(sink._lines[3], "record 3");
+  EXPECT_EQ(ring.drain(sink), 0);
+}
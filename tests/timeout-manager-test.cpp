@@ -0,0 +1,149 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "timeout_manager.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+class TimeoutManagerTest: public ::testing::Test {
+  protected:
+    timeout_manager _manager{1ms};
+
+  public:
+    static void increment_tick(void* tick)
+    {
+      (*((std::atomic<int>*)tick))++;
+    }
+};
+
+TEST_F(TimeoutManagerTest, Fires)
+{
+  std::atomic<int> tick(0);
+  timeout_manager::timeout to(_manager, &TimeoutManagerTest::increment_tick, &tick);
+
+  to.arm(50ms);
+  EXPECT_TRUE(to.armed());
+  EXPECT_EQ(_manager.size(), 1u);
+
+  std::this_thread::sleep_for(milliseconds(30));
+  EXPECT_EQ(tick, 0);
+
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(tick, 1);
+  EXPECT_FALSE(to.armed());
+  EXPECT_FALSE(to.cancel());
+  EXPECT_EQ(_manager.size(), 0u);
+  EXPECT_EQ(_manager.stats().expirations, 1u);
+}
+
+TEST_F(TimeoutManagerTest, CancelBeforeFire)
+{
+  std::atomic<int> tick(0);
+  timeout_manager::timeout to(_manager, &TimeoutManagerTest::increment_tick, &tick);
+
+  for (int i = 0; i < 100000; i++)
+  {
+    to.arm(50ms);
+    EXPECT_TRUE(to.cancel());
+  }
+
+  // the deadlines only move later, the kernel timer is programmed once
+  auto stats = _manager.stats();
+  EXPECT_EQ(stats.arms, 100000u);
+  EXPECT_EQ(stats.cancels, 100000u);
+  EXPECT_LE(stats.settimes, 2u);
+
+  std::this_thread::sleep_for(milliseconds(300));
+  EXPECT_EQ(tick, 0);
+  EXPECT_EQ(_manager.size(), 0u);
+  EXPECT_EQ(_manager.stats().expirations, 0u);
+}
+
+TEST_F(TimeoutManagerTest, RearmLater)
+{
+  std::atomic<int> tick(0);
+  timeout_manager::timeout to(_manager, &TimeoutManagerTest::increment_tick, &tick);
+
+  // the first queue entry surfaces at 30ms and is moved to the new deadline
+  to.arm(30ms);
+  to.arm(100ms);
+  std::this_thread::sleep_for(milliseconds(60));
+  EXPECT_EQ(tick, 0);
+  EXPECT_TRUE(to.armed());
+
+  std::this_thread::sleep_for(milliseconds(80));
+  EXPECT_EQ(tick, 1);
+}
+
+TEST_F(TimeoutManagerTest, RearmEarlier)
+{
+  std::atomic<int> tick(0);
+  timeout_manager::timeout to(_manager, &TimeoutManagerTest::increment_tick, &tick);
+  timeout_manager::timeout late(_manager);
+
+  late.arm(10s);
+  to.arm(5s);
+  to.arm(30ms);
+  std::this_thread::sleep_for(milliseconds(80));
+  EXPECT_EQ(tick, 1);
+  EXPECT_TRUE(late.armed());
+  EXPECT_EQ(_manager.size(), 1u);
+}
+
+TEST_F(TimeoutManagerTest, Order)
+{
+  std::vector<int> order;
+  std::vector<std::unique_ptr<timeout_manager::timeout>> timeouts;
+
+  for (int i = 0; i < 5; i++)
+  {
+    timeouts.emplace_back(new timeout_manager::timeout(_manager, [&order, i](void*) { order.push_back(i); }));
+  }
+  for (int i = 4; i >= 0; i--)
+  {
+    timeouts[i]->arm(milliseconds(10 * (i + 1)));
+  }
+  timeouts[2]->cancel();
+
+  // destroying an armed timeout removes it
+  timeouts[3].reset();
+
+  std::this_thread::sleep_for(milliseconds(150));
+  EXPECT_EQ(order, (std::vector<int>{0, 1, 4}));
+  EXPECT_EQ(_manager.size(), 0u);
+}
+
+TEST_F(TimeoutManagerTest, SlowCallback)
+{
+  std::atomic<bool> running(false);
+  std::atomic<bool> done(false);
+  std::unique_ptr<timeout_manager::timeout> slow(new timeout_manager::timeout(_manager, [&](void*) {
+      running = true;
+      std::this_thread::sleep_for(milliseconds(100));
+      done = true;
+    }));
+  timeout_manager::timeout other(_manager);
+
+  slow->arm(1ms);
+  while (!running)
+  {
+    std::this_thread::yield();
+  }
+
+  // the callback doesn't hold the manager, the other timeouts are armed and cancelled meanwhile
+  auto started = steady_clock::now();
+  other.arm(1s);
+  EXPECT_TRUE(other.cancel());
+  EXPECT_LT(steady_clock::now() - started, 50ms);
+
+  // destroying the timeout waits for its callback
+  slow.reset();
+  EXPECT_TRUE(done);
+}
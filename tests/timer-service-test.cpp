@@ -0,0 +1,176 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "timer_service.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+class TimerServiceTest: public ::testing::Test {
+  protected:
+    timer_service _service{4};
+
+  public:
+    static void increment_tick(void* tick)
+    {
+      (*((std::atomic<int>*)tick))++;
+    }
+};
+
+TEST_F(TimerServiceTest, Fires)
+{
+  EXPECT_EQ(_service.shards(), 4u);
+  EXPECT_LT(_service.local_shard(), 4u);
+
+  std::atomic<int> tick(0);
+  timer_service::timeout to(_service, &TimerServiceTest::increment_tick, &tick);
+  EXPECT_EQ(to.shard(), _service.local_shard());
+
+  to.arm(50ms);
+  EXPECT_TRUE(to.armed());
+
+  std::this_thread::sleep_for(milliseconds(30));
+  EXPECT_EQ(tick, 0);
+  EXPECT_EQ(_service.size(), 1u);
+
+  std::this_thread::sleep_for(milliseconds(50));
+  EXPECT_EQ(tick, 1);
+  EXPECT_FALSE(to.armed());
+  EXPECT_FALSE(to.cancel());
+  EXPECT_EQ(_service.size(), 0u);
+  EXPECT_EQ(_service.stats(to.shard()).expirations, 1u);
+
+  EXPECT_THROW(timer_service::timeout(_service, nullptr, nullptr, 4), std::invalid_argument);
+}
+
+TEST_F(TimerServiceTest, CancelBeforeFire)
+{
+  std::atomic<int> tick(0);
+  timer_service::timeout to(_service, &TimerServiceTest::increment_tick, &tick);
+
+  for (int i = 0; i < 10000; i++)
+  {
+    to.arm(20ms);
+    EXPECT_TRUE(to.cancel());
+  }
+
+  std::this_thread::sleep_for(milliseconds(60));
+  EXPECT_EQ(tick, 0);
+  EXPECT_EQ(_service.size(), 0u);
+
+  auto stats = _service.stats();
+  EXPECT_EQ(stats.arms, 10000u);
+  EXPECT_EQ(stats.cancels, 10000u);
+  EXPECT_EQ(stats.expirations, 0u);
+}
+
+TEST_F(TimerServiceTest, Shards)
+{
+  // every shard fires its own timeouts on its own thread
+  std::mutex mutex;
+  std::vector<std::thread::id> threads(_service.shards());
+  std::atomic<int> tick(0);
+  std::vector<std::unique_ptr<timer_service::timeout>> timeouts;
+
+  for (std::size_t i = 0; i < _service.shards(); i++)
+  {
+    timeouts.emplace_back(new timer_service::timeout(_service, [&, i](void*) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads[i] = std::this_thread::get_id();
+        tick++;
+      }, nullptr, i));
+    timeouts.back()->arm(milliseconds(10));
+  }
+
+  std::this_thread::sleep_for(milliseconds(60));
+  EXPECT_EQ(tick, 4);
+  for (std::size_t i = 0; i < threads.size(); i++)
+  {
+    EXPECT_EQ(_service.stats(i).expirations, 1u);
+    for (std::size_t j = 0; j < i; j++)
+    {
+      EXPECT_NE(threads[i], threads[j]);
+    }
+  }
+}
+
+TEST_F(TimerServiceTest, RemoteCancel)
+{
+  std::atomic<int> tick(0);
+  timer_service::timeout to(_service, &TimerServiceTest::increment_tick, &tick, 1);
+  timer_service::timeout other(_service, &TimerServiceTest::increment_tick, &tick, 2);
+
+  // cancelled from another shard's callback, the cancel goes through the inbox of shard 1
+  timer_service::timeout canceller(_service, [&to](void*) { EXPECT_TRUE(to.cancel()); }, nullptr, 2);
+  to.arm(50ms);
+  other.arm(5s);
+  canceller.arm(10ms);
+
+  std::this_thread::sleep_for(milliseconds(80));
+  EXPECT_EQ(tick, 0);
+  EXPECT_FALSE(to.armed());
+  EXPECT_TRUE(other.armed());
+  EXPECT_EQ(_service.stats(1).cancels, 1u);
+  EXPECT_GE(_service.stats(1).remote, 1u);
+}
+
+TEST_F(TimerServiceTest, Rearm)
+{
+  std::atomic<int> tick(0);
+  std::unique_ptr<timer_service::timeout> victim(new timer_service::timeout(_service, nullptr, nullptr, 0));
+  std::unique_ptr<timer_service::timeout> periodic;
+
+  // a callback re-arming itself and destroying a timeout of its own shard
+  periodic.reset(new timer_service::timeout(_service, [&](void*) {
+      if (++tick < 5)
+      {
+        periodic->arm(5ms);
+      }
+      victim.reset();
+    }, nullptr, 0));
+
+  victim->arm(1s);
+  periodic->arm(5ms);
+  std::this_thread::sleep_for(milliseconds(100));
+  EXPECT_EQ(tick, 5);
+  EXPECT_EQ(victim, nullptr);
+  EXPECT_EQ(_service.size(), 0u);
+}
+
+TEST_F(TimerServiceTest, CrossShardDestroy)
+{
+  std::atomic<int> met(0);
+  std::unique_ptr<timer_service::timeout> victims[2] = {
+    std::unique_ptr<timer_service::timeout>(new timer_service::timeout(_service, nullptr, nullptr, 0)),
+    std::unique_ptr<timer_service::timeout>(new timer_service::timeout(_service, nullptr, nullptr, 1))};
+
+  // the callbacks of shards 0 and 1 destroy each other's timeouts at the same time
+  auto destroy = [&](void* victim) {
+      met++;
+      while (met < 2)
+      {
+        std::this_thread::yield();
+      }
+      static_cast<std::unique_ptr<timer_service::timeout>*>(victim)->reset();
+    };
+  timer_service::timeout first(_service, destroy, &victims[1], 0);
+  timer_service::timeout second(_service, destroy, &victims[0], 1);
+
+  victims[0]->arm(1s);
+  victims[1]->arm(1s);
+  first.arm(10ms);
+  second.arm(10ms);
+
+  std::this_thread::sleep_for(milliseconds(100));
+  EXPECT_EQ(met, 2);
+  EXPECT_EQ(victims[0], nullptr);
+  EXPECT_EQ(victims[1], nullptr);
+  EXPECT_EQ(_service.size(), 0u);
+}
@@ -1,13 +1,27 @@
 // Created by amironenko on 19/11/2020.
 //
+#include <atomic>
 #include <chrono>
 #include <ratio>
 #include <memory>
 #include <functional>
+#include <thread>
+#include <vector>
 
 #include <gtest/gtest.h>
 
+#include <linux/io_uring.h>
+
+#include "precision_dispatcher.h"
 #include "timer.h"
+#include "timer_dispatcher.h"
+#include "timer_epoll.h"
+#include "timer_group.h"
+#include "timer_pool.h"
+#include "timer_registry.h"
+#include "timer_signalfd.h"
+#include "timer_uring.h"
+#include "virtual_clock.h"
 
 using namespace std;
 using namespace chrono;
@@ -43,6 +57,26 @@ class TimerTest: public ::testing::Test {
       (*((int*)tick))++;
     }
 
+    /**
+     * Polls *done* until it holds, a real time test waits for a condition instead of sleeping for an exact count
+     *
+     * @return false if it still does not hold after *timeout*
+     */
+    template <typename Predicate>
+    static bool wait_until(Predicate done, std::chrono::milliseconds timeout = 2s)
+    {
+      auto until = steady_clock::now() + timeout;
+      while (!done())
+      {
+        if (steady_clock::now() > until)
+        {
+          return false;
+        }
+        std::this_thread::sleep_for(1ms);
+      }
+      return true;
+    }
+
     ~TimerTest( )  override {
       // resources cleanup, no exceptions allowed
     }
@@ -53,9 +87,11 @@ TEST_F(TimerTest, GetTimeOut)
   EXPECT_TRUE(true);
   std::chrono::seconds period_sec = 5s;
   std::chrono::nanoseconds period_nsec = 0ns;
+  virtual_clock clock;
 
   std::unique_ptr<timer> tm (
       new timer(
+        clock,
         period_sec,
         period_nsec,
         std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), // callback
@@ -66,13 +102,15 @@ TEST_F(TimerTest, GetTimeOut)
   int max_ticks = 5;
   for(int i = 0; i < max_ticks; i++)
   {
-    sleep(period_sec.count());
+    clock.advance(period_sec - 1ns);
+    EXPECT_EQ(_tick, i);
+    clock.advance(1ns);
     EXPECT_EQ(_tick, i+1);
     cout << "tick: " << _tick << endl;
   }
 
   tm->stop();
-  sleep(period_sec.count());
+  clock.advance(period_sec);
 
   EXPECT_EQ(_tick, max_ticks);
 }
@@ -82,9 +120,11 @@ TEST_F(TimerTest, SuspendResume)
   EXPECT_TRUE(true);
   std::chrono::seconds period_sec = 5s;
   std::chrono::nanoseconds period_nsec = 0ns;
+  virtual_clock clock;
 
   std::unique_ptr<timer> tm (
       new timer(
+        clock,
         period_sec,
         period_nsec,
         std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), // callback
@@ -95,16 +135,20 @@ TEST_F(TimerTest, SuspendResume)
 
   tm->start();
 
-  sleep(1);
+  clock.advance(1s);
 
   tm->suspend();
+  EXPECT_EQ(tm->remaining(), 4s);
 
-  sleep(1);
+  clock.advance(1s);
 
   tm->resume();
 
-  sleep(4);
+  // the suspended second does not count
+  clock.advance(4s - 1ns);
+  EXPECT_EQ(_tick, 0);
 
+  clock.advance(1ns);
   EXPECT_EQ(_tick, 1);
 }
 
@@ -113,10 +157,12 @@ TEST_F(TimerTest, StopStart)
   EXPECT_TRUE(true);
   std::chrono::seconds period_sec = 5s;
   std::chrono::nanoseconds period_nsec = 0ns;
+  virtual_clock clock;
 
   // create a new timer object with timeout of 5s
   std::unique_ptr<timer> tm (
       new timer(
+        clock,
         period_sec,
         period_nsec,
         std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), // callback
@@ -126,7 +172,7 @@ TEST_F(TimerTest, StopStart)
   tm->start();
 
   // wait for 2s
-  sleep(period_sec.count()/2);
+  clock.advance(period_sec/2);
 
   // stop the time, it should reset the timer as well
   tm->stop();
@@ -134,14 +180,14 @@ TEST_F(TimerTest, StopStart)
   // make sure that the timer is not running
   // let's wait for another 4 seconds for the time out
   // and check the _tick counter is not incremented
-  sleep(period_sec.count()/2 + period_sec.count()%2);
+  clock.advance(period_sec/2 + period_sec%2);
   EXPECT_EQ(_tick, 0);
 
   // lets start timer again
   tm->start();
 
   // wait until time-out
-  sleep(period_sec.count() + 1);
+  clock.advance(period_sec);
   // and make sure that _tick is incremented now
   EXPECT_EQ(_tick, 1);
 }
@@ -151,10 +197,12 @@ TEST_F(TimerTest, Reset)
   EXPECT_TRUE(true);
   std::chrono::seconds period_sec = 5s;
   std::chrono::nanoseconds period_nsec = 0ns;
+  virtual_clock clock;
 
   // create a new timer object with timeout of 5s
   std::unique_ptr<timer> tm (
       new timer(
+        clock,
         period_sec,
         period_nsec,
         std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), // callback
@@ -164,15 +212,891 @@ TEST_F(TimerTest, Reset)
   tm->start();
 
   // wait for 2s
-  sleep(period_sec.count()/2);
+  clock.advance(period_sec/2);
 
   // reset timer, means stop() and start()
   tm->reset();
 
+  // the reset has moved the expiry a whole period on
+  clock.advance(period_sec - 1ns);
+  EXPECT_EQ(_tick, 0);
+
   // wait until time-out
-  sleep(period_sec.count() + 1);
+  clock.advance(1ns);
   // and make sure that _tick is incremented now
   EXPECT_EQ(_tick, 1);
 }
 
 
+TEST_F(TimerTest, TimerfdDispatch)
+{
+  std::unique_ptr<timer> tm (
+      new timer(
+        timer::backend::timerfd,
+        0s,
+        100ms,
+        std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), // callback
+       (void*) &_tick )                                                     // pointer to data
+      );
+
+  EXPECT_GE(tm->fd(), 0);
+  EXPECT_EQ(tm->dispatch(), 0u);
+
+  tm->start();
+  std::this_thread::sleep_for(350ms);
+
+  // the expirations are coalesced in the descriptor counter until the next dispatch, a loaded host sees more
+  EXPECT_EQ(_tick, 0);
+  EXPECT_GE(tm->dispatch(), 3u);
+  EXPECT_EQ(_tick, 1);
+
+  tm->stop();
+  std::this_thread::sleep_for(200ms);
+  EXPECT_EQ(tm->dispatch(), 0u);
+  EXPECT_EQ(_tick, 1);
+}
+
+TEST_F(TimerTest, TimerfdEpoll)
+{
+  const int count = 8;
+  std::vector<std::unique_ptr<timer>> timers;
+  timer_epoll epoll;
+
+  for (int i = 0; i < count; i++)
+  {
+    timers.emplace_back(new timer(timer::backend::timerfd, 0s, 100ms,
+          std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick, true));
+    epoll.add(*timers.back());
+    timers.back()->start();
+  }
+
+  // all single shot timers expire at about the same time, one wakeup dispatches the whole batch
+  std::this_thread::sleep_for(150ms);
+  EXPECT_EQ(epoll.dispatch(1s), (size_t)count);
+  EXPECT_EQ(_tick, count);
+
+  EXPECT_EQ(epoll.dispatch(), 0u);
+
+  // the first callback of the batch reads the expiration of the other timer, which is not counted again
+  std::unique_ptr<timer> pair[2];
+  int calls = 0;
+  for (int i = 0; i < 2; i++)
+  {
+    pair[i].reset(new timer(timer::backend::timerfd, 0s, 50ms, [&pair, &calls, i](void*) {
+          if (calls++ == 0)
+          {
+            pair[1 - i]->dispatch();
+          }
+        }, nullptr, true));
+    epoll.add(*pair[i]);
+    pair[i]->start();
+  }
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(epoll.dispatch(1s), 1u);
+  EXPECT_EQ(calls, 2);
+
+  // the first callback of the batch removes and destroys the other timer, which is not dispatched any more
+  calls = 0;
+  for (int i = 0; i < 2; i++)
+  {
+    epoll.remove(*pair[i]);
+    pair[i].reset(new timer(timer::backend::timerfd, 0s, 50ms, [&pair, &calls, &epoll, i](void*) {
+          calls++;
+          epoll.remove(*pair[1 - i]);
+          pair[1 - i].reset();
+        }, nullptr, true));
+  }
+  for (auto& tm: pair)
+  {
+    epoll.add(*tm);
+    tm->start();
+  }
+  std::this_thread::sleep_for(100ms);
+  EXPECT_EQ(epoll.dispatch(1s), 1u);
+  EXPECT_EQ(calls, 1);
+  for (auto& tm: pair)
+  {
+    if (tm)
+    {
+      epoll.remove(*tm);
+    }
+  }
+
+  for (auto& tm: timers)
+  {
+    epoll.remove(*tm);
+  }
+}
+
+TEST_F(TimerTest, DispatcherThread)
+{
+  std::atomic<int> ticks(0);
+  std::atomic<bool> on_caller_thread(false);
+  auto caller = std::this_thread::get_id();
+  timer_dispatcher dispatcher(2);
+
+  EXPECT_EQ(dispatcher.workers(), 2u);
+
+  std::unique_ptr<timer> tm (
+      new timer(
+        dispatcher,
+        0s,
+        100ms,
+        [&](void*) {
+          ticks++;
+          on_caller_thread = on_caller_thread || std::this_thread::get_id() == caller;
+        })
+      );
+
+  // the workers deliver in real time, no more callbacks than elapsed periods
+  auto started = steady_clock::now();
+  tm->start();
+  EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 3; }));
+  tm->stop();
+  auto elapsed = steady_clock::now() - started;
+
+  EXPECT_LE(ticks.load(), elapsed / 100ms);
+  EXPECT_FALSE(on_caller_thread);
+  EXPECT_EQ(dispatcher.dropped(), 0u);
+}
+
+TEST_F(TimerTest, DispatcherSerialised)
+{
+  std::atomic<int> ticks(0);
+  std::atomic<int> active(0);
+  std::atomic<int> overlapped(0);
+  timer_dispatcher dispatcher(4);
+
+  // callbacks outlasting the period, the ticks meanwhile are caught up by the worker holding the timer
+  std::unique_ptr<timer> tm (
+      new timer(
+        dispatcher,
+        0s,
+        1ms,
+        [&](void*) {
+          if (active++ != 0)
+          {
+            overlapped++;
+          }
+          ticks++;
+          std::this_thread::sleep_for(milliseconds(5));
+          active--;
+        })
+      );
+
+  tm->start();
+  EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 20; }));
+  tm->stop();
+  tm.reset();
+
+  EXPECT_EQ(overlapped.load(), 0);
+}
+
+TEST_F(TimerTest, DispatcherRealtime)
+{
+  // the profile is applied as far as the privileges allow
+  timer_dispatcher::realtime_profile profile;
+  profile.cpus = {0};
+  timer_dispatcher dispatcher(profile);
+
+  auto status = dispatcher.realtime();
+  auto stats = dispatcher.self_test(200ms, 1ms);
+  EXPECT_GE(stats.fires + stats.overruns, 190u);
+  EXPECT_GT(stats.fires, 0u);
+  EXPECT_GE(timer_stats::percentile(stats.lateness, 99), timer_stats::percentile(stats.lateness, 50));
+  std::cout << "pinned " << status.pinned << ", scheduled " << status.scheduled << ", locked " << status.locked
+    << ", lateness p99 " << timer_stats::percentile(stats.lateness, 99).count() << "ns, max "
+    << stats.lateness_max.count() << "ns" << std::endl;
+
+  auto plain = timer_dispatcher().realtime();
+  EXPECT_FALSE(plain.pinned || plain.scheduled || plain.locked);
+
+  // a strict profile fails instead of running without real-time guarantees
+  profile.priority = 1000;
+  profile.strict = true;
+  try
+  {
+    timer_dispatcher strict(profile);
+    FAIL() << "SCHED_FIFO priority 1000 is invalid";
+  }
+  catch (const std::system_error& e)
+  {
+    EXPECT_EQ(e.code(), make_error_code(timer::error::realtime_setup_failed));
+  }
+}
+
+TEST_F(TimerTest, OverrunCatchUp)
+{
+  virtual_clock clock;
+  nanoseconds stall{0};
+
+  // a callback advancing the virtual clock runs for that long, the periods it misses are overruns
+  std::unique_ptr<timer> tm (
+      new timer(
+        clock,
+        0s,
+        100ms,
+        [&](void* data) {
+          increment_tick(data);
+          auto duration = stall;
+          stall = 0ns;
+          clock.advance(duration);
+        },
+       (void*) &_tick )                                                     // pointer to data
+      );
+
+  tm->start();
+  stall = 250ms;
+  clock.advance(100ms);
+
+  // by default coalesced periods are reported, but the callback is called once
+  EXPECT_EQ(_tick, 2);
+  EXPECT_EQ(tm->expirations(), 2u);
+  EXPECT_EQ(tm->stats().overruns, 1u);
+
+  tm->set_overrun_policy(timer::overrun_policy::catch_up);
+  stall = 250ms;
+  clock.advance(50ms);
+
+  EXPECT_EQ(tm->expirations(), 2u);
+  EXPECT_EQ(_tick, 5);
+}
+
+TEST_F(TimerTest, PhaseLocked)
+{
+  virtual_clock clock;
+  std::vector<nanoseconds> fires;
+  std::unique_ptr<timer> tm (
+      new timer(
+        clock,
+        0s,
+        100ms,
+        [&](void*) { fires.push_back(clock.now()); })
+      );
+  EXPECT_EQ(tm->clock(), CLOCK_MONOTONIC);
+
+  auto epoch = clock.now() + 50ms;
+
+  // the grid is epoch + k * 100ms, it is kept after reset as well
+  tm->start_at(epoch);
+  clock.advance(260ms);
+  std::vector<nanoseconds> expected = {epoch, epoch + 100ms, epoch + 200ms};
+  EXPECT_EQ(fires, expected);
+
+  // a relative restart would expire at 360ms, the grid one expires at 350ms
+  tm->reset();
+  clock.advance(100ms);
+  ASSERT_EQ(fires.size(), 4u);
+  EXPECT_EQ(fires.back(), epoch + 300ms);
+}
+
+TEST_F(TimerTest, Slack)
+{
+  virtual_clock clock;
+  std::atomic<int> ticks{0};
+  std::vector<std::unique_ptr<timer>> timers;
+
+  for (int i = 0; i < 8; i++)
+  {
+    timers.emplace_back(new timer(clock, 0s, 100ms, [&ticks](void*) { ticks++; }));
+    timers.back()->set_slack(50ms);
+    EXPECT_EQ(timers.back()->slack(), 50ms);
+  }
+
+  auto before = timer::coalescing();
+  auto t0 = clock.now();
+
+  // the deadlines are spread over ~24ms, the slack lets every round of them share one or two wakeups
+  for (auto& tm : timers)
+  {
+    tm->start();
+    clock.advance(3ms);
+  }
+  clock.advance_to(t0 + 560ms);
+
+  for (auto& tm : timers)
+  {
+    tm->stop();
+  }
+
+  auto after = timer::coalescing();
+  auto expirations = after.expirations - before.expirations;
+  auto wakeups = after.wakeups - before.wakeups;
+
+  EXPECT_EQ(ticks.load(), 40);
+  EXPECT_EQ(expirations, 40u);
+  EXPECT_LE(wakeups, 10u);
+  EXPECT_GE(after.saved() - before.saved(), 30u);
+  // a coalesced expiry is late by the slack at most
+  for (auto& tm : timers)
+  {
+    EXPECT_LT(tm->stats().lateness_max, 50ms);
+  }
+}
+
+TEST_F(TimerTest, Group)
+{
+  virtual_clock clock;
+  std::atomic<int> ticks{0};
+  std::vector<std::unique_ptr<timer>> timers;
+  timer_group group;
+
+  for (int i = 0; i < 4; i++)
+  {
+    timers.emplace_back(new timer(clock, 0s, 100ms, [&ticks](void*) { ticks++; }));
+    group.add(*timers.back());
+  }
+  EXPECT_EQ(group.size(), 4u);
+
+  timers[0]->start();
+  auto results = group.start_all();
+  ASSERT_EQ(results.size(), 4u);
+  EXPECT_EQ(results[0], timer::error::start_already_started);
+  for (int i = 1; i < 4; i++)
+  {
+    EXPECT_FALSE(results[i]);
+  }
+
+  // all members share the phase, 4 timers expire twice
+  clock.advance(250ms);
+  EXPECT_EQ(ticks.load(), 8);
+
+  timers[1]->stop();
+  results = group.reset_all();
+  EXPECT_FALSE(results[0]);
+  EXPECT_EQ(results[1], timer::error::stop_while_not_running);
+
+  results = group.set_period_all(0s, 50ms);
+  for (auto& ec : results)
+  {
+    EXPECT_FALSE(ec);
+  }
+
+  ticks = 0;
+  clock.advance(120ms);
+  EXPECT_EQ(ticks.load(), 6);
+
+  results = group.stop_all();
+  EXPECT_FALSE(results[0]);
+  EXPECT_EQ(results[1], timer::error::stop_while_not_running);
+
+  // the stopped member keeps the new period for its next start
+  ticks = 0;
+  timers[1]->start();
+  clock.advance(70ms);
+  timers[1]->stop();
+  EXPECT_EQ(ticks.load(), 1);
+
+  group.remove(*timers[0]);
+  EXPECT_EQ(group.size(), 3u);
+}
+
+TEST_F(TimerTest, ConcurrentStartStop)
+{
+  std::atomic<int> ticks{0};
+  std::atomic<int> failures{0};
+  timer tm(0s, 1ms, [&ticks](void*) { ticks++; });
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++)
+  {
+    threads.emplace_back([&tm, &failures, t]() {
+      for (int i = 0; i < 2000; i++)
+      {
+        auto ec = (i + t) % 2 ? tm.try_stop() : tm.try_start();
+        if (ec && ec != timer::error::start_already_started && ec != timer::error::stop_while_not_running &&
+            ec != timer::error::operation_in_progress)
+        {
+          failures++;
+        }
+      }
+    });
+  }
+  for (auto& th : threads)
+  {
+    th.join();
+  }
+  EXPECT_EQ(failures.load(), 0);
+
+  // whatever the interleaving was, the state matches the kernel timer
+  auto ec = tm.try_stop();
+  EXPECT_TRUE(!ec || ec == timer::error::stop_while_not_running);
+  std::this_thread::sleep_for(5ms);
+  auto stopped = ticks.load();
+  std::this_thread::sleep_for(20ms);
+  EXPECT_EQ(ticks.load(), stopped);
+
+  EXPECT_FALSE(tm.try_start());
+  EXPECT_TRUE(wait_until([&]() { return ticks.load() > stopped; }));
+  EXPECT_FALSE(tm.try_stop());
+}
+
+TEST_F(TimerTest, SingleShotExpiredState)
+{
+  std::atomic<int> ticks{0};
+  timer tm(0s, 10ms, [&ticks](void*) { ticks++; }, nullptr, true);
+
+  tm.start();
+  EXPECT_EQ(tm.try_start(), timer::error::start_already_started);
+  ASSERT_TRUE(wait_until([&ticks]() { return ticks.load() == 1; }));
+
+  // the expiry has moved the timer to the expired state, it can't be suspended but it can be restarted
+  EXPECT_EQ(tm.try_suspend(), timer::error::suspend_while_not_running);
+  EXPECT_FALSE(tm.try_reset());
+  ASSERT_TRUE(wait_until([&ticks]() { return ticks.load() == 2; }));
+
+  EXPECT_FALSE(tm.try_start());
+  EXPECT_FALSE(tm.try_stop());
+  EXPECT_EQ(tm.try_stop(), timer::error::stop_while_not_running);
+  EXPECT_EQ(tm.try_reset(), timer::error::stop_while_not_running);
+}
+
+TEST_F(TimerTest, ErrorCodes)
+{
+  virtual_clock clock;
+  timer tm(clock, 0s, 10ms);
+
+  // the try_ calls report the warnings as codes, the throwing calls throw the same codes
+  EXPECT_EQ(tm.try_stop(), timer::error::stop_while_not_running);
+  EXPECT_EQ(tm.try_reset(), timer::error::stop_while_not_running);
+  EXPECT_EQ(tm.try_suspend(), timer::error::suspend_while_not_running);
+  EXPECT_FALSE(tm.try_resume());
+  try
+  {
+    tm.stop();
+    FAIL();
+  }
+  catch (const std::system_error& e)
+  {
+    EXPECT_EQ(e.code(), timer::error::stop_while_not_running);
+  }
+
+  tm.start();
+  EXPECT_EQ(tm.try_start(), timer::error::start_already_started);
+  EXPECT_EQ(tm.try_resume(), timer::error::resume_already_running);
+  EXPECT_THROW(tm.start(), std::system_error);
+  for (int i = 0; i < 1000; i++)
+  {
+    ASSERT_FALSE(tm.try_reset());
+  }
+  EXPECT_EQ(tm.stats().starts, 1001u);
+
+  // every error has its message, anything else is unknown
+  auto& category = timer::error_category::instance();
+  EXPECT_EQ(make_error_code(timer::error::trace_failed).message(), "trace buffer could not be mapped");
+  EXPECT_EQ(make_error_code(timer::error::unknown_error).message(), "unknown error");
+  EXPECT_EQ(make_error_code(timer::error::operation_in_progress).message(),
+      "another operation on the timer is in progress");
+  EXPECT_EQ(category.message(0), "Unknown error");
+  EXPECT_EQ(category.message(-16), "Unknown error");
+  EXPECT_EQ(category.message(8), "Unknown error");
+  static_assert(timer::error_category::describe(static_cast<int>(timer::error::posix_timer_settime))[0] == 'P',
+      "the messages are known at compile time");
+}
+
+TEST_F(TimerTest, Stats)
+{
+  virtual_clock clock;
+  timer tm(clock, 0s, 10ms, [](void*) { std::this_thread::sleep_for(200us); });
+  auto registered = timer_registry::size();
+  EXPECT_GE(registered, 1u);
+
+  tm.start();
+  clock.advance(50ms);
+  tm.stop();
+
+  // the virtual expiries are exact, only the callback duration is real time
+  auto st = tm.stats();
+  EXPECT_EQ(st.id, static_cast<const void*>(&tm));
+  EXPECT_EQ(st.period, 10ms);
+  EXPECT_EQ(st.starts, 1u);
+  EXPECT_EQ(st.stops, 1u);
+  EXPECT_EQ(st.fires, 5u);
+  EXPECT_EQ(st.overruns, 0u);
+  EXPECT_EQ(st.callbacks, 5u);
+  EXPECT_GE(st.callback_total, 200us * 5);
+  EXPECT_EQ(st.lateness_max, 0ns);
+  EXPECT_EQ(st.lateness[0], 5u);
+
+  std::uint64_t durations = 0;
+  for (std::size_t i = 0; i < timer_stats::buckets; i++)
+  {
+    durations += st.callback_duration[i];
+  }
+  EXPECT_EQ(durations, 5u);
+  EXPECT_GT(st.callback_duration[timer_stats::bucket(st.callback_max)], 0u);
+
+  // the registry sees the same counters, and forgets the timer with its destruction
+  auto found = false;
+  for (auto& entry : timer_registry::snapshot())
+  {
+    if (entry.id == st.id)
+    {
+      found = true;
+      EXPECT_EQ(entry.fires, st.fires);
+    }
+  }
+  EXPECT_TRUE(found);
+
+  {
+    timer other(1s);
+    EXPECT_EQ(timer_registry::size(), registered + 1);
+  }
+  EXPECT_EQ(timer_registry::size(), registered);
+}
+
+TEST_F(TimerTest, RegistryChurn)
+{
+  virtual_clock clock;
+  timer first(clock, 0s, 10ms);
+  auto registered = timer_registry::size();
+  std::atomic<bool> running(true);
+
+  // timers constructed and destroyed on several threads while snapshots are taken
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++)
+  {
+    threads.emplace_back([&clock, &running]() {
+        while (running)
+        {
+          std::vector<std::unique_ptr<timer>> timers;
+          for (int j = 0; j < 50; j++)
+          {
+            timers.emplace_back(new timer(clock, 0s, 10ms));
+          }
+        }
+      });
+  }
+
+  for (int i = 0; i < 200; i++)
+  {
+    auto snapshot = timer_registry::snapshot();
+    ASSERT_FALSE(snapshot.empty());
+    EXPECT_LE(snapshot.size(), registered + 200);
+    for (auto& entry : snapshot)
+    {
+      EXPECT_EQ(entry.period, 10ms);
+    }
+  }
+  running = false;
+  for (auto& t : threads)
+  {
+    t.join();
+  }
+  EXPECT_EQ(timer_registry::size(), registered);
+
+  // the snapshot keeps the construction order, whatever slots the timers got
+  timer second(clock, 0s, 20ms);
+  auto snapshot = timer_registry::snapshot();
+  ASSERT_GE(snapshot.size(), 2u);
+  EXPECT_EQ(snapshot.back().id, static_cast<const void*>(&second));
+}
+
+TEST_F(TimerTest, Precision)
+{
+  precision_dispatcher dispatcher(200us);
+  EXPECT_EQ(dispatcher.spin_window(), 200us);
+  std::atomic<int> ticks{0};
+  std::atomic<bool> off_main{true};
+  auto main_id = std::this_thread::get_id();
+
+  timer tm(dispatcher, 0s, 1ms, [&](void*) {
+      ticks++;
+      off_main = off_main && std::this_thread::get_id() != main_id;
+    }, nullptr, false, CLOCK_MONOTONIC);
+
+  // how punctual the spun out wakeups are depends on the host, bench_precision measures it
+  tm.start();
+  EXPECT_TRUE(wait_until([&ticks]() { return ticks.load() >= 10; }));
+  tm.stop();
+
+  auto st = tm.stats();
+  EXPECT_EQ(static_cast<std::uint64_t>(ticks.load()), st.fires);
+  EXPECT_TRUE(off_main.load());
+  EXPECT_GT(st.spin_total, 0ns);
+
+  // a single shot timer is not delivered if stopped before its deadline, even while it's being spun for
+  dispatcher.set_spin_window(190ms);
+  EXPECT_EQ(dispatcher.spin_window(), 190ms);
+  ticks = 0;
+  timer once(dispatcher, 0s, 200ms, [&ticks](void*) { ticks++; }, nullptr, true, CLOCK_MONOTONIC);
+  auto started = steady_clock::now();
+  once.start();
+  std::this_thread::sleep_for(50ms);
+  once.stop();
+  auto stopped = steady_clock::now() - started;
+  std::this_thread::sleep_for(250ms);
+  if (stopped < 200ms)
+  {
+    EXPECT_EQ(ticks.load(), 0);
+  }
+}
+
+TEST_F(TimerTest, Remaining)
+{
+  // the exact arithmetic is checked on the virtual clock by VirtualClockTest.Remaining, the kernel timer only has
+  // to agree with it without any bound on the scheduling
+  timer tm(0s, 100ms, nullptr, nullptr, false, CLOCK_MONOTONIC);
+  EXPECT_EQ(tm.remaining(), 0ns);
+
+  tm.start();
+  EXPECT_LE(tm.remaining(), 100ms);
+  EXPECT_GT(tm.remaining(), 0ns);
+
+  // the suspended remaining time does not run
+  std::this_thread::sleep_for(30ms);
+  tm.suspend();
+  auto suspended = tm.remaining();
+  EXPECT_LT(suspended, 100ms);
+  std::this_thread::sleep_for(10ms);
+  EXPECT_EQ(tm.remaining(), suspended);
+
+  tm.resume();
+  EXPECT_LE(tm.remaining(), suspended);
+
+  tm.stop();
+  EXPECT_EQ(tm.remaining(), 0ns);
+
+  // an expired single shot timer has nothing left
+  std::atomic<int> ticks{0};
+  timer once(0s, 10ms, [&ticks](void*) { ticks++; }, nullptr, true);
+  once.start();
+  ASSERT_TRUE(wait_until([&ticks]() { return ticks.load() == 1; }));
+  EXPECT_EQ(once.remaining(), 0ns);
+}
+
+TEST_F(TimerTest, Pool)
+{
+  timer_pool pool(2);
+  EXPECT_EQ(pool.capacity(), 2u);
+  EXPECT_EQ(pool.available(), 2u);
+  auto registered = timer_registry::size();
+
+  {
+    timer tm(pool, 0s, 50ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick);
+    timer other(pool, 1s);
+    EXPECT_EQ(pool.available(), 0u);
+
+    // the pooled timers are registered in the slots the pool has reserved
+    EXPECT_EQ(timer_registry::size(), registered + 2);
+    EXPECT_EQ(timer_registry::snapshot().back().id, static_cast<const void*>(&other));
+    EXPECT_EQ(tm.clock(), CLOCK_MONOTONIC);
+
+    try
+    {
+      timer exhausted(pool, 1s);
+      FAIL() << "the pool has no free kernel timer";
+    }
+    catch (const std::system_error& e)
+    {
+      EXPECT_EQ(e.code(), make_error_code(timer::error::pool_exhausted));
+    }
+
+    // the pooled kernel timer runs in real time, no more callbacks than elapsed periods
+    auto started = steady_clock::now();
+    tm.start();
+    EXPECT_TRUE(wait_until([this]() { return _tick >= 3; }));
+    tm.stop();
+    EXPECT_LE(_tick, (steady_clock::now() - started) / 50ms);
+  }
+  EXPECT_EQ(pool.available(), 2u);
+  EXPECT_EQ(timer_registry::size(), registered);
+
+  // a reused kernel timer doesn't deliver anything to its new, idle owner
+  for (int i = 0; i < 100; i++)
+  {
+    timer tm(pool, 0s, 1ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick,
+        true);
+    tm.start();
+  }
+  int ticks = _tick;
+  timer idle(pool, 0s, 1ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick);
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_EQ(_tick, ticks);
+}
+
+TEST_F(TimerTest, PoolStaleSignal)
+{
+  timer_pool pool(1);
+  std::atomic<int> ticks(0);
+
+  // the signal of the first owner stays pending while the kernel timer goes to the second one
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGRTMAX);
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+  {
+    timer first(pool, 0s, 1ms);
+    first.start();
+    std::this_thread::sleep_for(milliseconds(10));
+  }
+
+  timer second(pool, 1s, 0ns, [&ticks](void*) { ticks++; });
+  second.start();
+  pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+  std::this_thread::sleep_for(milliseconds(20));
+  EXPECT_EQ(ticks.load(), 0);
+}
+
+TEST_F(TimerTest, Signalfd)
+{
+  timer_signalfd sfd;
+  std::vector<std::unique_ptr<timer>> timers;
+
+  for (int i = 0; i < 32; i++)
+  {
+    timers.emplace_back(new timer(sfd, 0s, 10ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1),
+          (void*) &_tick, false, CLOCK_MONOTONIC));
+    timers.back()->start();
+  }
+
+  // nothing is delivered until the descriptor is read, the pending signals pile up
+  std::this_thread::sleep_for(milliseconds(105));
+  EXPECT_EQ(_tick, 0);
+
+  // one read delivers the expiration of every timer, the missed periods are reported as overruns
+  EXPECT_EQ(sfd.dispatch(), 32u);
+  EXPECT_EQ(sfd.reads(), 1u);
+  EXPECT_EQ(_tick, 32);
+  for (auto& tm : timers)
+  {
+    EXPECT_GE(tm->expirations(), 5u);
+  }
+
+  EXPECT_GT(sfd.dispatch(50ms), 0u);
+
+  for (auto& tm : timers)
+  {
+    tm->stop();
+  }
+  sfd.dispatch();
+  timers.clear();
+  EXPECT_EQ(sfd.dispatch(20ms), 0u);
+}
+
+TEST_F(TimerTest, SignalfdStaleSignal)
+{
+  timer_signalfd sfd;
+  int stale = 0;
+
+  for (int i = 0; i < 8; i++)
+  {
+    // older kernels keep the expiration of a deleted timer queued, recent ones drop it when it's read
+    std::unique_ptr<timer> gone(new timer(sfd, 0s, 1ms, std::bind(&TimerTest::increment_tick, this,
+          std::placeholders::_1), (void*) &_tick, true, CLOCK_MONOTONIC));
+    gone->start();
+    std::this_thread::sleep_for(10ms);
+    gone.reset();
+
+    // the next timer is likely created at the same address and reuses the slot, it must not receive the signal
+    std::unique_ptr<timer> next(new timer(sfd, 1s, 0ns, std::bind(&TimerTest::increment_tick, this,
+          std::placeholders::_1), (void*) &stale, true, CLOCK_MONOTONIC));
+    EXPECT_EQ(sfd.dispatch(), 0u);
+  }
+
+  EXPECT_EQ(_tick, 0);
+  EXPECT_EQ(stale, 0);
+}
+
+TEST_F(TimerTest, Uring)
+{
+  timer_uring uring;
+  std::vector<std::unique_ptr<timer>> timers;
+
+  for (int i = 0; i < 32; i++)
+  {
+    timers.emplace_back(new timer(uring, 0s, 10ms, std::bind(&TimerTest::increment_tick, this,
+          std::placeholders::_1), (void*) &_tick));
+    timers.back()->start();
+  }
+
+  // the arms are only queued, nothing is submitted until the ring is dispatched
+  EXPECT_EQ(uring.stats().submissions, 0u);
+
+  auto started = steady_clock::now();
+  auto until = started + 105ms;
+  while (steady_clock::now() < until)
+  {
+    uring.dispatch(10ms);
+  }
+  for (auto& tm : timers)
+  {
+    tm->stop();
+  }
+  uring.dispatch();
+  auto elapsed = steady_clock::now() - started;
+
+  // every timer has expired, at most once per elapsed period, with fewer io_uring_enter calls than expirations
+  EXPECT_GE(_tick, 32);
+  EXPECT_LE(_tick, 32 * (elapsed / 10ms));
+  EXPECT_LT(uring.stats().enters, static_cast<std::uint64_t>(_tick));
+
+  // a timer armed and stopped before the flush costs no submission entry
+  auto submissions = uring.stats().submissions;
+  timers.front()->start();
+  timers.front()->stop();
+  timers.clear();
+  uring.dispatch();
+  EXPECT_EQ(uring.stats().submissions, submissions);
+
+  // a dispatch waiting for completions is woken up by a timer started in another thread
+  _tick = 0;
+  timer single(uring, 0s, 5ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick,
+      true);
+  std::thread starter([&single]() {
+      std::this_thread::sleep_for(20ms);
+      single.start();
+  });
+  uring.dispatch(1000ms);
+  starter.join();
+  EXPECT_GE(uring.stats().wakeups, 1u);
+  uring.dispatch(100ms);
+  EXPECT_EQ(_tick, 1);
+  EXPECT_EQ(single.try_suspend(), timer::error::suspend_while_not_running);
+
+  EXPECT_THROW(timer(uring, 1s, 0ns, nullptr, nullptr, false, CLOCK_PROCESS_CPUTIME_ID), std::invalid_argument);
+}
+
+TEST_F(TimerTest, UringShared)
+{
+  timer_uring uring(timer_uring::shared_ring);
+  EXPECT_EQ(uring.fd(), -1);
+  EXPECT_THROW(uring.dispatch(), std::logic_error);
+
+  timer tm(uring, 0s, 10ms, std::bind(&TimerTest::increment_tick, this, std::placeholders::_1), (void*) &_tick);
+  tm.start();
+
+  // the entries go to the application's ring, one at a time here
+  io_uring_sqe sqes[2] = {};
+  std::size_t used = 0;
+  auto one = [&]() -> io_uring_sqe* { return used < 1 ? &sqes[used++] : nullptr; };
+  EXPECT_EQ(uring.prepare(one), 1u);
+  EXPECT_EQ(sqes[0].opcode, IORING_OP_TIMEOUT);
+  EXPECT_EQ(sqes[0].user_data >> 56, timer_uring::user_tag);
+  EXPECT_TRUE(sqes[0].timeout_flags & IORING_TIMEOUT_ABS);
+
+  // the application's own completions are not taken
+  io_uring_cqe cqe = {};
+  cqe.user_data = 42;
+  EXPECT_FALSE(uring.complete(cqe));
+
+  // the expiry completion is delivered and the periodic timer is re-armed
+  cqe.user_data = sqes[0].user_data;
+  cqe.res = -ETIME;
+  EXPECT_TRUE(uring.complete(cqe));
+  EXPECT_EQ(_tick, 1);
+  used = 0;
+  EXPECT_EQ(uring.prepare(one), 1u);
+  EXPECT_EQ(sqes[0].opcode, IORING_OP_TIMEOUT);
+
+  // stopping it removes the timeout in the ring, the stale completion is ignored
+  auto armed = sqes[0].user_data;
+  tm.stop();
+  used = 0;
+  EXPECT_EQ(uring.prepare(one), 1u);
+  EXPECT_EQ(sqes[0].opcode, IORING_OP_TIMEOUT_REMOVE);
+  EXPECT_EQ(sqes[0].addr, armed);
+  cqe.user_data = armed;
+  EXPECT_TRUE(uring.complete(cqe));
+  EXPECT_EQ(_tick, 1);
+}
@@ -0,0 +1,179 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+#include "timer.h"
+#include "trace.h"
+#include "tsc_clock.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+class TimerTraceTest: public ::testing::Test {
+  protected:
+    void TearDown() override
+    {
+      trace::stop();
+    }
+
+  public:
+    static void increment_tick(void* tick)
+    {
+      (*((std::atomic<int>*)tick))++;
+    }
+};
+
+TEST_F(TimerTraceTest, Timeline)
+{
+  trace::start();
+  EXPECT_TRUE(trace::enabled());
+
+  std::atomic<int> tick(0);
+  {
+    timer t(seconds(0), milliseconds(10), &TimerTraceTest::increment_tick, &tick, true);
+    t.start();
+    std::this_thread::sleep_for(milliseconds(50));
+    EXPECT_EQ(tick, 1);
+  }
+  trace::stop();
+  EXPECT_FALSE(trace::enabled());
+
+  // arm, expire, callback begin and end in time order, all of the one timer
+  auto records = trace::snapshot();
+  std::vector<trace::event> events;
+  for (auto& r : records)
+  {
+    EXPECT_EQ(r._id, records.front()._id);
+    EXPECT_LE(records.front()._timestamp, r._timestamp);
+    events.push_back(r._event);
+  }
+  ASSERT_GE(events.size(), 4u);
+  EXPECT_EQ(events[0], trace::event::arm);
+  EXPECT_EQ(records[0]._arg, 10000000u);
+  EXPECT_EQ(events[1], trace::event::expire);
+  EXPECT_EQ(records[1]._arg, 1u);
+  EXPECT_EQ(events[2], trace::event::callback_begin);
+  EXPECT_EQ(events[3], trace::event::callback_end);
+  EXPECT_STREQ(trace::name(events[2]), "callback_begin");
+
+  // stopped tracing records nothing
+  {
+    timer t(seconds(0), milliseconds(1), &TimerTraceTest::increment_tick, &tick, true);
+    t.start();
+    std::this_thread::sleep_for(milliseconds(20));
+  }
+  EXPECT_EQ(trace::snapshot().size(), records.size());
+}
+
+TEST_F(TimerTraceTest, Overwrite)
+{
+  trace::start({4, 2, nullptr});
+
+  int id = 0;
+  for (std::uint64_t i = 0; i < 10; i++)
+  {
+    trace::write(trace::event::expire, &id, i);
+  }
+
+  // the ring keeps the latest events
+  auto records = trace::snapshot();
+  ASSERT_EQ(records.size(), 4u);
+  for (std::uint64_t i = 0; i < 4; i++)
+  {
+    EXPECT_EQ(records[i]._arg, 6 + i);
+  }
+
+  // a thread which has exited hands its ring over to the next one
+  std::thread([&id]() { trace::write(trace::event::arm, &id, 0); }).join();
+  std::thread([&id]() { trace::write(trace::event::arm, &id, 0); }).join();
+  EXPECT_EQ(trace::snapshot().size(), 6u);
+  EXPECT_EQ(trace::dropped(), 0u);
+
+  // a live thread more than rings drops its events
+  std::atomic<bool> done(false);
+  std::thread owner([&id, &done]() {
+      trace::write(trace::event::arm, &id, 0);
+      while (!done.load())
+      {
+        std::this_thread::yield();
+      }
+    });
+  while (trace::snapshot().size() != 7u)
+  {
+    std::this_thread::yield();
+  }
+  std::thread([&id]() { trace::write(trace::event::arm, &id, 0); }).join();
+  done.store(true);
+  owner.join();
+  EXPECT_EQ(trace::snapshot().size(), 7u);
+  EXPECT_EQ(trace::dropped(), 1u);
+
+  // a restart starts an empty buffer
+  trace::start();
+  EXPECT_EQ(trace::snapshot().size(), 0u);
+  EXPECT_EQ(trace::dropped(), 0u);
+}
+
+TEST_F(TimerTraceTest, File)
+{
+  char path[] = "/tmp/posixcpp-trace-XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(fd, -1);
+  close(fd);
+
+  trace::start({16, 4, path});
+  int id = 0;
+  auto before = tsc_clock::now().time_since_epoch().count();
+  trace::write(trace::event::arm, &id, 42);
+  trace::write(trace::event::disarm, &id, 0);
+  auto after = tsc_clock::now().time_since_epoch().count();
+  trace::stop();
+
+  // the file is the buffer itself, readable after the process is gone
+  fd = open(path, O_RDONLY);
+  ASSERT_NE(fd, -1);
+  struct stat st;
+  ASSERT_EQ(fstat(fd, &st), 0);
+  EXPECT_EQ(static_cast<std::size_t>(st.st_size),
+      sizeof(trace::file_header) + 4 * (sizeof(trace::ring_header) + 16 * sizeof(trace::record)));
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ASSERT_NE(data, MAP_FAILED);
+  auto header = static_cast<const trace::file_header*>(data);
+  EXPECT_EQ(memcmp(header->_magic, trace::magic, sizeof(trace::magic)), 0);
+  EXPECT_EQ(header->_capacity, 16u);
+  EXPECT_EQ(header->_threads, 4u);
+  EXPECT_EQ(header->_claimed.load(), 1u);
+  EXPECT_EQ(header->_pid, static_cast<std::uint32_t>(getpid()));
+
+  auto ring = reinterpret_cast<const trace::ring_header*>(header + 1);
+  auto records = reinterpret_cast<const trace::record*>(ring + 1);
+  EXPECT_EQ(ring->_head.load(), 2u);
+  EXPECT_EQ(records[0]._event, trace::event::arm);
+  EXPECT_EQ(records[0]._arg, 42u);
+  EXPECT_EQ(records[0]._id, reinterpret_cast<std::uint64_t>(&id));
+  EXPECT_EQ(records[1]._event, trace::event::disarm);
+
+  // the header converts the raw time stamps, a microsecond covers the rounding of the two calibrations
+  auto ns = static_cast<std::int64_t>(trace::nanoseconds(*header, records[0]._timestamp));
+  EXPECT_GE(ns, before - 1000);
+  EXPECT_LE(ns, after + 1000);
+
+  munmap(data, st.st_size);
+  close(fd);
+  unlink(path);
+
+  EXPECT_THROW(trace::start({16, 4, "/nonexistent/posixcpp.trace"}), std::system_error);
+  EXPECT_FALSE(trace::enabled());
+}
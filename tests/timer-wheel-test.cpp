@@ -0,0 +1,159 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include <gtest/gtest.h>
+
+#include "timer_wheel.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+class TimerWheelTest: public ::testing::Test {
+  protected:
+    timer_wheel _wheel{10ms};
+
+  public:
+    static void increment_tick(void* tick)
+    {
+      (*((int*)tick))++;
+    }
+};
+
+TEST_F(TimerWheelTest, GetTimeOut)
+{
+  int tick = 0;
+  timer_wheel::timer tm(_wheel, 0s, 100ms, &TimerWheelTest::increment_tick, &tick);
+
+  tm.start();
+  EXPECT_EQ(_wheel.size(), 1u);
+
+  std::this_thread::sleep_for(milliseconds(550));
+  tm.stop();
+  EXPECT_EQ(tick, 5);
+  EXPECT_EQ(_wheel.size(), 0u);
+
+  std::this_thread::sleep_for(milliseconds(200));
+  EXPECT_EQ(tick, 5);
+}
+
+TEST_F(TimerWheelTest, SingleShot)
+{
+  int tick = 0;
+  timer_wheel::timer tm(_wheel, 0s, 100ms, &TimerWheelTest::increment_tick, &tick, true);
+
+  tm.start();
+  std::this_thread::sleep_for(milliseconds(350));
+  EXPECT_EQ(tick, 1);
+  EXPECT_EQ(_wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTest, SuspendResume)
+{
+  int tick = 0;
+  timer_wheel::timer tm(_wheel, 0s, 300ms, &TimerWheelTest::increment_tick, &tick, true);
+
+  tm.start();
+  std::this_thread::sleep_for(milliseconds(100));
+  tm.suspend();
+  EXPECT_EQ(tm.try_suspend(), make_error_code(timer::error::suspend_while_not_running));
+
+  std::this_thread::sleep_for(milliseconds(300));
+  EXPECT_EQ(tick, 0);
+
+  tm.resume();
+  std::this_thread::sleep_for(milliseconds(100));
+  EXPECT_EQ(tick, 0);
+  std::this_thread::sleep_for(milliseconds(200));
+  EXPECT_EQ(tick, 1);
+}
+
+TEST_F(TimerWheelTest, Errors)
+{
+  timer_wheel::timer tm(_wheel, 1s);
+
+  EXPECT_EQ(tm.try_stop(), make_error_code(timer::error::stop_while_not_running));
+  EXPECT_FALSE(tm.try_start());
+  EXPECT_EQ(tm.try_start(), make_error_code(timer::error::start_already_started));
+  EXPECT_EQ(tm.try_resume(), make_error_code(timer::error::resume_already_running));
+  EXPECT_FALSE(tm.try_reset());
+  EXPECT_FALSE(tm.try_stop());
+}
+
+TEST_F(TimerWheelTest, ManyTimers)
+{
+  const int count = 10000;
+  int tick = 0;
+  std::vector<std::unique_ptr<timer_wheel::timer>> timers;
+
+  for (int i = 0; i < count; i++)
+  {
+    timers.emplace_back(new timer_wheel::timer(_wheel, 0s, milliseconds(50 + i % 100),
+          &TimerWheelTest::increment_tick, &tick, true));
+    timers.back()->start();
+  }
+  EXPECT_EQ(_wheel.size(), (size_t)count);
+
+  // cancel every other timer before it fires
+  for (int i = 0; i < count; i += 2)
+  {
+    timers[i]->stop();
+  }
+
+  std::this_thread::sleep_for(milliseconds(400));
+  EXPECT_EQ(tick, count / 2);
+  EXPECT_EQ(_wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTest, Cascade)
+{
+  // 600 ticks at 1ms resolution is beyond the first level of 256 slots
+  timer_wheel wheel(1ms);
+  int tick = 0;
+  timer_wheel::timer tm(wheel, 0s, 600ms, &TimerWheelTest::increment_tick, &tick, true);
+
+  tm.start();
+  std::this_thread::sleep_for(milliseconds(500));
+  EXPECT_EQ(tick, 0);
+  std::this_thread::sleep_for(milliseconds(300));
+  EXPECT_EQ(tick, 1);
+}
+
+TEST_F(TimerWheelTest, MergedTicks)
+{
+  timer_wheel wheel(1ms);
+  std::atomic<int> tick(0);
+  std::atomic<long> fired(0);
+  auto t0 = steady_clock::now();
+  timer_wheel::timer tm(wheel, 0s, 100ms, [&](void*) {
+      fired = duration_cast<milliseconds>(steady_clock::now() - t0).count();
+      tick++;
+    }, nullptr, true);
+
+  tm.start();
+  std::this_thread::sleep_for(milliseconds(10));
+
+  // the ticks missed while the signal is blocked arrive as a single signal, the wheel must not fall behind by them;
+  // the test thread is the only one of the process, blocking the signal here holds its delivery back
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIGRTMAX);
+  pthread_sigmask(SIG_BLOCK, &set, nullptr);
+  std::this_thread::sleep_for(milliseconds(60));
+  pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+
+  // about 100ms, without the merged ticks it would be 160ms and more
+  while (tick == 0 && steady_clock::now() - t0 < 1s)
+  {
+    std::this_thread::sleep_for(milliseconds(1));
+  }
+  EXPECT_EQ(tick, 1);
+  EXPECT_GE(fired, 100);
+  EXPECT_LT(fired, 150);
+}
@@ -0,0 +1,122 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <time.h>
+
+#include "tsc_clock.h"
+
+using namespace std::chrono;
+using namespace std::chrono_literals;
+using namespace posixcpp;
+
+namespace
+{
+  nanoseconds monotonic()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+  }
+} // namespace
+
+TEST(TscClockTest, Steady)
+{
+  static_assert(tsc_clock::is_steady, "tsc_clock must be steady");
+
+  auto previous = tsc_clock::now();
+  for (int i = 0; i < 1000000; i++)
+  {
+    auto now = tsc_clock::now();
+    ASSERT_GE(now, previous);
+    previous = now;
+  }
+}
+
+TEST(TscClockTest, TracksMonotonic)
+{
+  // the first calibration happens a few milliseconds after the first read
+  tsc_clock::now();
+  std::this_thread::sleep_for(20ms);
+  tsc_clock::now();
+
+  for (int i = 0; i < 5; i++)
+  {
+    auto before = monotonic();
+    auto now = tsc_clock::now().time_since_epoch();
+    auto after = monotonic();
+
+    EXPECT_GE(now, before - 20us);
+    EXPECT_LE(now, after + 20us);
+    std::this_thread::sleep_for(10ms);
+  }
+
+  if (tsc_clock::uses_tsc())
+  {
+    EXPECT_GT(tsc_clock::frequency(), 1e6);
+  }
+}
+
+TEST(TscClockTest, Recalibrate)
+{
+  tsc_clock::now();
+  std::this_thread::sleep_for(20ms);
+
+  // a recalibration keeps the clock continuous and on CLOCK_MONOTONIC
+  auto before = tsc_clock::now();
+  tsc_clock::recalibrate();
+  auto after = tsc_clock::now();
+  EXPECT_GE(after, before);
+  EXPECT_LT(after - before, 1ms);
+
+  auto delta = tsc_clock::now().time_since_epoch() - monotonic();
+  EXPECT_LT(delta < 0ns ? -delta : delta, 20us);
+}
+
+TEST(TscClockTest, ConcurrentRecalibrate)
+{
+  tsc_clock::now();
+  std::this_thread::sleep_for(20ms);
+
+  // readers on either calibration slot never see the clock going backwards, across threads either
+  std::atomic<std::int64_t> latest(0);
+  std::atomic<bool> running(true);
+  std::atomic<int> backwards(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; i++)
+  {
+    readers.emplace_back([&]() {
+        while (running.load())
+        {
+          auto seen = latest.load();
+          auto now = tsc_clock::now().time_since_epoch().count();
+          if (now < seen)
+          {
+            backwards++;
+          }
+          while (seen < now && !latest.compare_exchange_weak(seen, now))
+          {
+          }
+        }
+      });
+  }
+
+  for (int i = 0; i < 200; i++)
+  {
+    tsc_clock::recalibrate();
+    std::this_thread::sleep_for(100us);
+  }
+  running.store(false);
+  for (auto& t : readers)
+  {
+    t.join();
+  }
+  EXPECT_EQ(backwards.load(), 0);
+
+  auto delta = tsc_clock::now().time_since_epoch() - monotonic();
+  EXPECT_LT(delta < 0ns ? -delta : delta, 20us);
+}
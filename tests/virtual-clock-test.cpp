@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "timer.h"
+#include "timer_group.h"
+#include "virtual_clock.h"
+
+using namespace std;
+using namespace chrono;
+using namespace posixcpp;
+
+class VirtualClockTest: public ::testing::Test {
+  protected:
+    virtual_clock _clock;
+    std::vector<std::pair<int, nanoseconds>> _fires;  /**< timer and virtual time of every callback */
+
+  public:
+    timer::callback_t record(int id)
+    {
+      return [this, id](void*) { _fires.emplace_back(id, _clock.now()); };
+    }
+};
+
+TEST_F(VirtualClockTest, DeadlineOrder)
+{
+  auto t0 = _clock.now();
+  timer a(_clock, 0s, 30ms, record(1));
+  timer b(_clock, 0s, 20ms, record(2));
+  timer c(_clock, 0s, 20ms, record(3), nullptr, true);
+
+  a.start();
+  b.start();
+  c.start();
+  EXPECT_EQ(_clock.size(), 3u);
+  EXPECT_EQ(_clock.next_deadline(), t0 + 20ms);
+
+  // b and c are due at the same instant, in the order they have been armed
+  EXPECT_EQ(_clock.advance(60ms), 6u);
+  std::vector<std::pair<int, nanoseconds>> expected = {
+    {2, t0 + 20ms}, {3, t0 + 20ms}, {1, t0 + 30ms}, {2, t0 + 40ms}, {1, t0 + 60ms}, {2, t0 + 60ms}};
+  EXPECT_EQ(_fires, expected);
+  EXPECT_EQ(_clock.now(), t0 + 60ms);
+  EXPECT_EQ(_clock.size(), 2u);
+
+  a.stop();
+  b.stop();
+  EXPECT_EQ(_clock.size(), 0u);
+  EXPECT_EQ(_clock.next_deadline(), nanoseconds::max());
+  EXPECT_EQ(_clock.advance(1s), 0u);
+
+  auto st = _clock.stats();
+  EXPECT_EQ(st.advances, 2u);
+  EXPECT_EQ(st.deliveries, 6u);
+  EXPECT_EQ(st.expirations, 6u);
+}
+
+TEST_F(VirtualClockTest, Overrun)
+{
+  int calls = 0;
+  std::unique_ptr<timer> tm;
+
+  // the first callback runs for 350ms, the periods at 200, 300 and 400ms are one overrun expiry
+  tm.reset(new timer(_clock, 0s, 100ms, [&](void*) {
+      if (++calls == 1)
+      {
+        _clock.advance(350ms);
+      }
+    }));
+  auto t0 = _clock.now();
+  tm->start();
+
+  EXPECT_EQ(_clock.advance(100ms), 2u);
+  EXPECT_EQ(_clock.now(), t0 + 450ms);
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(tm->expirations(), 3u);
+
+  auto st = tm->stats();
+  EXPECT_EQ(st.fires, 2u);
+  EXPECT_EQ(st.overruns, 2u);
+  EXPECT_EQ(st.lateness_max, 50ms);
+
+  // catching up calls the callback once per period, the grid is kept
+  tm->set_overrun_policy(timer::overrun_policy::catch_up);
+  calls = 0;
+  EXPECT_EQ(_clock.advance(50ms), 2u);
+  EXPECT_EQ(_clock.now(), t0 + 850ms);
+  EXPECT_EQ(calls, 4);
+  EXPECT_EQ(tm->expirations(), 3u);
+}
+
+TEST_F(VirtualClockTest, NestedOthers)
+{
+  // other timers fire while a callback advances the clock
+  timer slow(_clock, 0s, 10ms, [this](void*) {
+      _fires.emplace_back(1, _clock.now());
+      _clock.advance(25ms);
+    }, nullptr, true);
+  timer fast(_clock, 0s, 10ms, record(2));
+  auto t0 = _clock.now();
+
+  slow.start();
+  fast.start();
+  _clock.advance(10ms);
+
+  std::vector<std::pair<int, nanoseconds>> expected = {
+    {1, t0 + 10ms}, {2, t0 + 10ms}, {2, t0 + 20ms}, {2, t0 + 30ms}};
+  EXPECT_EQ(_fires, expected);
+  EXPECT_EQ(_clock.now(), t0 + 35ms);
+}
+
+TEST_F(VirtualClockTest, PhaseLocked)
+{
+  auto epoch = _clock.now() + 50ms;
+  timer tm(_clock, 0s, 100ms, record(1));
+
+  // the grid is epoch + k * 100ms, it is kept after reset as well
+  tm.start_at(epoch);
+  _clock.advance(260ms);
+  EXPECT_EQ(_fires.size(), 3u);
+
+  tm.reset();
+  _clock.advance(90ms);
+  ASSERT_EQ(_fires.size(), 4u);
+  EXPECT_EQ(_fires.back().second, epoch + 300ms);
+
+  // a resume continues at the next grid deadline as well
+  tm.suspend();
+  _clock.advance(130ms);
+  tm.resume();
+  EXPECT_EQ(_clock.next_deadline(), epoch + 500ms);
+}
+
+TEST_F(VirtualClockTest, Remaining)
+{
+  timer tm(_clock, 0s, 100ms);
+  EXPECT_EQ(tm.remaining(), 0ns);
+
+  tm.start();
+  EXPECT_EQ(tm.remaining(), 100ms);
+
+  _clock.advance(30ms);
+  EXPECT_EQ(tm.remaining(), 70ms);
+
+  // the suspended remaining time does not run
+  tm.suspend();
+  _clock.advance(10ms);
+  EXPECT_EQ(tm.remaining(), 70ms);
+
+  tm.resume();
+  EXPECT_EQ(tm.remaining(), 70ms);
+  _clock.advance(90ms);
+  EXPECT_EQ(tm.remaining(), 80ms);
+
+  tm.stop();
+  EXPECT_EQ(tm.remaining(), 0ns);
+}
+
+TEST_F(VirtualClockTest, SingleShotExpiredState)
+{
+  timer tm(_clock, 0s, 10ms, record(1), nullptr, true);
+
+  tm.start();
+  EXPECT_EQ(tm.try_start(), timer::error::start_already_started);
+  _clock.advance(30ms);
+  EXPECT_EQ(_fires.size(), 1u);
+
+  // the expiry has moved the timer to the expired state, it can't be suspended but it can be restarted
+  EXPECT_EQ(tm.try_suspend(), timer::error::suspend_while_not_running);
+  EXPECT_FALSE(tm.try_reset());
+  _clock.advance(30ms);
+  EXPECT_EQ(_fires.size(), 2u);
+
+  EXPECT_FALSE(tm.try_start());
+  EXPECT_FALSE(tm.try_stop());
+  EXPECT_EQ(tm.try_stop(), timer::error::stop_while_not_running);
+  EXPECT_EQ(tm.try_reset(), timer::error::stop_while_not_running);
+}
+
+TEST_F(VirtualClockTest, CallbackControl)
+{
+  std::unique_ptr<timer> victim(new timer(_clock, 0s, 50ms, record(2)));
+  std::unique_ptr<timer> periodic;
+
+  // a callback stopping itself, restarting and destroying other timers
+  periodic.reset(new timer(_clock, 0s, 10ms, [&](void*) {
+      _fires.emplace_back(1, _clock.now());
+      if (_fires.size() == 3)
+      {
+        periodic->stop();
+        victim.reset();
+      }
+    }));
+  victim->start();
+  periodic->start();
+
+  _clock.advance(100ms);
+  EXPECT_EQ(_fires.size(), 3u);
+  EXPECT_EQ(victim, nullptr);
+  EXPECT_EQ(_clock.size(), 0u);
+
+  // an exception leaves the virtual time at the deadline of the throwing timer
+  auto t0 = _clock.now();
+  timer thrower(_clock, 0s, 10ms, [](void*) { throw std::runtime_error("callback"); }, nullptr, true);
+  thrower.start();
+  EXPECT_THROW(_clock.advance(1s), std::runtime_error);
+  EXPECT_EQ(_clock.now(), t0 + 10ms);
+}
+
+TEST_F(VirtualClockTest, Group)
+{
+  std::deque<timer> timers;
+  timer_group group;
+
+  for (int i = 0; i < 4; i++)
+  {
+    timers.emplace_back(_clock, 0s, 10ms * (i + 1), record(i));
+    group.add(timers.back());
+  }
+
+  // the group arms its virtual timers on the virtual time
+  group.start_all();
+  _clock.advance(40ms);
+  EXPECT_EQ(_fires.size(), 4u + 2u + 1u + 1u);
+  group.stop_all();
+  EXPECT_EQ(_clock.size(), 0u);
+}
+
+TEST_F(VirtualClockTest, Scenarios)
+{
+  // thousands of timers with random periods, stopped and restarted at random, against a model of their deadlines
+  constexpr int timers = 2000;
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<int> period(1, 1000);
+  std::uniform_int_distribution<int> step(0, 500);
+  std::uniform_int_distribution<int> action(0, 99);
+
+  std::deque<timer> tms;
+  std::vector<nanoseconds> periods;
+  std::vector<nanoseconds> deadlines;         /**< model, 0 when stopped */
+  std::vector<std::uint64_t> fired(timers);
+  std::vector<std::uint64_t> expected(timers);
+  nanoseconds last{0};
+  bool ordered = true;
+
+  for (int i = 0; i < timers; i++)
+  {
+    periods.push_back(microseconds(period(rng)));
+    deadlines.push_back(_clock.now() + periods.back());
+    tms.emplace_back(_clock, 0s, periods.back(), [&, i](void*) {
+        fired[i]++;
+        ordered = ordered && _clock.now() >= last;
+        last = _clock.now();
+      }, nullptr, i % 3 == 0);
+    tms.back().start();
+  }
+
+  for (int round = 0; round < 200; round++)
+  {
+    auto now = _clock.now() + microseconds(step(rng));
+    for (int i = 0; i < timers; i++)
+    {
+      while (deadlines[i].count() != 0 && deadlines[i] <= now)
+      {
+        expected[i]++;
+        deadlines[i] = i % 3 == 0 ? nanoseconds(0) : deadlines[i] + periods[i];
+      }
+    }
+    _clock.advance_to(now);
+
+    // stop or restart a few of them
+    for (int i = 0; i < timers; i++)
+    {
+      auto a = action(rng);
+      if (a == 0 && deadlines[i].count() != 0)
+      {
+        tms[i].stop();
+        deadlines[i] = nanoseconds(0);
+      }
+      else if (a == 1 && deadlines[i].count() == 0)
+      {
+        tms[i].start();
+        deadlines[i] = now + periods[i];
+      }
+    }
+  }
+
+  EXPECT_TRUE(ordered);
+  EXPECT_EQ(fired, expected);
+  EXPECT_GT(_clock.stats().deliveries, 100000u);
+}
@@ -0,0 +1,47 @@
+/* Local headers */
+#include "coalescer.h"
+
+namespace posixcpp
+{
+  std::atomic<std::uint64_t> coalescer::_expirations(0);
+  std::atomic<std::uint64_t> coalescer::_wakeups(0);
+  std::atomic<std::int64_t> coalescer::_last(-1);
+
+  std::chrono::nanoseconds coalescer::granularity(std::chrono::nanoseconds slack) noexcept
+  {
+    if (slack.count() <= 0)
+    {
+      return std::chrono::nanoseconds(1);
+    }
+
+    // power of two steps nest, timers with different slack still share the coarser grid points
+    auto step = std::uint64_t(1) << (63 - __builtin_clzll(static_cast<std::uint64_t>(slack.count())));
+    return std::chrono::nanoseconds(static_cast<std::int64_t>(step));
+  }
+
+  std::chrono::nanoseconds coalescer::align(std::chrono::nanoseconds deadline, std::chrono::nanoseconds slack) noexcept
+  {
+    auto step = granularity(slack).count();
+    auto rest = deadline.count() % step;
+    return rest ? deadline + std::chrono::nanoseconds(step - rest) : deadline;
+  }
+
+  void coalescer::record(std::chrono::nanoseconds instant, std::uint64_t expirations) noexcept
+  {
+    _expirations.fetch_add(expirations, std::memory_order_relaxed);
+
+    // expirations are delivered in deadline order, every change of the instant is a separate wakeup
+    if (_last.exchange(instant.count(), std::memory_order_relaxed) != instant.count())
+    {
+      _wakeups.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  timer::coalescing_stats coalescer::stats() noexcept
+  {
+    timer::coalescing_stats s;
+    s.expirations = _expirations.load(std::memory_order_relaxed);
+    s.wakeups = _wakeups.load(std::memory_order_relaxed);
+    return s;
+  }
+} // namespace posixcpp
@@ -0,0 +1,41 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/* Local headers */
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Aligns the deadlines of timers with slack to a shared grid and accounts the wakeups saved.
+   * All members are lock-free and async-signal-safe, they are used from the timer signal handler.
+   */
+  class coalescer
+  {
+    static std::atomic<std::uint64_t> _expirations;
+    static std::atomic<std::uint64_t> _wakeups;
+    static std::atomic<std::int64_t> _last;   /**< the last wakeup instant */
+
+    public:
+    /**
+     * @return the grid step used for *slack*, the largest power of two nanoseconds not above it
+     */
+    static std::chrono::nanoseconds granularity(std::chrono::nanoseconds slack) noexcept;
+
+    /**
+     * @return the first grid point at or after *deadline*, it's at most *slack* later
+     */
+    static std::chrono::nanoseconds align(std::chrono::nanoseconds deadline, std::chrono::nanoseconds slack) noexcept;
+
+    /**
+     * Accounts *expirations* delivered by a wakeup at *instant*.
+     */
+    static void record(std::chrono::nanoseconds instant, std::uint64_t expirations) noexcept;
+
+    static timer::coalescing_stats stats() noexcept;
+  };
+} // namespace posixcpp
@@ -0,0 +1,257 @@
+/* STL C++ headers */
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+/* Local headers */
+#include "log.h"
+#include "mpmc_ring.h"
+
+namespace posixcpp
+{
+  namespace log
+  {
+    class ring_sink::ring_sink_
+    {
+      mpmc_ring<record> _ring;
+      std::atomic<std::uint64_t> _dropped;
+      std::mutex _mutex;                        /**< serialises the consumers */
+      std::atomic<bool> _running;
+      std::chrono::milliseconds _drain_interval;
+      std::thread _thread;
+
+      public:
+      ring_sink_(std::size_t capacity, std::chrono::milliseconds drain_interval) :
+        _ring(capacity),
+        _dropped(0),
+        _running(drain_interval.count() > 0),
+        _drain_interval(drain_interval)
+      {
+        if (_running)
+        {
+          _thread = std::thread([this]() {
+              while (_running.load())
+              {
+                syslog_sink to;
+                drain(to);
+                std::this_thread::sleep_for(_drain_interval);
+              }
+            });
+        }
+      }
+
+      ~ring_sink_()
+      {
+        _running.store(false);
+        if (_thread.joinable())
+        {
+          _thread.join();
+        }
+
+        syslog_sink to;
+        drain(to);
+      }
+
+      void write(const record& r) noexcept
+      {
+        if (!_ring.push(r))
+        {
+          _dropped++;
+        }
+      }
+
+      std::size_t drain(sink& to) noexcept
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        std::size_t n = 0;
+        record r;
+
+        while (_ring.pop(r))
+        {
+          to.write(r);
+          n++;
+        }
+        return n;
+      }
+
+      std::uint64_t dropped() const noexcept
+      {
+        return _dropped.load();
+      }
+    };
+
+    namespace
+    {
+      std::atomic<sink*> _current(nullptr);
+
+      void append(char* buf, std::size_t size, std::size_t& pos, const char* str) noexcept
+      {
+        while (*str && pos + 1 < size)
+        {
+          buf[pos++] = *str++;
+        }
+      }
+
+      void append_arg(char* buf, std::size_t size, std::size_t& pos, char conversion, const arg& a) noexcept
+      {
+        char tmp[32];
+
+        switch (a._type)
+        {
+          case arg::type::string:
+            append(buf, size, pos, a._string ? a._string : "(null)");
+            return;
+          case arg::type::error:
+            // error messages are rendered by their category, only here, out of the hot path
+            try
+            {
+              append(buf, size, pos, a._category->message(a._code).c_str());
+            }
+            catch (...)
+            {
+              append(buf, size, pos, "(unknown error)");
+            }
+            return;
+          case arg::type::pointer:
+            snprintf(tmp, sizeof(tmp), "%p", a._pointer);
+            break;
+          case arg::type::integer:
+            if (conversion == 'x' || conversion == 'X')
+            {
+              snprintf(tmp, sizeof(tmp), conversion == 'x' ? "%llx" : "%llX", static_cast<unsigned long long>(a._integer));
+            }
+            else
+            {
+              snprintf(tmp, sizeof(tmp), "%lld", a._integer);
+            }
+            break;
+          case arg::type::unsigned_integer:
+            if (conversion == 'x' || conversion == 'X' || conversion == 'p')
+            {
+              snprintf(tmp, sizeof(tmp), conversion == 'X' ? "%llX" : "%llx", a._unsigned);
+            }
+            else
+            {
+              snprintf(tmp, sizeof(tmp), "%llu", a._unsigned);
+            }
+            break;
+        }
+
+        append(buf, size, pos, tmp);
+      }
+
+      ring_sink& default_sink() noexcept
+      {
+        // never destroyed, timers with static storage duration may still log while the process exits
+        static ring_sink* instance = []() {
+            auto s = new ring_sink();
+            std::atexit([]() { static_cast<ring_sink&>(default_sink()).drain(); });
+            return s;
+          }();
+        return *instance;
+      }
+    } // namespace
+
+    std::size_t format(const record& r, char* buf, std::size_t size) noexcept
+    {
+      std::size_t pos = 0;
+      std::size_t argi = 0;
+
+      if (size == 0)
+      {
+        return 0;
+      }
+
+      for (auto p = r._format; *p && pos + 1 < size; p++)
+      {
+        if (*p != '%')
+        {
+          buf[pos++] = *p;
+          continue;
+        }
+
+        p++;
+        if (*p == '%')
+        {
+          buf[pos++] = '%';
+          continue;
+        }
+
+        // flags, width and length modifiers do not change the rendering of the stored arguments
+        while (*p && std::strchr("-+ #0123456789.hlzjt", *p))
+        {
+          p++;
+        }
+
+        if (!*p)
+        {
+          break;
+        }
+
+        if (argi < r._argc)
+        {
+          append_arg(buf, size, pos, *p, r._args[argi++]);
+        }
+      }
+
+      buf[pos] = '\0';
+      return pos;
+    }
+
+    void syslog_sink::write(const record& r) noexcept
+    {
+      char buf[512];
+      format(r, buf, sizeof(buf));
+      syslog(r._level, "%s", buf);
+    }
+
+    ring_sink::ring_sink(std::size_t capacity, std::chrono::milliseconds drain_interval) :
+      _sink(new ring_sink_(capacity, drain_interval))
+    {}
+
+    ring_sink::~ring_sink()
+    {}
+
+    void ring_sink::write(const record& r) noexcept
+    {
+      _sink->write(r);
+    }
+
+    std::size_t ring_sink::drain() noexcept
+    {
+      syslog_sink to;
+      return _sink->drain(to);
+    }
+
+    std::size_t ring_sink::drain(sink& to) noexcept
+    {
+      return _sink->drain(to);
+    }
+
+    std::uint64_t ring_sink::dropped() const noexcept
+    {
+      return _sink->dropped();
+    }
+
+    void set_sink(sink* s) noexcept
+    {
+      _current.store(s);
+    }
+
+    void prepare_default_sink() noexcept
+    {
+      default_sink();
+    }
+
+    sink& current_sink() noexcept
+    {
+      auto s = _current.load(std::memory_order_acquire);
+      return s ? *s : default_sink();
+    }
+
+  } // namespace log
+} // namespace posixcpp
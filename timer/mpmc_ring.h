@@ -0,0 +1,137 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace posixcpp
+{
+  /**
+   * Bounded multiple producer, multiple consumer ring buffer.
+   * Every cell carries a sequence number, so push and pop are lock-free and only touch atomics, which makes push safe
+   * in signal context. The capacity is rounded up to a power of two.
+   */
+  template <typename T>
+  class mpmc_ring
+  {
+    struct cell
+    {
+      std::atomic<std::size_t> _sequence;
+      T _value;
+    };
+
+    std::unique_ptr<cell[]> _cells;
+    std::size_t _mask;
+    alignas(64) std::atomic<std::size_t> _enqueue;
+    alignas(64) std::atomic<std::size_t> _dequeue;
+
+    static std::size_t round_up(std::size_t n) noexcept
+    {
+      std::size_t size = 2;
+      while (size < n)
+      {
+        size <<= 1;
+      }
+      return size;
+    }
+
+    public:
+    explicit mpmc_ring(std::size_t capacity) :
+      _cells(new cell[round_up(capacity)]),
+      _mask(round_up(capacity) - 1),
+      _enqueue(0),
+      _dequeue(0)
+    {
+      for (std::size_t i = 0; i <= _mask; i++)
+      {
+        _cells[i]._sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+
+    mpmc_ring(const mpmc_ring&) = delete;
+    mpmc_ring(mpmc_ring&&) = delete;
+    mpmc_ring& operator=(const mpmc_ring&) = delete;
+    mpmc_ring& operator=(mpmc_ring&&) = delete;
+
+    /**
+     * @return false if the ring is full
+     */
+    bool push(const T& value) noexcept
+    {
+      auto pos = _enqueue.load(std::memory_order_relaxed);
+      cell* c;
+
+      while (true)
+      {
+        c = &_cells[pos & _mask];
+        auto seq = c->_sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+
+        if (diff == 0)
+        {
+          if (_enqueue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = _enqueue.load(std::memory_order_relaxed);
+        }
+      }
+
+      c->_value = value;
+      c->_sequence.store(pos + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * @return false if the ring is empty
+     */
+    bool pop(T& value) noexcept
+    {
+      auto pos = _dequeue.load(std::memory_order_relaxed);
+      cell* c;
+
+      while (true)
+      {
+        c = &_cells[pos & _mask];
+        auto seq = c->_sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos + 1);
+
+        if (diff == 0)
+        {
+          if (_dequeue.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+          {
+            break;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false;
+        }
+        else
+        {
+          pos = _dequeue.load(std::memory_order_relaxed);
+        }
+      }
+
+      value = std::move(c->_value);
+      c->_sequence.store(pos + _mask + 1, std::memory_order_release);
+      return true;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+      return _mask + 1;
+    }
+  }; // class mpmc_ring
+
+} // namespace posixcpp
@@ -0,0 +1,29 @@
+/* Local headers */
+#include "precision_dispatcher.h"
+#include "precision_dispatcher_.h"
+
+namespace posixcpp
+{
+  precision_dispatcher::precision_dispatcher(std::chrono::nanoseconds spin_window, int cpu, int sig) :
+    _dispatcher(new precision_dispatcher_(spin_window, cpu, sig))
+  {}
+
+  precision_dispatcher::~precision_dispatcher()
+  {}
+
+  void precision_dispatcher::set_spin_window(std::chrono::nanoseconds spin_window) noexcept
+  {
+    _dispatcher->set_spin_window(spin_window);
+  }
+
+  std::chrono::nanoseconds precision_dispatcher::spin_window() const noexcept
+  {
+    return _dispatcher->spin_window();
+  }
+
+  int precision_dispatcher::cpu() const noexcept
+  {
+    return _dispatcher->cpu();
+  }
+
+} //namespace posixcpp
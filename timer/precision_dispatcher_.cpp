@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "precision_dispatcher_.h"
+#include "timer_.h"
+
+namespace posixcpp
+{
+  precision_dispatcher::precision_dispatcher_::precision_dispatcher_(std::chrono::nanoseconds spin_window, int cpu,
+      int sig) :
+    _signal(sig),
+    _cpu(cpu),
+    _running(true),
+    _tid(0),
+    _spin_window(std::max(spin_window, std::chrono::nanoseconds(0)).count())
+  {
+    POSIXCPP_LOG(LOG_INFO, "precision_dispatcher_ ctor spin window %ld ns, cpu %d, signal %d",
+        (long)spin_window.count(), cpu, sig);
+
+    _thread = std::thread(&precision_dispatcher_::run, this);
+
+    if (_cpu != any_cpu)
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(_cpu, &set);
+      if (pthread_setaffinity_np(_thread.native_handle(), sizeof(set), &set) != 0)
+      {
+        // restricted cpuset, the thread simply floats
+        POSIXCPP_LOG(LOG_WARNING, "precision_dispatcher_ can't pin the thread to core %d", _cpu);
+        _cpu = any_cpu;
+      }
+    }
+
+    // timers can't be targeted at the dispatcher thread until its kernel thread id is known
+    while (_tid.load() == 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  precision_dispatcher::precision_dispatcher_::~precision_dispatcher_()
+  {
+    _running.store(false);
+
+    // wake sigwaitinfo up, the signal is not a timer one and is ignored
+    pthread_kill(_thread.native_handle(), _signal);
+    _thread.join();
+  }
+
+  void precision_dispatcher::precision_dispatcher_::run() noexcept
+  {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, _signal);
+
+    // the signal must be blocked to be received with sigwaitinfo
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    _tid.store(static_cast<pid_t>(syscall(SYS_gettid)));
+
+    while (_running.load())
+    {
+      siginfo_t si;
+      if (sigwaitinfo(&set, &si) < 0 || si.si_code != SI_TIMER)
+      {
+        continue;
+      }
+
+      auto tm = _slots.pin(si.si_value.sival_ptr);
+      if (!tm)
+      {
+        // the timer was destroyed while its signal was pending
+        continue;
+      }
+
+      // the expiry spins until the exact deadline and runs the callback right here
+      try
+      {
+        tm->fired();
+        tm->expire(1 + static_cast<std::uint64_t>(std::max(si.si_overrun, 0)));
+      }
+      catch (...)
+      {
+        POSIXCPP_LOG(LOG_ERR, "precision_dispatcher_::run callback has thrown");
+      }
+      _slots.unpin(si.si_value.sival_ptr);
+    }
+  }
+
+  int precision_dispatcher::precision_dispatcher_::signal() const noexcept
+  {
+    return _signal;
+  }
+
+  pid_t precision_dispatcher::precision_dispatcher_::tid() const noexcept
+  {
+    return _tid.load();
+  }
+
+  int precision_dispatcher::precision_dispatcher_::cpu() const noexcept
+  {
+    return _cpu;
+  }
+
+  void precision_dispatcher::precision_dispatcher_::set_spin_window(std::chrono::nanoseconds spin_window) noexcept
+  {
+    _spin_window.store(std::max(spin_window, std::chrono::nanoseconds(0)).count());
+  }
+
+  std::chrono::nanoseconds precision_dispatcher::precision_dispatcher_::spin_window() const noexcept
+  {
+    return std::chrono::nanoseconds(_spin_window.load(std::memory_order_relaxed));
+  }
+
+  void* precision_dispatcher::precision_dispatcher_::attach(timer::timer_* tm)
+  {
+    return _slots.attach(tm);
+  }
+
+  void precision_dispatcher::precision_dispatcher_::detach(timer::timer_*, void* token) noexcept
+  {
+    // no new expiration can start now, waits for the one spinning or running its callback
+    _slots.detach(token);
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,57 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/* Linux system headers */
+#include <sys/types.h>
+
+/* Local headers */
+#include "precision_dispatcher.h"
+#include "signal_slots.h"
+#include "timer.h"
+
+namespace posixcpp
+{
+  class precision_dispatcher::precision_dispatcher_
+  {
+    int _signal;
+    int _cpu;
+    std::atomic<bool> _running;
+    std::atomic<pid_t> _tid;                      /**< kernel thread id of the dispatcher thread */
+    std::atomic<std::int64_t> _spin_window;       /**< nanoseconds */
+
+    signal_slots<timer::timer_> _slots;           /**< attached timers, stale signals are ignored */
+
+    std::thread _thread;
+
+    void run() noexcept;
+
+    public:
+    explicit precision_dispatcher_(std::chrono::nanoseconds spin_window, int cpu, int sig);
+
+    ~precision_dispatcher_();
+
+    precision_dispatcher_(const precision_dispatcher_&) = delete;
+    precision_dispatcher_(precision_dispatcher_&&) = delete;
+    precision_dispatcher_& operator=(const precision_dispatcher_&) = delete;
+    precision_dispatcher_& operator=(precision_dispatcher_&&) = delete;
+
+    int signal() const noexcept;
+    pid_t tid() const noexcept;
+    int cpu() const noexcept;
+
+    void set_spin_window(std::chrono::nanoseconds spin_window) noexcept;
+    std::chrono::nanoseconds spin_window() const noexcept;
+
+    /**
+     * @return the sigev_value pointer of *tm*
+     */
+    void* attach(timer::timer_* tm);
+
+    void detach(timer::timer_* tm, void* token) noexcept;
+  };
+} //namespace posixcpp
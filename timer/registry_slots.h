@@ -0,0 +1,245 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <thread>
+
+namespace posixcpp
+{
+  /**
+   * Lock-free table of live objects, see timer_registry.
+   * Attach pops a free slot off a tagged stack or takes a fresh one, detach clears the slot and waits for the readers
+   * which have pinned it only, a reader pins every slot while it copies the owner. A slot reserved up front is
+   * assigned and cleared without touching the free stack at all. Neither side ever takes a lock; a chunk of slots is
+   * allocated every chunk_size fresh slots and never freed, so a slot address is stable and a stale read of a free
+   * slot is harmless. The table is constant initialised and has a trivial destructor, objects of static storage
+   * duration may attach and detach in any order around it.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  template <typename T>
+  class registry_slots
+  {
+    struct slot
+    {
+      std::atomic<T*> _owner;
+      std::atomic<std::uint64_t> _order;       /**< attach sequence, the slots are reused in any order */
+      std::atomic<unsigned> _pinned;           /**< readers between pin and unpin */
+      std::atomic<std::uint32_t> _next_free;   /**< next free slot + 1, 0 ends the free stack */
+    };
+
+    static constexpr std::size_t chunk_size = 256;
+    static constexpr std::size_t max_chunks = 4096;
+
+    std::atomic<slot*> _chunks[max_chunks];
+    std::atomic<std::uint64_t> _free;          /**< tag << 32 | top free slot + 1, the tag defeats ABA */
+    std::atomic<std::size_t> _fresh;           /**< slots handed out so far */
+    std::atomic<std::size_t> _size;
+    std::atomic<std::uint64_t> _order;
+
+    slot* at(std::size_t index) const noexcept
+    {
+      auto chunk = _chunks[index / chunk_size].load(std::memory_order_acquire);
+      return chunk ? &chunk[index % chunk_size] : nullptr;
+    }
+
+    public:
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    constexpr registry_slots() noexcept :
+      _chunks{},
+      _free(0),
+      _fresh(0),
+      _size(0),
+      _order(0)
+    {}
+
+    registry_slots(const registry_slots&) = delete;
+    registry_slots(registry_slots&&) = delete;
+    registry_slots& operator=(const registry_slots&) = delete;
+    registry_slots& operator=(registry_slots&&) = delete;
+
+    /**
+     * @return a slot for a later assign, npos when the table is full or a chunk can't be allocated
+     */
+    std::size_t reserve() noexcept
+    {
+      std::size_t i = npos;
+      auto head = _free.load(std::memory_order_acquire);
+      while (head & 0xffffffff)
+      {
+        auto top = static_cast<std::size_t>(head & 0xffffffff) - 1;
+        auto next = at(top)->_next_free.load(std::memory_order_relaxed);
+        if (_free.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | next, std::memory_order_acquire))
+        {
+          i = top;
+          break;
+        }
+      }
+
+      if (i == npos)
+      {
+        i = _fresh.fetch_add(1);
+        if (i >= chunk_size * max_chunks)
+        {
+          _fresh.fetch_sub(1);
+          return npos;
+        }
+
+        // the first thread to need the chunk installs it, a fresh slot of it may be handed to another one first
+        auto& chunk = _chunks[i / chunk_size];
+        if (!chunk.load(std::memory_order_acquire))
+        {
+          auto fresh = new (std::nothrow) slot[chunk_size];
+          if (!fresh)
+          {
+            // the slot is lost, the next attach tries the next one
+            return npos;
+          }
+          for (std::size_t j = 0; j < chunk_size; j++)
+          {
+            fresh[j]._owner.store(nullptr, std::memory_order_relaxed);
+            fresh[j]._order.store(0, std::memory_order_relaxed);
+            fresh[j]._pinned.store(0, std::memory_order_relaxed);
+            fresh[j]._next_free.store(0, std::memory_order_relaxed);
+          }
+          slot* expected = nullptr;
+          if (!chunk.compare_exchange_strong(expected, fresh, std::memory_order_acq_rel))
+          {
+            delete[] fresh;
+          }
+        }
+      }
+
+      return i;
+    }
+
+    /**
+     * Hands the reserved slot *index* to *owner*, it's wait-free.
+     */
+    void assign(std::size_t index, T* owner) noexcept
+    {
+      if (index == npos)
+      {
+        return;
+      }
+
+      auto s = at(index);
+      s->_order.store(_order.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+      s->_owner.store(owner);
+      _size.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Takes the owner of *index* away and waits for the readers which have pinned it, the slot stays reserved.
+     */
+    void clear(std::size_t index) noexcept
+    {
+      if (index == npos)
+      {
+        return;
+      }
+
+      // pairs with the pin of for_each, either the reader sees nullptr or it's waited for here
+      auto s = at(index);
+      s->_owner.store(nullptr);
+      while (s->_pinned.load() != 0)
+      {
+        std::this_thread::yield();
+      }
+      _size.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Gives the reserved slot *index* back, it's reused by a later reserve.
+     */
+    void unreserve(std::size_t index) noexcept
+    {
+      if (index == npos)
+      {
+        return;
+      }
+
+      auto s = at(index);
+      auto head = _free.load(std::memory_order_relaxed);
+      do
+      {
+        s->_next_free.store(static_cast<std::uint32_t>(head & 0xffffffff), std::memory_order_relaxed);
+      }
+      while (!_free.compare_exchange_weak(head, ((head >> 32) + 1) << 32 | (index + 1), std::memory_order_release));
+    }
+
+    /**
+     * @return the slot of *owner*, npos when the table is full or a chunk can't be allocated
+     */
+    std::size_t attach(T* owner) noexcept
+    {
+      auto i = reserve();
+      assign(i, owner);
+      return i;
+    }
+
+    /**
+     * Clears *index* and gives it back, see clear and unreserve.
+     */
+    void detach(std::size_t index) noexcept
+    {
+      clear(index);
+      unreserve(index);
+    }
+
+    /**
+     * Calls *f(owner, order)* for every live owner, it can't be detached meanwhile.
+     */
+    template <typename F>
+    void for_each(F&& f)
+    {
+      auto fresh = _fresh.load();
+      for (std::size_t i = 0; i < fresh && i < chunk_size * max_chunks; i++)
+      {
+        auto s = at(i);
+        if (!s)
+        {
+          continue;
+        }
+
+        s->_pinned.fetch_add(1);
+        auto owner = s->_owner.load();
+        if (owner)
+        {
+          try
+          {
+            f(*owner, s->_order.load(std::memory_order_relaxed));
+          }
+          catch (...)
+          {
+            s->_pinned.fetch_sub(1);
+            throw;
+          }
+        }
+        s->_pinned.fetch_sub(1);
+      }
+    }
+
+    /**
+     * @return number of attached owners
+     */
+    std::size_t size() const noexcept
+    {
+      return _size.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return an upper bound of the slots for_each visits
+     */
+    std::size_t capacity() const noexcept
+    {
+      return _fresh.load(std::memory_order_relaxed);
+    }
+  };
+} //namespace posixcpp
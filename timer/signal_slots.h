@@ -0,0 +1,176 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+/* Local headers */
+#include "log.h"
+#include "timer.h"
+
+namespace posixcpp
+{
+  /**
+   * Table of the timers whose signals are received by one thread, see timer_dispatcher, precision_dispatcher and
+   * timer_signalfd.
+   * The sigev_value of such a timer is a token, the slot index and the slot generation, rather than the timer_
+   * address. A signal still pending when its timer is destroyed carries an old generation, so it never reaches the
+   * next timer, even one created at the same address or in the same slot. The receiving thread only touches atomics
+   * of the slot, attach and detach take a mutex.
+   *
+   * It is not:
+   * - copyable;
+   * - movable;
+   */
+  template <typename T>
+  class signal_slots
+  {
+    struct slot
+    {
+      std::atomic<T*> _owner;
+      std::atomic<std::uintptr_t> _generation;  /**< bumped by detach, stale tokens don't match it any more */
+      std::atomic<unsigned> _pinned;            /**< receivers between pin and unpin */
+    };
+
+    static constexpr std::size_t chunk_size = 256;
+    static constexpr std::size_t max_chunks = 4096;
+    static constexpr unsigned index_bits = sizeof(std::uintptr_t) * 4;
+    static constexpr std::uintptr_t index_mask = (std::uintptr_t(1) << index_bits) - 1;
+
+    std::unique_ptr<std::atomic<slot*>[]> _chunks;  /**< chunks never move, so a slot address is stable */
+    std::mutex _mutex;                        /**< protects _free and _size */
+    std::vector<std::size_t> _free;
+    std::size_t _size;                        /**< slots handed out so far */
+
+    slot& at(std::size_t index) const noexcept
+    {
+      return _chunks[index / chunk_size].load(std::memory_order_acquire)[index % chunk_size];
+    }
+
+    static std::size_t index(void* token) noexcept
+    {
+      return reinterpret_cast<std::uintptr_t>(token) & index_mask;
+    }
+
+    static std::uintptr_t generation(void* token) noexcept
+    {
+      return reinterpret_cast<std::uintptr_t>(token) >> index_bits;
+    }
+
+    public:
+    signal_slots() :
+      _chunks(new std::atomic<slot*>[max_chunks]()),
+      _size(0)
+    {}
+
+    ~signal_slots()
+    {
+      for (std::size_t i = 0; i < max_chunks; i++)
+      {
+        delete[] _chunks[i].load();
+      }
+    }
+
+    signal_slots(const signal_slots&) = delete;
+    signal_slots(signal_slots&&) = delete;
+    signal_slots& operator=(const signal_slots&) = delete;
+    signal_slots& operator=(signal_slots&&) = delete;
+
+    /**
+     * @return the sigev_value pointer of *owner*, valid until detach
+     */
+    void* attach(T* owner)
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+
+      std::size_t i;
+      if (!_free.empty())
+      {
+        i = _free.back();
+        _free.pop_back();
+      }
+      else
+      {
+        if (_size == chunk_size * max_chunks)
+        {
+          auto ec = make_error_code(timer::error::posix_timer_creation);
+          POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+          throw std::system_error(ec);
+        }
+
+        // detach can't allocate, it's noexcept
+        _free.reserve(_size + 1);
+        i = _size++;
+        if (i % chunk_size == 0)
+        {
+          auto chunk = new slot[chunk_size];
+          for (std::size_t j = 0; j < chunk_size; j++)
+          {
+            chunk[j]._owner.store(nullptr, std::memory_order_relaxed);
+            chunk[j]._generation.store(0, std::memory_order_relaxed);
+            chunk[j]._pinned.store(0, std::memory_order_relaxed);
+          }
+          _chunks[i / chunk_size].store(chunk, std::memory_order_release);
+        }
+      }
+
+      auto& s = at(i);
+      s._owner.store(owner, std::memory_order_release);
+      auto generation = s._generation.load() & index_mask;
+      return reinterpret_cast<void*>(generation << index_bits | i);
+    }
+
+    /**
+     * Keeps the owner of *token* from being detached until unpin, it's wait-free.
+     * @return the owner, nullptr when the token is stale
+     */
+    T* pin(void* token) noexcept
+    {
+      auto i = index(token);
+      if (i >= chunk_size * max_chunks || !_chunks[i / chunk_size].load(std::memory_order_acquire))
+      {
+        return nullptr;
+      }
+
+      auto& s = at(i);
+      s._pinned.fetch_add(1);
+      if ((s._generation.load() & index_mask) != generation(token))
+      {
+        // the timer was destroyed while its signal was pending
+        s._pinned.fetch_sub(1);
+        return nullptr;
+      }
+      return s._owner.load(std::memory_order_acquire);
+    }
+
+    void unpin(void* token) noexcept
+    {
+      at(index(token))._pinned.fetch_sub(1);
+    }
+
+    /**
+     * Invalidates *token* and waits for the receivers which have pinned it, the slot is reused by the next attach.
+     */
+    void detach(void* token) noexcept
+    {
+      auto& s = at(index(token));
+
+      // a pin which has not seen the new generation yet is waited for
+      s._generation.fetch_add(1);
+      while (s._pinned.load() != 0)
+      {
+        std::this_thread::yield();
+      }
+      s._owner.store(nullptr, std::memory_order_relaxed);
+
+      std::lock_guard<std::mutex> lock(_mutex);
+      _free.push_back(index(token));
+    }
+  };
+} //namespace posixcpp
@@ -0,0 +1,99 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace posixcpp
+{
+  /**
+   * Bounded single producer, single consumer ring buffer.
+   * Both push and pop are wait-free, the capacity is rounded up to a power of two.
+   */
+  template <typename T>
+  class spsc_ring
+  {
+    std::vector<T> _buffer;
+    std::size_t _mask;
+    alignas(64) std::atomic<std::size_t> _head;   /**< next slot to pop, owned by the consumer */
+    alignas(64) std::atomic<std::size_t> _tail;   /**< next slot to push, owned by the producer */
+
+    static std::size_t round_up(std::size_t n) noexcept
+    {
+      std::size_t size = 1;
+      while (size < n)
+      {
+        size <<= 1;
+      }
+      return size;
+    }
+
+    public:
+    explicit spsc_ring(std::size_t capacity) :
+      _buffer(round_up(capacity)),
+      _mask(_buffer.size() - 1),
+      _head(0),
+      _tail(0)
+    {}
+
+    spsc_ring(const spsc_ring&) = delete;
+    spsc_ring(spsc_ring&&) = delete;
+    spsc_ring& operator=(const spsc_ring&) = delete;
+    spsc_ring& operator=(spsc_ring&&) = delete;
+
+    /**
+     * @return the ring storage, e.g. to lock it in memory
+     */
+    const void* data() const noexcept
+    {
+      return _buffer.data();
+    }
+
+    /**
+     * @return size of the ring storage in bytes
+     */
+    std::size_t bytes() const noexcept
+    {
+      return _buffer.size() * sizeof(T);
+    }
+
+    /**
+     * @return false if the ring is full
+     */
+    bool push(const T& value) noexcept
+    {
+      auto tail = _tail.load(std::memory_order_relaxed);
+      if (tail - _head.load(std::memory_order_acquire) == _buffer.size())
+      {
+        return false;
+      }
+
+      _buffer[tail & _mask] = value;
+      _tail.store(tail + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * @return false if the ring is empty
+     */
+    bool pop(T& value) noexcept
+    {
+      auto head = _head.load(std::memory_order_relaxed);
+      if (head == _tail.load(std::memory_order_acquire))
+      {
+        return false;
+      }
+
+      value = _buffer[head & _mask];
+      _head.store(head + 1, std::memory_order_release);
+      return true;
+    }
+
+    std::size_t capacity() const noexcept
+    {
+      return _buffer.size();
+    }
+  }; // class spsc_ring
+
+} // namespace posixcpp
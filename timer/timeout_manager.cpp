@@ -0,0 +1,58 @@
+/* Local headers */
+#include "timeout_manager.h"
+#include "timeout_manager_.h"
+
+namespace posixcpp
+{
+  timeout_manager::timeout_manager(std::chrono::nanoseconds slack) :
+    _manager(new timeout_manager_(slack))
+  {}
+
+  timeout_manager::~timeout_manager()
+  {}
+
+  std::chrono::nanoseconds timeout_manager::slack() const noexcept
+  {
+    return _manager->slack();
+  }
+
+  std::size_t timeout_manager::size() const noexcept
+  {
+    return _manager->size();
+  }
+
+  timeout_manager::counters timeout_manager::stats() const noexcept
+  {
+    return _manager->stats();
+  }
+
+  timeout_manager::timeout::timeout(timeout_manager& manager, callback_t callback, void* data) :
+    _manager(*manager._manager),
+    _callback(callback),
+    _data(data),
+    _deadline(0),
+    _key(0),
+    _index(npos)
+  {}
+
+  timeout_manager::timeout::~timeout()
+  {
+    _manager.release(*this);
+  }
+
+  void timeout_manager::timeout::arm(std::chrono::nanoseconds duration)
+  {
+    _manager.arm(*this, duration);
+  }
+
+  bool timeout_manager::timeout::cancel() noexcept
+  {
+    return _manager.cancel(*this);
+  }
+
+  bool timeout_manager::timeout::armed() const noexcept
+  {
+    return _manager.armed(*this);
+  }
+
+} //namespace posixcpp
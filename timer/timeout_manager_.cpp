@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "coalescer.h"
+#include "log.h"
+#include "timeout_manager_.h"
+#include "tsc_clock.h"
+
+namespace posixcpp
+{
+  timeout_manager::timeout_manager_::guard::guard(timeout_manager_& manager) noexcept :
+    _manager(manager),
+    _locked(false)
+  {
+    lock();
+  }
+
+  timeout_manager::timeout_manager_::guard::~guard()
+  {
+    if (_locked)
+    {
+      unlock();
+    }
+  }
+
+  void timeout_manager::timeout_manager_::guard::lock() noexcept
+  {
+    while (_manager._busy.exchange(true, std::memory_order_acquire))
+    {
+      std::this_thread::yield();
+    }
+    _locked = true;
+  }
+
+  void timeout_manager::timeout_manager_::guard::unlock() noexcept
+  {
+    _locked = false;
+    _manager._busy.store(false, std::memory_order_release);
+  }
+
+  timeout_manager::timeout_manager_::timeout_manager_(std::chrono::nanoseconds slack) :
+    _slack(slack),
+    _fd(-1),
+    _programmed(0),
+    _armed(0),
+    _busy(false),
+    _firing(nullptr),
+    _running(true),
+    _arms(0),
+    _cancels(0),
+    _expirations(0),
+    _wakeups(0),
+    _settimes(0)
+  {
+    if (slack < std::chrono::nanoseconds(0))
+    {
+      throw std::invalid_argument("timeout_manager slack must not be negative");
+    }
+
+    _fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (_fd < 0)
+    {
+      auto ec = make_error_code(timer::error::posix_timerfd_creation);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    _thread = std::thread(&timeout_manager_::run, this);
+  }
+
+  timeout_manager::timeout_manager_::~timeout_manager_()
+  {
+    _running.store(false);
+
+    // an absolute instant in the past wakes the thread up right away
+    struct itimerspec ts{};
+    ts.it_value.tv_nsec = 1;
+    timerfd_settime(_fd, TFD_TIMER_ABSTIME, &ts, nullptr);
+    _thread.join();
+
+    close(_fd);
+  }
+
+  bool timeout_manager::timeout_manager_::less(std::size_t a, std::size_t b) const noexcept
+  {
+    return _queue[a]->_key < _queue[b]->_key;
+  }
+
+  void timeout_manager::timeout_manager_::swap(std::size_t a, std::size_t b) noexcept
+  {
+    std::swap(_queue[a], _queue[b]);
+    _queue[a]->_index = a;
+    _queue[b]->_index = b;
+  }
+
+  void timeout_manager::timeout_manager_::sift_up(std::size_t i) noexcept
+  {
+    while (i > 0 && less(i, (i - 1) / 2))
+    {
+      swap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void timeout_manager::timeout_manager_::sift_down(std::size_t i) noexcept
+  {
+    for (;;)
+    {
+      auto smallest = i;
+      auto left = 2 * i + 1;
+      auto right = left + 1;
+
+      if (left < _queue.size() && less(left, smallest))
+      {
+        smallest = left;
+      }
+      if (right < _queue.size() && less(right, smallest))
+      {
+        smallest = right;
+      }
+      if (smallest == i)
+      {
+        return;
+      }
+      swap(i, smallest);
+      i = smallest;
+    }
+  }
+
+  void timeout_manager::timeout_manager_::remove(std::size_t i) noexcept
+  {
+    auto last = _queue.size() - 1;
+    _queue[i]->_index = timeout::npos;
+
+    if (i != last)
+    {
+      _queue[i] = _queue[last];
+      _queue[i]->_index = i;
+    }
+    _queue.pop_back();
+
+    if (i != last)
+    {
+      sift_down(i);
+      sift_up(i);
+    }
+  }
+
+  void timeout_manager::timeout_manager_::settime(std::int64_t instant) noexcept
+  {
+    struct itimerspec ts{};
+    ts.it_value.tv_sec = instant / 1000000000;
+    ts.it_value.tv_nsec = instant % 1000000000;
+
+    if (timerfd_settime(_fd, TFD_TIMER_ABSTIME, &ts, nullptr) != 0)
+    {
+      auto ec = make_error_code(timer::error::posix_timer_settime);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      return;
+    }
+    _programmed = instant;
+    _settimes.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void timeout_manager::timeout_manager_::program() noexcept
+  {
+    if (_queue.empty())
+    {
+      // the programmed wakeup only costs a spurious loop, it's cheaper than a syscall to disarm it
+      return;
+    }
+
+    // the head may be a stale entry, it's dropped or moved by the wakeup
+    auto instant = coalescer::align(std::chrono::nanoseconds(_queue.front()->_key), _slack).count();
+    if (_programmed == 0 || instant < _programmed)
+    {
+      settime(instant);
+    }
+  }
+
+  void timeout_manager::timeout_manager_::expire() noexcept
+  {
+    guard lock(*this);
+
+    _programmed = 0;
+    auto now = tsc_clock::now().time_since_epoch().count();
+
+    while (!_queue.empty() && _queue.front()->_key <= now)
+    {
+      auto tm = _queue.front();
+
+      if (tm->_deadline == 0)
+      {
+        // cancelled, drop the lazily deleted entry
+        remove(0);
+        continue;
+      }
+
+      if (tm->_deadline > now)
+      {
+        // re-armed to a later deadline, move the entry there
+        tm->_key = tm->_deadline;
+        sift_down(0);
+        continue;
+      }
+
+      remove(0);
+      tm->_deadline = 0;
+      _armed.fetch_sub(1, std::memory_order_relaxed);
+      _expirations.fetch_add(1, std::memory_order_relaxed);
+
+      if (!tm->_callback)
+      {
+        continue;
+      }
+
+      // the callback runs without the guard, it may arm, cancel or destroy any timeout; another thread destroying
+      // this one waits for it, the head is read again once the guard is back
+      _firing = tm;
+      auto callback = tm->_callback;
+      auto data = tm->_data;
+      lock.unlock();
+      try
+      {
+        callback(data);
+      }
+      catch (...)
+      {
+        POSIXCPP_LOG(LOG_ERR, "timeout_manager_::expire callback has thrown");
+      }
+      lock.lock();
+      _firing = nullptr;
+    }
+
+    program();
+  }
+
+  void timeout_manager::timeout_manager_::run() noexcept
+  {
+    while (_running.load())
+    {
+      std::uint64_t expirations;
+      if (read(_fd, &expirations, sizeof(expirations)) < 0)
+      {
+        if (errno != EINTR)
+        {
+          auto ec = make_error_code(timer::error::posix_timerfd_read);
+          POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        }
+        continue;
+      }
+
+      if (!_running.load())
+      {
+        break;
+      }
+
+      _wakeups.fetch_add(1, std::memory_order_relaxed);
+      expire();
+    }
+  }
+
+  std::chrono::nanoseconds timeout_manager::timeout_manager_::slack() const noexcept
+  {
+    return _slack;
+  }
+
+  std::size_t timeout_manager::timeout_manager_::size() const noexcept
+  {
+    return _armed.load(std::memory_order_relaxed);
+  }
+
+  timeout_manager::counters timeout_manager::timeout_manager_::stats() const noexcept
+  {
+    counters c;
+    c.arms = _arms.load(std::memory_order_relaxed);
+    c.cancels = _cancels.load(std::memory_order_relaxed);
+    c.expirations = _expirations.load(std::memory_order_relaxed);
+    c.wakeups = _wakeups.load(std::memory_order_relaxed);
+    c.settimes = _settimes.load(std::memory_order_relaxed);
+    return c;
+  }
+
+  void timeout_manager::timeout_manager_::arm(timeout& tm, std::chrono::nanoseconds duration)
+  {
+    // 0 means not armed, a deadline is never at the clock epoch
+    auto deadline = std::max<std::int64_t>((tsc_clock::now().time_since_epoch() + duration).count(), 1);
+
+    guard lock(*this);
+
+    if (tm._deadline == 0)
+    {
+      _armed.fetch_add(1, std::memory_order_relaxed);
+    }
+    tm._deadline = deadline;
+    _arms.fetch_add(1, std::memory_order_relaxed);
+
+    if (tm._index != timeout::npos && tm._key <= deadline)
+    {
+      // the queued entry surfaces first, the wakeup moves it to the new deadline
+      return;
+    }
+
+    tm._key = deadline;
+    if (tm._index == timeout::npos)
+    {
+      try
+      {
+        _queue.push_back(&tm);
+      }
+      catch (...)
+      {
+        tm._deadline = 0;
+        _armed.fetch_sub(1, std::memory_order_relaxed);
+        throw;
+      }
+      tm._index = _queue.size() - 1;
+    }
+    sift_up(tm._index);
+
+    if (tm._index == 0)
+    {
+      program();
+    }
+  }
+
+  bool timeout_manager::timeout_manager_::cancel(timeout& tm) noexcept
+  {
+    guard lock(*this);
+
+    if (tm._deadline == 0)
+    {
+      return false;
+    }
+
+    // the queue entry is left in place, it's dropped when it surfaces
+    tm._deadline = 0;
+    _armed.fetch_sub(1, std::memory_order_relaxed);
+    _cancels.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool timeout_manager::timeout_manager_::armed(const timeout& tm) noexcept
+  {
+    guard lock(*this);
+    return tm._deadline != 0;
+  }
+
+  void timeout_manager::timeout_manager_::release(timeout& tm) noexcept
+  {
+    guard lock(*this);
+
+    // a thread other than the manager waits for the callback of the timeout, a callback may destroy its own one
+    while (_firing == &tm && std::this_thread::get_id() != _thread.get_id())
+    {
+      lock.unlock();
+      std::this_thread::yield();
+      lock.lock();
+    }
+
+    if (tm._deadline != 0)
+    {
+      tm._deadline = 0;
+      _armed.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    // the handle goes away, its entry can't stay in the queue
+    if (tm._index != timeout::npos)
+    {
+      remove(tm._index);
+    }
+  }
+
+} // namespace posixcpp
@@ -0,0 +1,81 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+/* Local headers */
+#include "timeout_manager.h"
+
+namespace posixcpp
+{
+  class timeout_manager::timeout_manager_
+  {
+    /**
+     * Serialises queue updates between user threads and the manager thread. The manager thread releases it around
+     * every callback, so a callback never holds up the other threads and may re-enter the manager.
+     */
+    class guard
+    {
+      timeout_manager_& _manager;
+      bool _locked;
+
+      public:
+      explicit guard(timeout_manager_& manager) noexcept;
+      ~guard();
+
+      void lock() noexcept;
+      void unlock() noexcept;
+    };
+
+    std::chrono::nanoseconds _slack;
+    int _fd;                                  /**< timerfd, CLOCK_MONOTONIC shares the tsc_clock epoch */
+    std::vector<timeout*> _queue;             /**< binary min heap on timeout::_key, holds stale entries too */
+    std::int64_t _programmed;                 /**< absolute wakeup the timerfd is armed at, 0 when disarmed */
+    std::atomic<std::size_t> _armed;          /**< number of armed timeouts */
+    std::atomic<bool> _busy;
+    timeout* _firing;                         /**< timeout whose callback runs, it's destroyed only by the callback */
+    std::atomic<bool> _running;
+
+    std::atomic<std::uint64_t> _arms;
+    std::atomic<std::uint64_t> _cancels;
+    std::atomic<std::uint64_t> _expirations;
+    std::atomic<std::uint64_t> _wakeups;
+    std::atomic<std::uint64_t> _settimes;
+
+    std::thread _thread;
+
+    bool less(std::size_t a, std::size_t b) const noexcept;
+    void swap(std::size_t a, std::size_t b) noexcept;
+    void sift_up(std::size_t i) noexcept;
+    void sift_down(std::size_t i) noexcept;
+    void remove(std::size_t i) noexcept;
+
+    void program() noexcept;
+    void settime(std::int64_t instant) noexcept;
+    void expire() noexcept;
+    void run() noexcept;
+
+    public:
+    explicit timeout_manager_(std::chrono::nanoseconds slack);
+
+    ~timeout_manager_();
+
+    timeout_manager_(const timeout_manager_&) = delete;
+    timeout_manager_(timeout_manager_&&) = delete;
+    timeout_manager_& operator=(const timeout_manager_&) = delete;
+    timeout_manager_& operator=(timeout_manager_&&) = delete;
+
+    std::chrono::nanoseconds slack() const noexcept;
+    std::size_t size() const noexcept;
+    counters stats() const noexcept;
+
+    void arm(timeout& tm, std::chrono::nanoseconds duration);
+    bool cancel(timeout& tm) noexcept;
+    bool armed(const timeout& tm) noexcept;
+    void release(timeout& tm) noexcept;
+  };
+} //namespace posixcpp
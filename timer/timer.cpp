@@ -1,20 +1,74 @@
 /* STL C++ headers */
+#include <new>
 #include <stdexcept>
 
 /* Local headers */
+#include "coalescer.h"
 #include "timer.h"
 #include "timer_.h"
+#include "precision_dispatcher_.h"
+#include "timer_dispatcher_.h"
+#include "timer_pool_.h"
+#include "timer_signalfd_.h"
+#include "timer_uring_.h"
+#include "virtual_clock_.h"
 
 namespace posixcpp
 {
   timer::timer(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
-      callback_t callback, void* data, bool is_single_shot, int sig) :
-    _timer(new timer_(period_sec, period_nsec, callback, data, is_single_shot, sig))
+      callback_t callback, void* data, bool is_single_shot, int sig, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, sig, backend::signal, nullptr,
+          clock))
+  {}
+
+  timer::timer(backend be, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, be, nullptr, clock))
+  {}
+
+  timer::timer(timer_dispatcher& dispatcher, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, backend::signal,
+          dispatcher._dispatcher.get(), clock))
+  {}
+
+  timer::timer(precision_dispatcher& dispatcher, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, backend::signal,
+          nullptr, clock, dispatcher._dispatcher.get()))
+  {}
+
+  timer::timer(timer_pool& pool, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, pool._pool->signal(),
+          backend::signal, nullptr, pool._pool->clock(), nullptr, pool._pool.get()))
+  {}
+
+  timer::timer(timer_signalfd& signalfd, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, backend::signal,
+          nullptr, clock, nullptr, nullptr, signalfd._signalfd.get()))
+  {}
+
+  timer::timer(timer_uring& uring, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot, clockid_t clock) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, backend::signal,
+          nullptr, clock, nullptr, nullptr, nullptr, uring._uring.get()))
+  {}
+
+  timer::timer(virtual_clock& clock, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot) :
+    _timer(new (_storage) timer_(period_sec, period_nsec, callback, data, is_single_shot, SIGRTMAX, backend::signal,
+          nullptr, CLOCK_MONOTONIC, nullptr, nullptr, nullptr, nullptr, clock._clock.get()))
   {}
 
   timer::~timer()
   {
-    syslog(LOG_INFO, "timer::~timer()");
+    static_assert(sizeof(timer_) <= impl_size, "timer::impl_size is too small for timer_");
+    static_assert(alignof(timer_) <= 64, "timer_ alignment exceeds the timer storage");
+
+    POSIXCPP_LOG(LOG_INFO, "timer::~timer()");
+    _timer->~timer_();
   }
 
   void timer::start()
@@ -22,6 +76,11 @@ namespace posixcpp
     _timer->start();
   }
 
+  void timer::start_at(std::chrono::nanoseconds epoch)
+  {
+    _timer->start_at(epoch);
+  }
+
   void timer::reset()
   {
     _timer->reset();
@@ -47,6 +106,11 @@ namespace posixcpp
     return _timer->try_start();
   }
 
+  std::error_code timer::try_start_at(std::chrono::nanoseconds epoch) noexcept
+  {
+    return _timer->try_start_at(epoch);
+  }
+
   std::error_code timer::try_reset() noexcept
   {
     return _timer->try_reset();
@@ -67,4 +131,61 @@ namespace posixcpp
     return _timer->try_stop();
   }
 
+  clockid_t timer::clock() const noexcept
+  {
+    return _timer->clock();
+  }
+
+  int timer::fd() const noexcept
+  {
+    return _timer->fd();
+  }
+
+  std::uint64_t timer::dispatch()
+  {
+    return _timer->dispatch();
+  }
+
+  void timer::set_overrun_policy(overrun_policy policy) noexcept
+  {
+    _timer->set_overrun_policy(policy);
+  }
+
+  std::uint64_t timer::expirations() const noexcept
+  {
+    return _timer->expirations();
+  }
+
+  void timer::set_executor(executor* ex, std::size_t worker) noexcept
+  {
+    _timer->set_executor(ex, worker);
+  }
+
+  void timer::set_slack(std::chrono::nanoseconds slack) noexcept
+  {
+    _timer->set_slack(slack);
+  }
+
+  std::chrono::nanoseconds timer::slack() const noexcept
+  {
+    return _timer->slack();
+  }
+
+  timer::coalescing_stats timer::coalescing() noexcept
+  {
+    return coalescer::stats();
+  }
+
+  std::chrono::nanoseconds timer::remaining() const noexcept
+  {
+    return _timer->remaining();
+  }
+
+  timer_stats timer::stats() const noexcept
+  {
+    timer_stats st;
+    _timer->stats(st);
+    return st;
+  }
+
 } //namespace posixcpp
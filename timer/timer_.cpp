@@ -1,10 +1,29 @@
+#include <algorithm>
 #include <stdexcept>
+#include <cerrno>
 #include <cstring>
+#include <thread>
+#include <utility>
 
-#include <syslog.h>
 #include <time.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
 
+#include "coalescer.h"
+#include "log.h"
+#include "precision_dispatcher_.h"
 #include "timer_.h"
+#include "timer_dispatcher_.h"
+#include "timer_signalfd_.h"
+#include "timer_uring_.h"
+#include "trace.h"
+#include "tsc_clock.h"
+#include "virtual_clock_.h"
+
+#ifndef sigev_notify_thread_id
+/* glibc only exposes the SIGEV_THREAD_ID target thread id under its internal name */
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
 
 namespace posixcpp
 {
@@ -13,29 +32,49 @@ namespace posixcpp
   {
     // extracting timer_ object pointer from si_value.svial_ptr,
     auto tm = static_cast<timer_*>(si->si_value.sival_ptr);
+    if (auto s = timer_pool::timer_pool_::untag(si->si_value.sival_ptr))
+    {
+      // a pooled kernel timer, its signal may be a stale one of a timer which has been stopped or destroyed
+      if (!timer_pool::timer_pool_::current(s, si->si_value.sival_ptr))
+      {
+        return;
+      }
+      tm = s->_owner.load(std::memory_order_acquire);
+      if (!tm || (tm->_state.load() != state::armed && tm->_state.load() != state::busy))
+      {
+        return;
+      }
+    }
     if (tm && sig == tm->_signal)
     {
-      syslog(LOG_INFO, "timer_::signal_handler period(%lds, %ldns)", tm->_period_sec.count(), tm->_period_nsec.count());
+      POSIXCPP_LOG(LOG_DEBUG, "timer_::signal_handler period(%lds, %ldns)", tm->_period_sec.count(), tm->_period_nsec.count());
 
-      // calling user given callback function and passing data pointer
-      tm->_callback(tm->_data);
+      // si_overrun is the timer_getoverrun value for this very signal, it's read without an extra syscall
+      tm->fired();
+      tm->expire(1 + static_cast<std::uint64_t>(std::max(si->si_overrun, 0)));
     }
     else
     {
       if(!tm)
       {
-        syslog(LOG_ERR, "timer_::signal_handler si->si_value.sival_ptr is nullptr, skipp handling");
+        POSIXCPP_LOG(LOG_ERR, "timer_::signal_handler si->si_value.sival_ptr is nullptr, skipp handling");
       }
       else
       {
-        syslog(LOG_ERR, "timer_::signal_handler si->si_value.sival_ptr is nullptr, skipp handling");
+        POSIXCPP_LOG(LOG_ERR, "timer_::signal_handler si->si_value.sival_ptr is nullptr, skipp handling");
       }
     }
   }
 
   timer::timer_::timer_(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
       callback_t callback, void* data,
-      bool is_single_shot, int sig
+      bool is_single_shot, int sig, backend be,
+      timer_dispatcher::timer_dispatcher_* dispatcher, clockid_t clock,
+      precision_dispatcher::precision_dispatcher_* precision,
+      timer_pool::timer_pool_* pool,
+      timer_signalfd::timer_signalfd_* signalfd,
+      timer_uring::timer_uring_* uring,
+      virtual_clock::virtual_clock_* virtual_time
       ):
     _period_sec(period_sec),
     _period_nsec(period_nsec),
@@ -43,299 +82,1181 @@ namespace posixcpp
     _data(data),
     _is_single_shot(is_single_shot),
     _signal(sig),
-    _timer(nullptr)
+    _backend(be),
+    _fd(-1),
+    _dispatcher(dispatcher),
+    _in_flight(0),
+    _precision(precision),
+    _pool(pool),
+    _slot(nullptr),
+    _signalfd(signalfd),
+    _token(nullptr),
+    _uring(uring),
+    _uring_slot(0),
+    _virtual(virtual_time),
+    _virtual_slot(0),
+    _overruns(0),
+    _expirations(0),
+    _overrun_policy(overrun_policy::coalesce),
+    _clock(clock),
+    _phase_locked(false),
+    _epoch(0),
+    _slack(0),
+    _deadline(0),
+    _instant(0),
+    _coalescing(false),
+    _executor(nullptr),
+    _affinity(executor::any),
+    _posted_periods(0),
+    _posted(0),
+    _state(state::idle),
+    _fired(0),
+    _ts{},
+    _timer(nullptr),
+    _registry_slot(registry_slots<timer_>::npos)
   {
-    syslog(LOG_INFO, "timer_ ctor %ld sec, %ld nsec", period_sec.count(), period_nsec.count());
+    POSIXCPP_LOG(LOG_INFO, "timer_ ctor %ld sec, %ld nsec", period_sec.count(), period_nsec.count());
 
-    _sa.sa_flags = SA_SIGINFO; /* Notify via signal */
-    _sa.sa_sigaction = signal_handler;
-    sigemptyset(&_sa.sa_mask); /* reset _sa structure data to all zeros */
+    if (_backend == backend::timerfd)
+    {
+      // no signal is involved, the expiration is read from the descriptor by dispatch()
+      _fd = timerfd_create(_clock, TFD_NONBLOCK | TFD_CLOEXEC);
+      if (_fd < 0)
+      {
+        auto ec = make_error_code(error::posix_timerfd_creation);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+      POSIXCPP_LOG(LOG_INFO, "timerfd %d with period_nsec = %ld has created", _fd, period_nsec.count());
+      enlist();
+      return;
+    }
 
-    /* setup user defined signal and signal handler, third parameter as nullptr indicates, that we are
-     * not interested in getting back early configured options
-     */
-    if (sigaction(_signal, &_sa, nullptr) != 0)    
+    if (_uring)
     {
-      auto ec = make_error_code(error::signal_handler_registration);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      /* there is no kernel timer at all, the timeouts are submission entries of the ring */
+      _uring_slot = _uring->attach(this, _clock);
+      enlist();
+      POSIXCPP_LOG(LOG_INFO, "io_uring timer with period_nsec = %ld has created", period_nsec.count());
+      return;
+    }
+
+    if (_virtual)
+    {
+      /* there is no kernel timer at all, the virtual clock fires the timer when it's advanced */
+      _virtual_slot = _virtual->attach(this);
+      enlist();
+      POSIXCPP_LOG(LOG_INFO, "virtual timer with period_nsec = %ld has created", period_nsec.count());
+      return;
+    }
+
+    if (_pool)
+    {
+      /* the kernel timer and the signal handler are set up by the pool already, no syscall is needed */
+      _slot = _pool->acquire(this);
+      _timer = _slot->_timer;
+      enlist();
+      POSIXCPP_LOG(LOG_INFO, "pooled timer with period_nsec = %ld has created", period_nsec.count());
+      return;
+    }
+
+    if (_dispatcher)
+    {
+      /* the signal is targeted at the dispatcher thread, which receives it with sigwaitinfo, no handler is needed */
+      _signal = _dispatcher->signal();
+      _sev.sigev_notify = SIGEV_THREAD_ID;
+      _sev.sigev_notify_thread_id = _dispatcher->tid();
+    }
+    else if (_precision)
+    {
+      _signal = _precision->signal();
+      _sev.sigev_notify = SIGEV_THREAD_ID;
+      _sev.sigev_notify_thread_id = _precision->tid();
+    }
+    else if (_signalfd)
+    {
+      /* the signal stays blocked in the signalfd thread, it's read from the descriptor, no handler is needed */
+      _signal = _signalfd->signal();
+      _sev.sigev_notify = SIGEV_THREAD_ID;
+      _sev.sigev_notify_thread_id = _signalfd->tid();
+    }
+    else
+    {
+      // the handler logs through the default sink, it's created here rather than in signal context
+      log::prepare_default_sink();
+      struct sigaction sa = {};
+      sa.sa_flags = SA_SIGINFO; /* Notify via signal */
+      sa.sa_sigaction = signal_handler;
+      sigemptyset(&sa.sa_mask); /* reset sa structure data to all zeros */
+
+      /* setup user defined signal and signal handler, third parameter as nullptr indicates, that we are
+       * not interested in getting back early configured options
+       */
+      if (sigaction(_signal, &sa, nullptr) != 0)
+      {
+        auto ec = make_error_code(error::signal_handler_registration);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+
+      _sev.sigev_notify = SIGEV_SIGNAL;   /* Notify via signal */
     }
 
-    /* Create and start one timer for each command-line argument */
-    _sev.sigev_notify = SIGEV_SIGNAL;     /* Notify via signal */
-    _sev.sigev_signo = sig;               /* Notify using this signal*/
+    _sev.sigev_signo = _signal;           /* Notify using this signal*/
     _sev.sigev_value.sival_ptr = this;    /* pointer to timer_ object will be passed to the signal handler*/
 
+    /* the receiving threads get a token of their slot table rather than the address, see signal_slots */
+    if (_dispatcher)
+    {
+      _token = _dispatcher->attach(this);
+      _sev.sigev_value.sival_ptr = _token;
+    }
+    else if (_precision)
+    {
+      _token = _precision->attach(this);
+      _sev.sigev_value.sival_ptr = _token;
+    }
+    else if (_signalfd)
+    {
+      _token = _signalfd->attach(this);
+      _sev.sigev_value.sival_ptr = _token;
+    }
+
     /* creating a POSIX timer. IMPORTANT! here we pass timer_t which is stored in this class instance variable */
-    if (timer_create(CLOCK_REALTIME, &_sev, &_timer) != 0)
+    if (timer_create(_clock, &_sev, &_timer) != 0)
     {
+      detach();
       auto ec = make_error_code(error::posix_timer_creation);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
       throw std::system_error(ec);
     }
-    syslog(LOG_INFO, "timer with period_nsec = %ld has created", period_nsec.count());
+
+    enlist();
+    POSIXCPP_LOG(LOG_INFO, "timer with period_nsec = %ld has created", period_nsec.count());
   }
 
   timer::timer_::~timer_()
   {
-    syslog(LOG_INFO, "timer_::~timer_()");
-    auto ec = try_stop();
-    if (ec.value())
-    { 
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
+    POSIXCPP_LOG(LOG_INFO, "timer_::~timer_()");
+    delist();
+
+    // a timer which is not running has nothing to stop, a failing stop has been logged already
+    try_stop();
+
+    if (_backend == backend::timerfd)
+    {
+      close(_fd);
+    }
+    else if (_uring)
+    {
+      // waits for the expiration being dispatched, the slot is reused by the next timer
+      _uring->detach(this, _uring_slot);
+    }
+    else if (_virtual)
+    {
+      // waits for the expiration being delivered by another thread
+      _virtual->detach(_virtual_slot);
+    }
+    else if (_pool)
+    {
+      // the stopped kernel timer goes back to the pool
+      _pool->release(_slot);
+    }
+    else
+    {
+      // POSIX will delte the timer
+      timer_delete(_timer);
+    }
+
+    detach();
+
+    // waits for the callbacks already queued to the executor
+    while (_posted.load() != 0)
+    {
+      std::this_thread::yield();
     }
-    // POSIX will delte the timer
-    timer_delete(_timer);
   }
 
-  void timer::timer_::start()
+  timer::timer_::transition::transition(timer_& tm, state prior) noexcept :
+    _tm(tm),
+    _prior(prior),
+    _fired(tm._fired.load()),
+    _committed(false)
+  {}
+
+  timer::timer_::transition::~transition()
   {
-    struct itimerspec ts;
+    if (!_committed)
+    {
+      _tm._state.store(_prior);
+    }
+  }
 
-    syslog(LOG_INFO, "starting timer with period_sec = %ld, period_nsec = %ld", _period_sec.count(), _period_nsec.count());
+  void timer::timer_::transition::commit(state next) noexcept
+  {
+    _committed = true;
+    _tm._state.store(next);
 
-    //get current time from timer
-    if (timer_gettime(_timer, &ts) != 0)
+    // a single shot expiry between the settime and the store could not see the armed state, it's taken over here
+    if (next == state::armed && _tm._is_single_shot && _tm._fired.load() != _fired)
     {
-      auto ec = make_error_code(error::posix_timer_gettime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      auto expected = state::armed;
+      _tm._state.compare_exchange_strong(expected, state::expired);
     }
+  }
 
-    if (ts.it_value.tv_sec != 0 || ts.it_value.tv_nsec != 0)
+  bool timer::timer_::acquire(unsigned allowed, state& prior) noexcept
+  {
+    prior = _state.load();
+    do
     {
-      // timer is already started, doing nothing
-      auto ec = make_error_code(error::start_already_started);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      // a concurrent operation is never waited for, it might be running in the signal handler interrupting this one
+      if (prior == state::busy || !(allowed & bit(prior)))
+      {
+        return false;
+      }
     }
+    while (!_state.compare_exchange_weak(prior, state::busy));
+    return true;
+  }
 
-    _ts.it_value.tv_sec = _period_sec.count();
-    _ts.it_value.tv_nsec = _period_nsec.count();
+  std::error_code timer::timer_::refuse(state prior, error warning) noexcept
+  {
+    return make_error_code(prior == state::busy ? error::operation_in_progress : warning);
+  }
+
+  std::error_code timer::timer_::fail(error critical) const noexcept
+  {
+    // the warnings are the caller's business, a failing system call is logged where it happens
+    auto ec = make_error_code(critical);
+    POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+    return ec;
+  }
 
-    if (!_is_single_shot) {
-      _ts.it_interval.tv_sec = _ts.it_value.tv_sec;
-      _ts.it_interval.tv_nsec = _ts.it_value.tv_nsec;
+  void timer::timer_::raise(const std::error_code& ec)
+  {
+    if (!ec)
+    {
+      return;
     }
+    if (is_warning(ec))
+    {
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+    }
+    throw std::system_error(ec);
+  }
 
-    // oethrwise set to the defined value
-    if (timer_settime(_timer, 0, &_ts, NULL) != 0)
+  void timer::timer_::fired() noexcept
+  {
+    if (!_is_single_shot)
     {
-      auto ec = make_error_code(error::posix_timer_settime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      return;
     }
 
-    syslog(LOG_INFO, "timer started with preiod_sec = %ld, period_nsec = %ld", _period_sec.count(), _period_nsec.count());
+    _fired++;
+    auto expected = state::armed;
+    _state.compare_exchange_strong(expected, state::expired);
   }
 
-  void timer::timer_::reset()
+  int timer::timer_::settime(const struct itimerspec& ts, int flags, struct itimerspec* old) noexcept
   {
-    stop();
-    start();
+    // every arm and disarm of every backend passes here
+    std::uint64_t value = static_cast<std::uint64_t>(ts.it_value.tv_sec) * 1000000000 + ts.it_value.tv_nsec;
+    POSIXCPP_TRACE(value ? trace::event::arm : trace::event::disarm, this, value);
+
+    if (_backend == backend::timerfd)
+    {
+      return timerfd_settime(_fd, (flags & TIMER_ABSTIME) ? TFD_TIMER_ABSTIME : 0, &ts, old);
+    }
+    if (_uring)
+    {
+      return _uring->settime(_uring_slot, _clock, ts, flags, old);
+    }
+    if (_virtual)
+    {
+      return _virtual->settime(_virtual_slot, ts, flags, old);
+    }
+    if (_slot && value)
+    {
+      // the pool re-creates a kernel timer which may have a signal pending when it's given back
+      _slot->_armed.store(true, std::memory_order_relaxed);
+    }
+    return timer_settime(_timer, flags, &ts, old);
   }
 
-  void timer::timer_::suspend()
+  namespace
   {
-    struct itimerspec ts;
+    struct timespec to_timespec(std::chrono::nanoseconds ns) noexcept
+    {
+      struct timespec ts;
+      ts.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+      ts.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+      return ts;
+    }
 
-    syslog(LOG_INFO, "trying to suspend timer 0x%lx", (unsigned long)(_timer));
+    std::chrono::nanoseconds to_duration(const struct timespec& ts) noexcept
+    {
+      return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    }
 
-    //get current time from timer
-    if (timer_gettime(_timer, &ts) != 0)
+    bool read_clock(clockid_t clock, std::chrono::nanoseconds& now) noexcept
     {
-      auto ec = make_error_code(error::posix_timer_gettime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      struct timespec ts;
+      if (clock_gettime(clock, &ts) != 0)
+      {
+        return false;
+      }
+      now = to_duration(ts);
+      return true;
     }
 
-    if (ts.it_value.tv_sec == 0 && ts.it_value.tv_nsec == 0)
+    inline void cpu_relax() noexcept
     {
-      // timer is not started, doing nothing
-      auto ec = make_error_code(error::suspend_while_not_running);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+#if defined(__x86_64__) || defined(__i386__)
+      __builtin_ia32_pause();
+#elif defined(__aarch64__)
+      asm volatile("yield");
+#endif
     }
 
-    try 
+    void store_max(std::atomic<std::int64_t>& max, std::int64_t value) noexcept
     {
-      // copy current value
-      std::memcpy(&_ts, &ts, sizeof(ts));
+      auto current = max.load(std::memory_order_relaxed);
+      while (value > current && !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+      {
+      }
     }
-    catch (const std::exception& e) 
+  } // namespace
+
+  bool timer::timer_::read_now(std::chrono::nanoseconds& now) const noexcept
+  {
+    if (_virtual)
     {
-      auto ec = make_error_code(std::errc::not_enough_memory);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      now = _virtual->now();
+      return true;
     }
+    return read_clock(_clock, now);
+  }
+
+  std::chrono::nanoseconds timer::timer_::next_deadline(std::chrono::nanoseconds now) const noexcept
+  {
+    // the first point of the _epoch + k * period grid, which is still in the future
+    auto period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+    auto elapsed = now - _epoch;
+    auto deadline = _epoch;
+    if (elapsed.count() >= 0 && period.count() > 0)
+    {
+      deadline += (elapsed / period + 1) * period;
+    }
+    return deadline;
+  }
+
+  int timer::timer_::arm_coalesced(std::chrono::nanoseconds deadline, struct itimerspec* old) noexcept
+  {
+    struct itimerspec ts{};
 
-    ts.it_value.tv_sec = 0;
-    ts.it_value.tv_nsec = 0;
+    // one shot at the adjusted instant, the expiry arms the next one from the ideal deadline, so no rounding
+    // accumulates; precision timers wake up a spin window early, the others at the aligned instant
+    _deadline = deadline;
+    _instant = _precision ? deadline - _precision->spin_window() : coalescer::align(deadline, _slack);
+    ts.it_value = to_timespec(_instant);
+    return settime(ts, TIMER_ABSTIME, old);
+  }
+
+  std::uint64_t timer::timer_::expire_coalesced() noexcept
+  {
+    auto period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+    auto instant = _instant;
+    auto deadline = _deadline;
+    std::uint64_t expirations = 1;
 
-    if (!_is_single_shot) {
-      ts.it_interval.tv_sec = 0;
-      ts.it_interval.tv_nsec = 0;
+    if (_precision)
+    {
+      // woken up ahead of the deadline, unless the spin window was too short to absorb the wakeup latency
+      read_clock(_clock, instant);
+      instant = std::max(instant, deadline);
     }
 
-    //disarm timer
-    if (timer_settime(_timer, 0, &ts, NULL) != 0)
+    if (_is_single_shot || period.count() <= 0)
     {
-      auto ec = make_error_code(error::posix_timer_settime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      _coalescing.store(false);
+    }
+    else
+    {
+      // every ideal deadline up to the instant is delivered by this wakeup
+      expirations = static_cast<std::uint64_t>((instant - deadline) / period) + 1;
+      if (arm_coalesced(deadline + period * static_cast<std::int64_t>(expirations)) != 0)
+      {
+        auto ec = make_error_code(error::posix_timer_settime);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      }
+
+      if (!_coalescing.load())
+      {
+        // stopped or suspended meanwhile, don't leave the timer armed behind their back
+        struct itimerspec ts{};
+        settime(ts);
+      }
     }
 
-    syslog(LOG_INFO, "timer 0x%lx is suspended", (unsigned long)(_timer));
+    if (_precision)
+    {
+      // the next wakeup is armed already, so its syscall is hidden in the spin window of this one
+      if (!spin(deadline + period * static_cast<std::int64_t>(expirations - 1)))
+      {
+        // stopped or suspended before the deadline
+        return 0;
+      }
+      return expirations;
+    }
+
+    coalescer::record(instant, expirations);
+    return expirations;
   }
 
-  void timer::timer_::resume()
+  bool timer::timer_::adjusts_instant() const noexcept
   {
-    struct itimerspec ts;
+    return _precision || _slack.count() > 0;
+  }
 
-    syslog(LOG_INFO, "trying to resume timer 0x%lx", (unsigned long)(_timer));
+  bool timer::timer_::spin(std::chrono::nanoseconds deadline) noexcept
+  {
+    std::chrono::nanoseconds begin;
+    std::chrono::nanoseconds now;
+    auto cancelled = [this]() {
+      auto s = _state.load(std::memory_order_relaxed);
+      return s == state::idle || s == state::suspended;
+    };
 
-    if (timer_gettime(_timer, &ts) != 0)
+    if (!read_clock(_clock, begin))
     {
-      auto ec = make_error_code(error::posix_timer_gettime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      return !cancelled();
     }
 
-    syslog(LOG_INFO, "the timer 0x%lx ts: %ld, %ld, %ld, %ld", (unsigned long)(_timer),
-        ts.it_value.tv_sec, ts.it_value.tv_nsec,
-        ts.it_interval.tv_sec, ts.it_interval.tv_nsec
-        );
+    // the vDSO clock read is a few tens of nanoseconds, the deadline is met with that precision
+    now = begin;
+    while (now < deadline && !cancelled())
+    {
+      cpu_relax();
+      read_clock(_clock, now);
+    }
 
-    if (ts.it_value.tv_sec != 0 || ts.it_value.tv_nsec != 0)
+    _expiry_stats._spin_total.fetch_add((now - begin).count(), std::memory_order_relaxed);
+    return !cancelled();
+  }
+
+  void timer::timer_::expire(std::uint64_t expirations)
+  {
+    if (_coalescing.load())
     {
-      auto ec = make_error_code(error::resume_already_running);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      // the kernel timer is one shot, the number of elapsed periods follows from the ideal deadline
+      expirations = expire_coalesced();
+      if (expirations == 0)
+      {
+        return;
+      }
     }
 
-    if (timer_settime(_timer, 0, &_ts, NULL) != 0)
+    POSIXCPP_TRACE(trace::event::expire, this, expirations);
+    record_expiry(expirations);
+
+    if (_executor)
     {
-      auto ec = make_error_code(error::posix_timer_settime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      post(expirations);
+      return;
     }
 
-    syslog(LOG_INFO, "timer 0x%lx is resumed", (unsigned long)(_timer));
+    deliver(expirations);
   }
 
-  void timer::timer_::stop()
+  void timer::timer_::post(std::uint64_t expirations) noexcept
   {
-    if (_ts.it_value.tv_sec == 0 && _ts.it_value.tv_nsec == 0 &&  
-        _ts.it_interval.tv_sec == 0 && _ts.it_interval.tv_nsec == 0)
+    // periods are accumulated while a task is queued, so a timer never runs on two workers at once
+    _posted_periods.fetch_add(expirations);
+    if (_posted.fetch_add(1) != 0)
     {
-      auto ec = make_error_code(error::stop_while_not_running);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      return;
+    }
+
+    if (!_executor->execute([this]() { drain_posted(); }, _affinity))
+    {
+      // the executor is saturated, deliver in place rather than lose the expiration
+      drain_posted();
+    }
+  }
 
+  void timer::timer_::drain_posted() noexcept
+  {
+    // one round per post, the periods posted meanwhile are delivered by the following rounds
+    do
+    {
+      auto expirations = _posted_periods.exchange(0);
+      if (expirations != 0)
+      {
+        try
+        {
+          deliver(expirations);
+        }
+        catch (...)
+        {
+          POSIXCPP_LOG(LOG_ERR, "timer_::drain_posted callback has thrown");
+        }
+      }
     }
+    while (_posted.fetch_sub(1) != 1);
+  }
 
-    syslog(LOG_INFO, "timer::timer_ trying to stop timer 0x%lx", (unsigned long)(_timer));
-    _ts.it_value.tv_sec = 0;
-    _ts.it_value.tv_nsec = 0;
+  void timer::timer_::deliver(std::uint64_t expirations)
+  {
+    _expirations.store(expirations, std::memory_order_relaxed);
 
-    if (!_is_single_shot) {
-      _ts.it_interval.tv_sec = 0;
-      _ts.it_interval.tv_nsec = 0;
+    if (!_callback)
+    {
+      return;
     }
 
-    if (timer_settime(_timer, 0, &_ts, NULL) != 0)
+    // calling user given callback function and passing data pointer, once per elapsed period when catching up
+    auto calls = _overrun_policy == overrun_policy::catch_up ? expirations : 1;
+    std::chrono::nanoseconds begin{0};
+    std::chrono::nanoseconds end{0};
+    read_clock(CLOCK_MONOTONIC, begin);
+
+    _callback_stats._calls.fetch_add(calls, std::memory_order_relaxed);
+    POSIXCPP_TRACE(trace::event::callback_begin, this, calls);
+    while (calls--)
     {
-      auto ec = make_error_code(error::posix_timer_settime);
-      syslog(LOG_ERR, "error %d: %s,", ec.value(), ec.message().c_str());
-      throw std::system_error(ec);
+      _callback(_data);
+    }
+    POSIXCPP_TRACE(trace::event::callback_end, this, 0);
+
+    if (read_clock(CLOCK_MONOTONIC, end))
+    {
+      auto duration = end - begin;
+      _callback_stats._total.fetch_add(duration.count(), std::memory_order_relaxed);
+      store_max(_callback_stats._max, duration.count());
+      _callback_stats._duration[timer_stats::bucket(duration)].fetch_add(1, std::memory_order_relaxed);
     }
+  }
 
-    syslog(LOG_INFO, "timer::timer_ stopped timer 0x%lX", (unsigned long)(_timer));
+  void timer::timer_::expect(std::chrono::nanoseconds deadline, std::chrono::nanoseconds now) noexcept
+  {
+    // the deadline stays in the timer clock, the offset maps it to tsc_clock for remaining()
+    _expiry_stats._offset.store((tsc_clock::now().time_since_epoch() - now).count(), std::memory_order_relaxed);
+    _expiry_stats._expected.store(deadline.count(), std::memory_order_relaxed);
   }
 
-  std::error_code timer::timer_::try_start() noexcept
+  std::chrono::nanoseconds timer::timer_::remaining() const noexcept
   {
-    try 
+    auto st = _state.load(std::memory_order_acquire);
+
+    if (st == state::suspended)
     {
-      start();
+      return to_duration(_ts.it_value);
     }
-    catch (const std::system_error& e) 
+    if (st != state::armed && st != state::busy)
     {
-      return e.code();
+      return std::chrono::nanoseconds(0);
     }
-    catch (...)
+
+    auto now = _virtual ? _virtual->now() : tsc_clock::now().time_since_epoch() -
+      std::chrono::nanoseconds(_expiry_stats._offset.load(std::memory_order_relaxed));
+    auto deadline = std::chrono::nanoseconds(_expiry_stats._expected.load(std::memory_order_relaxed));
+    if (now < deadline)
     {
-      return make_error_code(timer::error::unknown_error);
+      return deadline - now;
     }
-    return std::make_error_code(static_cast<std::errc>(0));
+
+    // the expiry has not been handled yet, a periodic timer is already on its way to the next deadline
+    auto period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+    if (_is_single_shot || period.count() <= 0)
+    {
+      return std::chrono::nanoseconds(0);
+    }
+    return period - (now - deadline) % period;
+  }
+
+  void timer::timer_::record_expiry(std::uint64_t expirations) noexcept
+  {
+    auto period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+    std::chrono::nanoseconds now;
+
+    _expiry_stats._fires.fetch_add(1, std::memory_order_relaxed);
+    _expiry_stats._overruns.fetch_add(expirations - 1, std::memory_order_relaxed);
+
+    if (!read_now(now))
+    {
+      return;
+    }
+
+    // the latest ideal deadline delivered by this wakeup, the next one follows a period later
+    auto deadline = std::chrono::nanoseconds(_expiry_stats._expected.load(std::memory_order_relaxed)) +
+      period * static_cast<std::int64_t>(expirations - 1);
+    _expiry_stats._expected.store((deadline + period).count(), std::memory_order_relaxed);
+
+    auto lateness = std::max(now - deadline, std::chrono::nanoseconds(0));
+    _expiry_stats._lateness_total.fetch_add(lateness.count(), std::memory_order_relaxed);
+    store_max(_expiry_stats._lateness_max, lateness.count());
+    _expiry_stats._lateness[timer_stats::bucket(lateness)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void timer::timer_::stats(timer_stats& st) const noexcept
+  {
+    st.id = this;
+    st.clock = _clock;
+    st.period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+    st.starts = _api_stats._starts.load(std::memory_order_relaxed);
+    st.stops = _api_stats._stops.load(std::memory_order_relaxed);
+    st.fires = _expiry_stats._fires.load(std::memory_order_relaxed);
+    st.overruns = _expiry_stats._overruns.load(std::memory_order_relaxed);
+    st.lateness_total = std::chrono::nanoseconds(_expiry_stats._lateness_total.load(std::memory_order_relaxed));
+    st.lateness_max = std::chrono::nanoseconds(_expiry_stats._lateness_max.load(std::memory_order_relaxed));
+    st.spin_total = std::chrono::nanoseconds(_expiry_stats._spin_total.load(std::memory_order_relaxed));
+    st.callbacks = _callback_stats._calls.load(std::memory_order_relaxed);
+    st.callback_total = std::chrono::nanoseconds(_callback_stats._total.load(std::memory_order_relaxed));
+    st.callback_max = std::chrono::nanoseconds(_callback_stats._max.load(std::memory_order_relaxed));
+
+    for (std::size_t i = 0; i < timer_stats::buckets; i++)
+    {
+      st.lateness[i] = _expiry_stats._lateness[i].load(std::memory_order_relaxed);
+      st.callback_duration[i] = _callback_stats._duration[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  registry_slots<timer::timer_> timer::timer_::_registry;
+
+  void timer::timer_::enlist() noexcept
+  {
+    if (_slot)
+    {
+      // the pool has reserved a slot with the kernel timer, assigning it touches no shared state
+      _registry_slot = _slot->_registry;
+      _registry.assign(_registry_slot, this);
+      return;
+    }
+
+    _registry_slot = _registry.attach(this);
+    if (_registry_slot == registry_slots<timer_>::npos)
+    {
+      POSIXCPP_LOG(LOG_WARNING, "timer_ can't be registered, the registry is full");
+    }
+  }
+
+  void timer::timer_::delist() noexcept
+  {
+    // waits for a snapshot copying the statistics of this very timer only, a pooled timer keeps the slot reserved
+    if (_slot)
+    {
+      _registry.clear(_registry_slot);
+    }
+    else
+    {
+      _registry.detach(_registry_slot);
+    }
+    _registry_slot = registry_slots<timer_>::npos;
+  }
+
+  void timer::timer_::detach() noexcept
+  {
+    if (_dispatcher)
+    {
+      // waits for the callbacks already queued to the dispatcher workers
+      _dispatcher->detach(this, _token);
+    }
+    else if (_precision)
+    {
+      // waits for the expiration spinning or running its callback
+      _precision->detach(this, _token);
+    }
+    else if (_signalfd)
+    {
+      // waits for the expiration being dispatched
+      _signalfd->detach(this, _token);
+    }
+  }
+
+  void timer::timer_::snapshot(std::vector<timer_stats>& out)
+  {
+    // grown before any slot is pinned, a timer constructed meanwhile is the only reason to allocate while pinned
+    std::vector<std::pair<std::uint64_t, timer_stats>> live;
+    live.reserve(_registry.capacity());
+    _registry.for_each([&live](timer_& tm, std::uint64_t order) {
+        live.emplace_back();
+        live.back().first = order;
+        tm.stats(live.back().second);
+      });
+
+    // the slots are reused in any order, the attach sequence restores the construction order
+    std::sort(live.begin(), live.end(),
+        [](const std::pair<std::uint64_t, timer_stats>& a, const std::pair<std::uint64_t, timer_stats>& b) {
+          return a.first < b.first;
+        });
+
+    out.clear();
+    out.reserve(live.size());
+    for (auto& entry : live)
+    {
+      out.push_back(entry.second);
+    }
+  }
+
+  std::size_t timer::timer_::registered() noexcept
+  {
+    return _registry.size();
+  }
+
+  std::size_t timer::timer_::reserve_registry() noexcept
+  {
+    return _registry.reserve();
+  }
+
+  void timer::timer_::unreserve_registry(std::size_t slot) noexcept
+  {
+    _registry.unreserve(slot);
+  }
+
+  void timer::timer_::set_overrun_policy(overrun_policy policy) noexcept
+  {
+    _overrun_policy = policy;
+  }
+
+  std::uint64_t timer::timer_::expirations() const noexcept
+  {
+    return _expirations.load(std::memory_order_relaxed);
+  }
+
+  void timer::timer_::set_executor(executor* ex, std::size_t worker) noexcept
+  {
+    _executor = ex;
+    _affinity = worker;
+  }
+
+  void timer::timer_::set_slack(std::chrono::nanoseconds slack) noexcept
+  {
+    _slack = std::max(slack, std::chrono::nanoseconds(0));
+  }
+
+  std::chrono::nanoseconds timer::timer_::slack() const noexcept
+  {
+    return _slack;
+  }
+
+  clockid_t timer::timer_::clock() const noexcept
+  {
+    return _clock;
+  }
+
+  bool timer::timer_::simulated() const noexcept
+  {
+    return _virtual;
+  }
+
+  int timer::timer_::fd() const noexcept
+  {
+    return _fd;
+  }
+
+  std::uint64_t timer::timer_::dispatch()
+  {
+    std::uint64_t expirations = 0;
+
+    if (_backend != backend::timerfd)
+    {
+      return 0;
+    }
+
+    if (read(_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+    {
+      if (errno == EAGAIN || errno == EWOULDBLOCK)
+      {
+        // nothing has expired since the last read
+        return 0;
+      }
+
+      auto ec = make_error_code(error::posix_timerfd_read);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    POSIXCPP_LOG(LOG_DEBUG, "timer_::dispatch period(%lds, %ldns) expirations %lu", _period_sec.count(), _period_nsec.count(),
+        (unsigned long)expirations);
+
+    fired();
+    expire(expirations);
+    return expirations;
+  }
+
+  void timer::timer_::start()
+  {
+    raise(try_start());
+  }
+
+  void timer::timer_::start_at(std::chrono::nanoseconds epoch)
+  {
+    raise(try_start_at(epoch));
+  }
+
+  void timer::timer_::reset()
+  {
+    raise(try_reset());
+  }
+
+  void timer::timer_::suspend()
+  {
+    raise(try_suspend());
+  }
+
+  void timer::timer_::resume()
+  {
+    raise(try_resume());
+  }
+
+  void timer::timer_::stop()
+  {
+    raise(try_stop());
+  }
+
+  std::error_code timer::timer_::try_start() noexcept
+  {
+    return arm(false, false, std::chrono::nanoseconds(0));
+  }
+
+  std::error_code timer::timer_::try_start_at(std::chrono::nanoseconds epoch) noexcept
+  {
+    return arm(false, true, epoch);
   }
 
   std::error_code timer::timer_::try_reset() noexcept
   {
-    try
+    return arm(true, false, std::chrono::nanoseconds(0));
+  }
+
+  std::error_code timer::timer_::arm(bool restart, bool phase_locked, std::chrono::nanoseconds epoch) noexcept
+  {
+    state prior;
+    int flags = 0;
+
+    POSIXCPP_LOG(LOG_INFO, "starting timer with period_sec = %ld, period_nsec = %ld", _period_sec.count(), _period_nsec.count());
+
+    // a restart re-arms the running timer in place, the settime replaces the previous expiry, no stop is needed
+    if (restart && !acquire(bit(state::armed) | bit(state::suspended) | bit(state::expired), prior))
     {
-      reset();
+      return refuse(prior, error::stop_while_not_running);
     }
-    catch (const std::system_error& e) 
+    if (!restart && !acquire(bit(state::idle) | bit(state::suspended) | bit(state::expired), prior))
     {
-      return e.code();
+      return refuse(prior, error::start_already_started);
     }
-    catch (...)
+    transition tr(*this, prior);
+
+    if (!restart)
+    {
+      _phase_locked = phase_locked;
+      _epoch = epoch;
+    }
+
+    _ts.it_value.tv_sec = _period_sec.count();
+    _ts.it_value.tv_nsec = _period_nsec.count();
+    _ts.it_interval = _is_single_shot ? timespec{} : _ts.it_value;
+
+    // the ideal first deadline, the statistics measure the lateness against it
+    std::chrono::nanoseconds start;
+    if (!read_now(start))
+    {
+      return fail(error::posix_clock_gettime);
+    }
+    auto deadline = _phase_locked ? next_deadline(start) : start + to_duration(_ts.it_value);
+    expect(deadline, start);
+
+    if (adjusts_instant())
+    {
+      _coalescing.store(true);
+      if (arm_coalesced(deadline) != 0)
+      {
+        _coalescing.store(false);
+        return fail(error::posix_timer_settime);
+      }
+      tr.commit(state::armed);
+      _api_stats._starts.fetch_add(1, std::memory_order_relaxed);
+
+      POSIXCPP_LOG(LOG_INFO, "timer started with period_sec = %ld, period_nsec = %ld, slack %ld ns", _period_sec.count(),
+          _period_nsec.count(), _slack.count());
+      return std::error_code();
+    }
+
+    // a restarted timer with slack is armed without it now
+    _coalescing.store(false);
+
+    auto ts = _ts;
+    if (_phase_locked)
     {
-      return make_error_code(timer::error::unknown_error);
+      // the first expiry is absolute, the kernel keeps the following ones on the same grid
+      ts.it_value = to_timespec(deadline);
+      flags = TIMER_ABSTIME;
     }
-    return std::make_error_code(static_cast<std::errc>(0));
+
+    // oethrwise set to the defined value
+    if (settime(ts, flags) != 0)
+    {
+      return fail(error::posix_timer_settime);
+    }
+    tr.commit(state::armed);
+    _api_stats._starts.fetch_add(1, std::memory_order_relaxed);
+
+    POSIXCPP_LOG(LOG_INFO, "timer started with preiod_sec = %ld, period_nsec = %ld", _period_sec.count(), _period_nsec.count());
+    return std::error_code();
   }
 
   std::error_code timer::timer_::try_suspend() noexcept
   {
-    try
+    struct itimerspec ts{};
+    struct itimerspec old{};
+    state prior;
+
+    POSIXCPP_LOG(LOG_INFO, "trying to suspend timer 0x%lx", (unsigned long)(_timer));
+
+    if (!acquire(bit(state::armed), prior))
     {
-      suspend();
+      return refuse(prior, error::suspend_while_not_running);
     }
-    catch (const std::system_error& e) 
+    transition tr(*this, prior);
+
+    // a concurrent expiry of a timer with slack must not re-arm it
+    auto coalescing = _coalescing.exchange(false);
+
+    // disarm timer, the old value is the remaining time
+    if (settime(ts, 0, &old) != 0)
     {
-      return e.code();
+      _coalescing.store(coalescing);
+      return fail(error::posix_timer_settime);
     }
-    catch (...)
+
+    if (old.it_value.tv_sec == 0 && old.it_value.tv_nsec == 0)
     {
-      return make_error_code(timer::error::unknown_error);
+      if (_is_single_shot)
+      {
+        // it has just fired, there is nothing left to suspend
+        tr.commit(state::expired);
+        return make_error_code(error::suspend_while_not_running);
+      }
+
+      // a timer with slack caught between its one shot expiry and re-arming, a whole period is left
+      old.it_value = to_timespec(std::chrono::nanoseconds(_period_sec) + _period_nsec);
     }
-    return std::make_error_code(static_cast<std::errc>(0));
+
+    _ts = old;
+    tr.commit(state::suspended);
+    _api_stats._stops.fetch_add(1, std::memory_order_relaxed);
+
+    POSIXCPP_LOG(LOG_INFO, "timer 0x%lx is suspended", (unsigned long)(_timer));
+    return std::error_code();
   }
 
   std::error_code timer::timer_::try_resume() noexcept
   {
-    try 
+    state prior;
+
+    POSIXCPP_LOG(LOG_INFO, "trying to resume timer 0x%lx", (unsigned long)(_timer));
+
+    if (!acquire(bit(state::suspended), prior))
     {
-      resume();
+      if (prior == state::idle || prior == state::expired)
+      {
+        // nothing has been suspended, doing nothing
+        return std::error_code();
+      }
+      return refuse(prior, error::resume_already_running);
     }
-    catch (const std::system_error& e) 
+    transition tr(*this, prior);
+
+    POSIXCPP_LOG(LOG_INFO, "the timer 0x%lx ts: %ld, %ld, %ld, %ld", (unsigned long)(_timer),
+        _ts.it_value.tv_sec, _ts.it_value.tv_nsec,
+        _ts.it_interval.tv_sec, _ts.it_interval.tv_nsec
+        );
+
+    // the ideal next deadline, a resumed timer is late from this point on
+    std::chrono::nanoseconds start;
+    if (!read_now(start))
     {
-      return e.code();
+      return fail(error::posix_clock_gettime);
     }
-    catch (...)
+    auto deadline = _phase_locked ? next_deadline(start) : start + to_duration(_ts.it_value);
+    expect(deadline, start);
+
+    if (adjusts_instant())
+    {
+      _coalescing.store(true);
+      if (arm_coalesced(deadline) != 0)
+      {
+        _coalescing.store(false);
+        return fail(error::posix_timer_settime);
+      }
+      tr.commit(state::armed);
+      _api_stats._starts.fetch_add(1, std::memory_order_relaxed);
+
+      POSIXCPP_LOG(LOG_INFO, "timer 0x%lx is resumed", (unsigned long)(_timer));
+      return std::error_code();
+    }
+
+    auto flags = 0;
+    if (_phase_locked)
+    {
+      // the suspended remaining time is off the grid by now, continue at the next grid deadline instead
+      _ts.it_value = to_timespec(deadline);
+      flags = TIMER_ABSTIME;
+    }
+
+    if (settime(_ts, flags) != 0)
     {
-      return make_error_code(timer::error::unknown_error);
+      return fail(error::posix_timer_settime);
     }
-    return std::make_error_code(static_cast<std::errc>(0));
+    tr.commit(state::armed);
+    _api_stats._starts.fetch_add(1, std::memory_order_relaxed);
+
+    POSIXCPP_LOG(LOG_INFO, "timer 0x%lx is resumed", (unsigned long)(_timer));
+    return std::error_code();
   }
 
   std::error_code timer::timer_::try_stop() noexcept
   {
-    try 
+    struct itimerspec ts{};
+    state prior;
+
+    if (!acquire(bit(state::armed) | bit(state::suspended) | bit(state::expired), prior))
+    {
+      return refuse(prior, error::stop_while_not_running);
+    }
+    transition tr(*this, prior);
+
+    POSIXCPP_LOG(LOG_INFO, "timer::timer_ trying to stop timer 0x%lx", (unsigned long)(_timer));
+    _coalescing.store(false);
+
+    // a suspended or expired timer is disarmed in the kernel already
+    if (prior == state::armed && settime(ts) != 0)
+    {
+      return fail(error::posix_timer_settime);
+    }
+    _ts = ts;
+    tr.commit(state::idle);
+    _api_stats._stops.fetch_add(1, std::memory_order_relaxed);
+
+    POSIXCPP_LOG(LOG_INFO, "timer::timer_ stopped timer 0x%lX", (unsigned long)(_timer));
+    return std::error_code();
+  }
+
+  bool timer::timer_::started() const noexcept
+  {
+    return _state.load() != state::idle;
+  }
+
+  int timer::timer_::arm_absolute(std::chrono::nanoseconds now) noexcept
+  {
+    struct itimerspec ts{};
+    auto period = std::chrono::nanoseconds(_period_sec) + _period_nsec;
+
+    _ts.it_value = to_timespec(period);
+    _ts.it_interval = _is_single_shot ? timespec{} : _ts.it_value;
+
+    // the shared snapshot of the clock replaces a clock read
+    auto deadline = _phase_locked ? next_deadline(now) : now + period;
+    expect(deadline, now);
+    if (adjusts_instant())
     {
-      stop();
+      _coalescing.store(true);
+      if (arm_coalesced(deadline) != 0)
+      {
+        _coalescing.store(false);
+        return -1;
+      }
+      return 0;
     }
-    catch (const std::system_error& e) 
+
+    _coalescing.store(false);
+    ts.it_value = to_timespec(deadline);
+    ts.it_interval = _ts.it_interval;
+    return settime(ts, TIMER_ABSTIME);
+  }
+
+  std::error_code timer::timer_::arm_batch(std::chrono::nanoseconds now, bool keep_phase, bool& was_running) noexcept
+  {
+    state prior;
+
+    if (!acquire(~bit(state::busy), prior))
+    {
+      return make_error_code(error::operation_in_progress);
+    }
+    transition tr(*this, prior);
+
+    if (!keep_phase)
     {
-      return e.code();
+      _phase_locked = false;
+      _epoch = std::chrono::nanoseconds(0);
     }
-    catch (...)
+
+    if (arm_absolute(now) != 0)
+    {
+      return make_error_code(error::posix_timer_settime);
+    }
+
+    was_running = prior == state::armed;
+    tr.commit(state::armed);
+    _api_stats._starts.fetch_add(1, std::memory_order_relaxed);
+    return std::error_code();
+  }
+
+  std::error_code timer::timer_::disarm_batch() noexcept
+  {
+    struct itimerspec ts{};
+    state prior;
+
+    if (!acquire(bit(state::armed) | bit(state::suspended) | bit(state::expired), prior))
+    {
+      return make_error_code(prior == state::busy ? error::operation_in_progress : error::stop_while_not_running);
+    }
+    transition tr(*this, prior);
+
+    _coalescing.store(false);
+    if (prior == state::armed && settime(ts) != 0)
+    {
+      return make_error_code(error::posix_timer_settime);
+    }
+    _ts = ts;
+    tr.commit(state::idle);
+    _api_stats._stops.fetch_add(1, std::memory_order_relaxed);
+    return std::error_code();
+  }
+
+  std::error_code timer::timer_::set_period_batch(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      std::chrono::nanoseconds now) noexcept
+  {
+    state prior;
+
+    if (!acquire(~bit(state::busy), prior))
+    {
+      return make_error_code(error::operation_in_progress);
+    }
+    transition tr(*this, prior);
+
+    _period_sec = period_sec;
+    _period_nsec = period_nsec;
+
+    if (prior == state::armed)
+    {
+      // running, restarted with the new period
+      if (arm_absolute(now) != 0)
+      {
+        return make_error_code(error::posix_timer_settime);
+      }
+      tr.commit(state::armed);
+      return std::error_code();
+    }
+
+    // stopped or suspended, the new period applies from the next start or resume
+    if (!_is_single_shot && prior == state::suspended)
     {
-      return make_error_code(timer::error::unknown_error);
+      _ts.it_interval = to_timespec(std::chrono::nanoseconds(period_sec) + period_nsec);
     }
-    return std::make_error_code(static_cast<std::errc>(0));
+    tr.commit(prior);
+    return std::error_code();
   }
 
 } // namespace posixcpp
@@ -4,39 +4,195 @@
 #include <map>
 #include <memory>
 #include <ratio>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <ctime>
+#include <mutex>
 #include <system_error>
-
-/* Linux system headers */
-#include <syslog.h>
+#include <vector>
 
 /* Local headers */
+#include "executor.h"
+#include "log.h"
+#include "precision_dispatcher.h"
+#include "registry_slots.h"
 #include "timer.h"
+#include "timer_dispatcher.h"
+#include "timer_pool_.h"
+#include "timer_registry.h"
+#include "timer_signalfd.h"
+#include "timer_uring.h"
+#include "virtual_clock.h"
 
 namespace posixcpp
 {
   class timer::timer_
   {
+    friend class precision_dispatcher;
+    friend class timer_dispatcher;
+    friend class timer_signalfd;
+    friend class timer_uring;
+    friend class virtual_clock;
+
+    enum class state : unsigned char
+    {
+      idle,                                   /**< never started or stopped */
+      armed,                                  /**< the kernel timer is running */
+      suspended,                              /**< disarmed, _ts keeps the remaining time */
+      expired,                                /**< single shot timer has fired */
+      busy                                    /**< an operation is changing the kernel timer */
+    };
+
+    static constexpr unsigned bit(state s) noexcept
+    {
+      return 1u << static_cast<unsigned>(s);
+    }
+
+    /**
+     * Owns the busy state for the duration of one operation, the prior state is restored unless commit is called.
+     */
+    class transition
+    {
+      timer_& _tm;
+      state _prior;
+      std::uint64_t _fired;
+      bool _committed;
+
+      public:
+      transition(timer_& tm, state prior) noexcept;
+      ~transition();
+
+      transition(const transition&) = delete;
+      transition& operator=(const transition&) = delete;
+
+      state prior() const noexcept
+      {
+        return _prior;
+      }
+
+      void commit(state next) noexcept;
+    };
+
+    /**
+     * Counters updated by the expiry path
+     */
+    struct alignas(64) expiry_counters
+    {
+      std::atomic<std::int64_t> _expected{0};   /**< ideal deadline of the next expiration */
+      std::atomic<std::int64_t> _offset{0};     /**< tsc_clock minus the timer clock, measured when armed */
+      std::atomic<std::uint64_t> _fires{0};
+      std::atomic<std::uint64_t> _overruns{0};
+      std::atomic<std::int64_t> _lateness_total{0};
+      std::atomic<std::int64_t> _lateness_max{0};
+      std::atomic<std::uint64_t> _lateness[timer_stats::buckets]{};
+      std::atomic<std::int64_t> _spin_total{0};
+    };
+
+    /**
+     * Counters updated around the callback, it might run on an executor or dispatcher worker
+     */
+    struct alignas(64) callback_counters
+    {
+      std::atomic<std::uint64_t> _calls{0};
+      std::atomic<std::int64_t> _total{0};
+      std::atomic<std::int64_t> _max{0};
+      std::atomic<std::uint64_t> _duration[timer_stats::buckets]{};
+    };
+
+    /**
+     * Counters updated by the API callers
+     */
+    struct alignas(64) api_counters
+    {
+      std::atomic<std::uint64_t> _starts{0};
+      std::atomic<std::uint64_t> _stops{0};
+    };
+
+    /* process wide table of the live timers, see timer_registry */
+    static registry_slots<timer_> _registry;
+
     std::chrono::seconds _period_sec;
     std::chrono::nanoseconds _period_nsec;
     callback_t _callback;
     void* _data;
     bool _is_single_shot;
     int _signal;
+    backend _backend;
+    int _fd;                                  /**< timerfd descriptor, -1 for backend::signal */
+    timer_dispatcher::timer_dispatcher_* _dispatcher; /**< dispatcher thread delivery, nullptr otherwise */
+    std::atomic<unsigned> _in_flight;         /**< signals received while a dispatcher worker holds the timer */
+    precision_dispatcher::precision_dispatcher_* _precision; /**< precision mode delivery, nullptr otherwise */
+    timer_pool::timer_pool_* _pool;           /**< pool owning the kernel timer, nullptr if the timer created it */
+    timer_pool::timer_pool_::slot* _slot;     /**< pooled kernel timer */
+    timer_signalfd::timer_signalfd_* _signalfd; /**< signalfd delivery, nullptr otherwise */
+    void* _token;                             /**< sigev_value of a dispatcher, precision or signalfd timer */
+    timer_uring::timer_uring_* _uring;        /**< io_uring timeout delivery, nullptr otherwise */
+    std::uint32_t _uring_slot;                /**< slot of the timer in the timer_uring */
+    virtual_clock::virtual_clock_* _virtual;  /**< simulated time, nullptr otherwise */
+    std::uint32_t _virtual_slot;              /**< slot of the timer in the virtual_clock */
+    std::atomic<std::uint64_t> _overruns;     /**< periods received by the dispatcher, not delivered yet */
+    std::atomic<std::uint64_t> _expirations;  /**< periods covered by the last delivery */
+    overrun_policy _overrun_policy;
+    clockid_t _clock;
+    bool _phase_locked;                       /**< armed on the _epoch + k * period grid */
+    std::chrono::nanoseconds _epoch;
+    std::chrono::nanoseconds _slack;          /**< allowed expiration delay, 0 disables coalescing */
+    std::chrono::nanoseconds _deadline;       /**< ideal next deadline of a timer armed with slack */
+    std::chrono::nanoseconds _instant;        /**< aligned instant a timer with slack is armed at */
+    std::atomic<bool> _coalescing;            /**< armed one shot with slack or spin window, every expiry re-arms */
+    executor* _executor;                      /**< runs the callbacks, nullptr runs them in place */
+    std::size_t _affinity;                    /**< executor worker index or executor::any */
+    std::atomic<std::uint64_t> _posted_periods; /**< periods posted to the executor, not delivered yet */
+    std::atomic<unsigned> _posted;            /**< posts not drained yet, a task is queued while it's not 0 */
+    std::atomic<state> _state;
+    std::atomic<std::uint64_t> _fired;        /**< single shot expiries, tells an arming thread it has raced one */
 
     struct itimerspec _ts;
-    struct sigaction _sa;
     struct sigevent _sev;
 
     timer_t _timer;
 
+    std::size_t _registry_slot;               /**< slot in _registry, npos when the table is full */
+    expiry_counters _expiry_stats;
+    callback_counters _callback_stats;
+    api_counters _api_stats;
+
+    int settime(const struct itimerspec& ts, int flags = 0, struct itimerspec* old = nullptr) noexcept;
+    bool acquire(unsigned allowed, state& prior) noexcept;
+    static std::error_code refuse(state prior, error warning) noexcept;
+    std::error_code fail(error critical) const noexcept;
+    static void raise(const std::error_code& ec);
+    void fired() noexcept;
+    void enlist() noexcept;
+    void delist() noexcept;
+    void detach() noexcept;
+    void expect(std::chrono::nanoseconds deadline, std::chrono::nanoseconds now) noexcept;
+    void record_expiry(std::uint64_t expirations) noexcept;
+    void expire(std::uint64_t expirations);
+    void post(std::uint64_t expirations) noexcept;
+    void drain_posted() noexcept;
+    void deliver(std::uint64_t expirations);
+    std::error_code arm(bool restart, bool phase_locked, std::chrono::nanoseconds epoch) noexcept;
+    std::chrono::nanoseconds next_deadline(std::chrono::nanoseconds now) const noexcept;
+    int arm_coalesced(std::chrono::nanoseconds deadline, struct itimerspec* old = nullptr) noexcept;
+    int arm_absolute(std::chrono::nanoseconds now) noexcept;
+    std::uint64_t expire_coalesced() noexcept;
+    bool adjusts_instant() const noexcept;
+    bool spin(std::chrono::nanoseconds deadline) noexcept;
+
     public:
     static void signal_handler(int sig, siginfo_t *si, void *uc = nullptr);
 
     explicit timer_(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
         callback_t callback, void* data,
-        bool is_single_short, int sig);
+        bool is_single_short, int sig, backend be = backend::signal,
+        timer_dispatcher::timer_dispatcher_* dispatcher = nullptr, clockid_t clock = CLOCK_REALTIME,
+        precision_dispatcher::precision_dispatcher_* precision = nullptr,
+        timer_pool::timer_pool_* pool = nullptr,
+        timer_signalfd::timer_signalfd_* signalfd = nullptr,
+        timer_uring::timer_uring_* uring = nullptr,
+        virtual_clock::virtual_clock_* virtual_time = nullptr);
 
     ~timer_();
 
@@ -46,15 +202,44 @@ namespace posixcpp
     timer_& operator=(timer_&&) = delete;
 
     void start();
+    void start_at(std::chrono::nanoseconds epoch);
     void reset();
     void suspend();
     void resume();
     void stop();
 
     std::error_code try_start() noexcept;
+    std::error_code try_start_at(std::chrono::nanoseconds epoch) noexcept;
     std::error_code try_reset() noexcept;
     std::error_code try_suspend() noexcept;
     std::error_code try_resume() noexcept;
     std::error_code try_stop() noexcept;
+
+    clockid_t clock() const noexcept;
+    bool simulated() const noexcept;
+    bool read_now(std::chrono::nanoseconds& now) const noexcept;
+    int fd() const noexcept;
+    std::uint64_t dispatch();
+
+    void set_overrun_policy(overrun_policy policy) noexcept;
+    std::uint64_t expirations() const noexcept;
+
+    void set_executor(executor* ex, std::size_t worker) noexcept;
+
+    std::chrono::nanoseconds remaining() const noexcept;
+    void stats(timer_stats& st) const noexcept;
+    static void snapshot(std::vector<timer_stats>& out);
+    static std::size_t registered() noexcept;
+    static std::size_t reserve_registry() noexcept;
+    static void unreserve_registry(std::size_t slot) noexcept;
+
+    /* timer_group bulk operations, at most one syscall per timer, the clock is read once per batch by the caller */
+    bool started() const noexcept;
+    std::error_code arm_batch(std::chrono::nanoseconds now, bool keep_phase, bool& was_running) noexcept;
+    std::error_code disarm_batch() noexcept;
+    std::error_code set_period_batch(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+        std::chrono::nanoseconds now) noexcept;
+    void set_slack(std::chrono::nanoseconds slack) noexcept;
+    std::chrono::nanoseconds slack() const noexcept;
   };
 } //namespace posixcpp
@@ -0,0 +1,49 @@
+/* STL C++ headers */
+#include <thread>
+
+/* Local headers */
+#include "timer.h"
+#include "timer_dispatcher.h"
+#include "timer_dispatcher_.h"
+
+namespace posixcpp
+{
+  timer_dispatcher::timer_dispatcher(std::size_t workers, int sig, std::size_t queue_size) :
+    _dispatcher(new timer_dispatcher_(workers, sig, queue_size))
+  {}
+
+  timer_dispatcher::timer_dispatcher(const realtime_profile& profile, std::size_t workers, int sig,
+      std::size_t queue_size) :
+    _dispatcher(new timer_dispatcher_(workers, sig, queue_size, &profile))
+  {}
+
+  timer_dispatcher::~timer_dispatcher()
+  {}
+
+  std::size_t timer_dispatcher::workers() const noexcept
+  {
+    return _dispatcher->workers();
+  }
+
+  std::uint64_t timer_dispatcher::dropped() const noexcept
+  {
+    return _dispatcher->dropped();
+  }
+
+  timer_dispatcher::realtime_status timer_dispatcher::realtime() const noexcept
+  {
+    return _dispatcher->realtime();
+  }
+
+  timer_stats timer_dispatcher::self_test(std::chrono::nanoseconds duration, std::chrono::nanoseconds period)
+  {
+    timer probe(*this, std::chrono::duration_cast<std::chrono::seconds>(period), period % std::chrono::seconds(1),
+        nullptr, nullptr, false, CLOCK_MONOTONIC);
+
+    probe.start();
+    std::this_thread::sleep_for(duration);
+    probe.stop();
+    return probe.stats();
+  }
+
+} //namespace posixcpp
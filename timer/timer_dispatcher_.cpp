@@ -0,0 +1,329 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <alloca.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "timer_dispatcher_.h"
+#include "timer_.h"
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+
+namespace posixcpp
+{
+  namespace
+  {
+    /* glibc has no sched_setattr wrapper, the structure is the kernel one */
+    struct sched_attr_t
+    {
+      std::uint32_t size;
+      std::uint32_t sched_policy;
+      std::uint64_t sched_flags;
+      std::int32_t sched_nice;
+      std::uint32_t sched_priority;
+      std::uint64_t sched_runtime;
+      std::uint64_t sched_deadline;
+      std::uint64_t sched_period;
+    };
+  } // namespace
+
+  timer_dispatcher::timer_dispatcher_::worker::worker(std::size_t queue_size) :
+    _queue(queue_size)
+  {
+    sem_init(&_ready, 0, 0);
+  }
+
+  timer_dispatcher::timer_dispatcher_::worker::~worker()
+  {
+    sem_destroy(&_ready);
+  }
+
+  timer_dispatcher::timer_dispatcher_::timer_dispatcher_(std::size_t workers, int sig, std::size_t queue_size,
+      const realtime_profile* profile) :
+    _signal(sig),
+    _realtime(profile != nullptr),
+    _profile(profile ? *profile : realtime_profile()),
+    _failures(0),
+    _started(0),
+    _running(true),
+    _tid(0),
+    _dropped(0),
+    _next(0)
+  {
+    if (workers == 0)
+    {
+      throw std::invalid_argument("timer_dispatcher needs at least one worker");
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_dispatcher_ ctor workers %lu, signal %d", (unsigned long)workers, sig);
+
+    for (std::size_t i = 0; i < workers; i++)
+    {
+      _workers.emplace_back(new worker(queue_size));
+    }
+
+    for (auto& w : _workers)
+    {
+      w->_thread = std::thread(&timer_dispatcher_::work, this, std::ref(*w));
+    }
+
+    _thread = std::thread(&timer_dispatcher_::run, this);
+
+    // timers can't be targeted at the dispatcher thread until its kernel thread id is known
+    while (_tid.load() == 0 || _started.load() != _workers.size() + 1)
+    {
+      std::this_thread::yield();
+    }
+
+    if (_realtime && _profile.strict && _failures.load() != 0)
+    {
+      shutdown();
+      auto ec = make_error_code(timer::error::realtime_setup_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+  }
+
+  timer_dispatcher::timer_dispatcher_::~timer_dispatcher_()
+  {
+    shutdown();
+  }
+
+  void timer_dispatcher::timer_dispatcher_::setup(const worker* w) noexcept
+  {
+    if (!_realtime)
+    {
+      _started++;
+      return;
+    }
+
+    unsigned failures = 0;
+
+    if (!_profile.cpus.empty())
+    {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      for (auto cpu : _profile.cpus)
+      {
+        CPU_SET(cpu, &set);
+      }
+      if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+      {
+        failures |= not_pinned;
+      }
+    }
+
+    if (_profile.scheduling == realtime_profile::policy::fifo)
+    {
+      struct sched_param param = {};
+      param.sched_priority = _profile.priority;
+      if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+      {
+        failures |= not_scheduled;
+      }
+    }
+    else if (_profile.scheduling == realtime_profile::policy::deadline)
+    {
+      sched_attr_t attr = {};
+      attr.size = sizeof(attr);
+      attr.sched_policy = SCHED_DEADLINE;
+      attr.sched_runtime = static_cast<std::uint64_t>(_profile.runtime.count());
+      attr.sched_deadline = static_cast<std::uint64_t>(_profile.deadline.count());
+      attr.sched_period = static_cast<std::uint64_t>(_profile.period.count());
+      if (syscall(SYS_sched_setattr, 0, &attr, 0) != 0)
+      {
+        failures |= not_scheduled;
+      }
+    }
+
+    if (_profile.lock_memory)
+    {
+      // touch the stack the thread is going to use, the pages stay resident below the stack pointer once locked
+      auto stack = alloca(_profile.stack_prefault);
+      std::memset(stack, 0, _profile.stack_prefault);
+      if (mlock(stack, _profile.stack_prefault) != 0)
+      {
+        failures |= not_locked;
+      }
+
+      // the worker queue is touched by the dispatcher thread and the worker, locking it once is enough
+      if (w && (mlock(w, sizeof(*w)) != 0 || mlock(w->_queue.data(), w->_queue.bytes()) != 0))
+      {
+        failures |= not_locked;
+      }
+    }
+
+    if (failures)
+    {
+      POSIXCPP_LOG(LOG_WARNING, "timer_dispatcher_ real-time profile partly applied, failures 0x%x, errno %d",
+          failures, errno);
+    }
+    _failures.fetch_or(failures);
+    _started++;
+  }
+
+  void timer_dispatcher::timer_dispatcher_::shutdown() noexcept
+  {
+    _running.store(false);
+
+    // wake sigwaitinfo up, the signal is not a timer one and is ignored
+    pthread_kill(_thread.native_handle(), _signal);
+    _thread.join();
+
+    for (auto& w : _workers)
+    {
+      sem_post(&w->_ready);
+      w->_thread.join();
+    }
+  }
+
+  void timer_dispatcher::timer_dispatcher_::run() noexcept
+  {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, _signal);
+
+    // the signal must be blocked to be received with sigwaitinfo
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    setup(nullptr);
+    _tid.store(static_cast<pid_t>(syscall(SYS_gettid)));
+
+    while (_running.load())
+    {
+      siginfo_t si;
+      if (sigwaitinfo(&set, &si) < 0 || si.si_code != SI_TIMER)
+      {
+        continue;
+      }
+
+      auto tm = _slots.pin(si.si_value.sival_ptr);
+      if (!tm)
+      {
+        // the timer was destroyed while its signal was pending
+        continue;
+      }
+
+      // periods are accumulated until a worker delivers them, so a full queue never loses a tick; the timer is
+      // queued only when no worker holds it, so it never runs on two workers at once
+      tm->fired();
+      tm->_overruns += 1 + static_cast<std::uint64_t>(std::max(si.si_overrun, 0));
+      if (tm->_in_flight.fetch_add(1) != 0)
+      {
+        _slots.unpin(si.si_value.sival_ptr);
+        continue;
+      }
+
+      auto pushed = false;
+      for (std::size_t i = 0; i < _workers.size() && !pushed; i++)
+      {
+        auto& w = *_workers[_next];
+        _next = (_next + 1) % _workers.size();
+
+        if (w._queue.push(tm))
+        {
+          sem_post(&w._ready);
+          pushed = true;
+        }
+      }
+
+      if (!pushed)
+      {
+        tm->_in_flight--;
+        _dropped++;
+      }
+      _slots.unpin(si.si_value.sival_ptr);
+    }
+  }
+
+  void timer_dispatcher::timer_dispatcher_::work(worker& w) noexcept
+  {
+    setup(&w);
+
+    while (true)
+    {
+      if (sem_wait(&w._ready) != 0)
+      {
+        // EINTR, try again
+        continue;
+      }
+
+      timer::timer_* tm = nullptr;
+      if (w._queue.pop(tm))
+      {
+        // one round per signal received, the periods accumulated meanwhile are delivered by the following rounds
+        do
+        {
+          auto expirations = tm->_overruns.exchange(0);
+          if (expirations != 0)
+          {
+            tm->expire(expirations);
+          }
+        }
+        while (tm->_in_flight.fetch_sub(1) != 1);
+      }
+      else if (!_running.load())
+      {
+        break;
+      }
+    }
+  }
+
+  int timer_dispatcher::timer_dispatcher_::signal() const noexcept
+  {
+    return _signal;
+  }
+
+  pid_t timer_dispatcher::timer_dispatcher_::tid() const noexcept
+  {
+    return _tid.load();
+  }
+
+  std::size_t timer_dispatcher::timer_dispatcher_::workers() const noexcept
+  {
+    return _workers.size();
+  }
+
+  std::uint64_t timer_dispatcher::timer_dispatcher_::dropped() const noexcept
+  {
+    return _dropped.load();
+  }
+
+  timer_dispatcher::realtime_status timer_dispatcher::timer_dispatcher_::realtime() const noexcept
+  {
+    auto failures = _failures.load();
+
+    realtime_status status;
+    status.pinned = _realtime && !_profile.cpus.empty() && !(failures & not_pinned);
+    status.scheduled = _realtime && _profile.scheduling != realtime_profile::policy::other &&
+      !(failures & not_scheduled);
+    status.locked = _realtime && _profile.lock_memory && !(failures & not_locked);
+    return status;
+  }
+
+  void* timer_dispatcher::timer_dispatcher_::attach(timer::timer_* tm)
+  {
+    return _slots.attach(tm);
+  }
+
+  void timer_dispatcher::timer_dispatcher_::detach(timer::timer_* tm, void* token) noexcept
+  {
+    _slots.detach(token);
+
+    // no new expiration can be queued now, wait for the ones already handed over to the workers
+    while (tm->_in_flight.load() != 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,88 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* Linux system headers */
+#include <semaphore.h>
+#include <sys/types.h>
+
+/* Local headers */
+#include "signal_slots.h"
+#include "timer.h"
+#include "timer_dispatcher.h"
+#include "spsc_ring.h"
+
+namespace posixcpp
+{
+  class timer_dispatcher::timer_dispatcher_
+  {
+    struct worker
+    {
+      spsc_ring<timer::timer_*> _queue;
+      sem_t _ready;                               /**< posted once per queued expiration */
+      std::thread _thread;
+
+      explicit worker(std::size_t queue_size);
+      ~worker();
+    };
+
+    /**
+     * Settings of the real-time profile which have failed on at least one thread
+     */
+    enum failure : unsigned
+    {
+      not_pinned = 1,
+      not_scheduled = 2,
+      not_locked = 4
+    };
+
+    int _signal;
+    bool _realtime;                               /**< the threads apply _profile */
+    realtime_profile _profile;
+    std::atomic<unsigned> _failures;              /**< failure bits of all threads */
+    std::atomic<std::size_t> _started;            /**< threads which have applied the profile */
+    std::atomic<bool> _running;
+    std::atomic<pid_t> _tid;                      /**< kernel thread id of the dispatcher thread */
+    std::atomic<std::uint64_t> _dropped;
+    std::vector<std::unique_ptr<worker>> _workers;
+    std::size_t _next;                            /**< round robin worker index */
+
+    signal_slots<timer::timer_> _slots;           /**< attached timers, stale signals are ignored */
+
+    std::thread _thread;
+
+    void run() noexcept;
+    void work(worker& w) noexcept;
+    void setup(const worker* w) noexcept;
+    void shutdown() noexcept;
+
+    public:
+    explicit timer_dispatcher_(std::size_t workers, int sig, std::size_t queue_size,
+        const realtime_profile* profile = nullptr);
+
+    ~timer_dispatcher_();
+
+    timer_dispatcher_(const timer_dispatcher_&) = delete;
+    timer_dispatcher_(timer_dispatcher_&&) = delete;
+    timer_dispatcher_& operator=(const timer_dispatcher_&) = delete;
+    timer_dispatcher_& operator=(timer_dispatcher_&&) = delete;
+
+    int signal() const noexcept;
+    pid_t tid() const noexcept;
+    std::size_t workers() const noexcept;
+    std::uint64_t dropped() const noexcept;
+    realtime_status realtime() const noexcept;
+
+    /**
+     * @return the sigev_value pointer of *tm*
+     */
+    void* attach(timer::timer_* tm);
+
+    void detach(timer::timer_* tm, void* token) noexcept;
+  };
+} //namespace posixcpp
@@ -0,0 +1,128 @@
+#include <cerrno>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "timer_epoll.h"
+
+namespace posixcpp
+{
+  namespace
+  {
+    /**
+     * Events of a dispatch running on this thread, remove drops the entries of a timer a callback has removed
+     */
+    struct batch
+    {
+      const timer_epoll* _set;
+      struct epoll_event* _events;
+      int _size;
+      batch* _outer;                          /**< dispatch of a callback of the outer batch, nullptr otherwise */
+    };
+
+    thread_local batch* current = nullptr;
+  }
+
+  timer_epoll::timer_epoll() :
+    _fd(epoll_create1(EPOLL_CLOEXEC))
+  {
+    if (_fd < 0)
+    {
+      auto ec = make_error_code(timer::error::epoll_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+  }
+
+  timer_epoll::~timer_epoll()
+  {
+    close(_fd);
+  }
+
+  void timer_epoll::add(timer& tm)
+  {
+    struct epoll_event ev = {};
+    ev.events = EPOLLIN;
+    ev.data.ptr = &tm;
+
+    if (epoll_ctl(_fd, EPOLL_CTL_ADD, tm.fd(), &ev) != 0)
+    {
+      auto ec = make_error_code(timer::error::epoll_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+  }
+
+  void timer_epoll::remove(timer& tm)
+  {
+    if (epoll_ctl(_fd, EPOLL_CTL_DEL, tm.fd(), nullptr) != 0)
+    {
+      auto ec = make_error_code(timer::error::epoll_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    // the timer may be destroyed right after, a pending dispatch of it in a batch of this thread is dropped
+    for (auto b = current; b; b = b->_outer)
+    {
+      for (int i = 0; b->_set == this && i < b->_size; i++)
+      {
+        if (b->_events[i].data.ptr == &tm)
+        {
+          b->_events[i].data.ptr = nullptr;
+        }
+      }
+    }
+  }
+
+  std::size_t timer_epoll::dispatch(std::chrono::milliseconds timeout)
+  {
+    struct epoll_event events[max_events];
+
+    auto n = epoll_wait(_fd, events, max_events, timeout.count() < 0 ? -1 : static_cast<int>(timeout.count()));
+    if (n < 0)
+    {
+      if (errno == EINTR)
+      {
+        return 0;
+      }
+
+      auto ec = make_error_code(timer::error::epoll_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    // a callback or another thread dispatching the same set may have read the expiration of a ready timer already,
+    // a callback may have removed it
+    batch b{this, events, n, current};
+    current = &b;
+    struct restore
+    {
+      batch& _batch;
+
+      ~restore()
+      {
+        current = _batch._outer;
+      }
+    } scope{b};
+
+    std::size_t dispatched = 0;
+    for (int i = 0; i < n; i++)
+    {
+      auto tm = static_cast<timer*>(events[i].data.ptr);
+      if (tm && tm->dispatch() != 0)
+      {
+        dispatched++;
+      }
+    }
+
+    return dispatched;
+  }
+
+  int timer_epoll::fd() const noexcept
+  {
+    return _fd;
+  }
+
+} // namespace posixcpp
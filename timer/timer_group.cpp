@@ -0,0 +1,50 @@
+/* Local headers */
+#include "timer_group.h"
+#include "timer_group_.h"
+
+namespace posixcpp
+{
+  timer_group::timer_group() :
+    _group(new timer_group_())
+  {}
+
+  timer_group::~timer_group()
+  {}
+
+  void timer_group::add(timer& tm)
+  {
+    _group->add(tm._timer);
+  }
+
+  void timer_group::remove(timer& tm) noexcept
+  {
+    _group->remove(tm._timer);
+  }
+
+  std::size_t timer_group::size() const noexcept
+  {
+    return _group->size();
+  }
+
+  const timer_group::results_t& timer_group::start_all() noexcept
+  {
+    return _group->start_all();
+  }
+
+  const timer_group::results_t& timer_group::stop_all() noexcept
+  {
+    return _group->stop_all();
+  }
+
+  const timer_group::results_t& timer_group::reset_all() noexcept
+  {
+    return _group->reset_all();
+  }
+
+  const timer_group::results_t& timer_group::set_period_all(std::chrono::seconds period_sec,
+      std::chrono::nanoseconds period_nsec) noexcept
+  {
+    return _group->set_period_all(period_sec, period_nsec);
+  }
+
+} //namespace posixcpp
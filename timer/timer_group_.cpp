@@ -0,0 +1,154 @@
+#include <algorithm>
+
+#include "log.h"
+#include "timer_.h"
+#include "timer_group_.h"
+
+namespace posixcpp
+{
+  bool timer_group::timer_group_::snapshot::now(const timer::timer_& tm, std::chrono::nanoseconds& now) noexcept
+  {
+    // the virtual time is not a clock of its own, it's read from the timer
+    if (tm.simulated())
+    {
+      return tm.read_now(now);
+    }
+
+    auto clock = tm.clock();
+    for (std::size_t i = 0; i < _size; i++)
+    {
+      if (_clocks[i] == clock)
+      {
+        now = _now[i];
+        return true;
+      }
+    }
+
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0)
+    {
+      return false;
+    }
+
+    now = std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+    if (_size < max_clocks)
+    {
+      _clocks[_size] = clock;
+      _now[_size] = now;
+      _size++;
+    }
+    return true;
+  }
+
+  void timer_group::timer_group_::add(timer::timer_* tm)
+  {
+    _timers.push_back(tm);
+    _results.reserve(_timers.size());
+  }
+
+  void timer_group::timer_group_::remove(timer::timer_* tm) noexcept
+  {
+    _timers.erase(std::remove(_timers.begin(), _timers.end(), tm), _timers.end());
+  }
+
+  std::size_t timer_group::timer_group_::size() const noexcept
+  {
+    return _timers.size();
+  }
+
+  const timer_group::results_t& timer_group::timer_group_::start_all() noexcept
+  {
+    snapshot clocks;
+    _results.assign(_timers.size(), std::error_code());
+
+    for (std::size_t i = 0; i < _timers.size(); i++)
+    {
+      auto tm = _timers[i];
+      std::chrono::nanoseconds now;
+      bool was_running = false;
+
+      if (!clocks.now(*tm, now))
+      {
+        _results[i] = make_error_code(timer::error::posix_clock_gettime);
+        continue;
+      }
+
+      _results[i] = tm->arm_batch(now, false, was_running);
+      if (!_results[i] && was_running)
+      {
+        _results[i] = make_error_code(timer::error::start_already_started);
+      }
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_group_::start_all %lu timers", (unsigned long)_timers.size());
+    return _results;
+  }
+
+  const timer_group::results_t& timer_group::timer_group_::stop_all() noexcept
+  {
+    _results.assign(_timers.size(), std::error_code());
+
+    for (std::size_t i = 0; i < _timers.size(); i++)
+    {
+      _results[i] = _timers[i]->disarm_batch();
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_group_::stop_all %lu timers", (unsigned long)_timers.size());
+    return _results;
+  }
+
+  const timer_group::results_t& timer_group::timer_group_::reset_all() noexcept
+  {
+    snapshot clocks;
+    _results.assign(_timers.size(), std::error_code());
+
+    for (std::size_t i = 0; i < _timers.size(); i++)
+    {
+      auto tm = _timers[i];
+      std::chrono::nanoseconds now;
+      bool was_running = false;
+
+      if (!tm->started())
+      {
+        _results[i] = make_error_code(timer::error::stop_while_not_running);
+        continue;
+      }
+
+      if (!clocks.now(*tm, now))
+      {
+        _results[i] = make_error_code(timer::error::posix_clock_gettime);
+        continue;
+      }
+
+      _results[i] = tm->arm_batch(now, true, was_running);
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_group_::reset_all %lu timers", (unsigned long)_timers.size());
+    return _results;
+  }
+
+  const timer_group::results_t& timer_group::timer_group_::set_period_all(std::chrono::seconds period_sec,
+      std::chrono::nanoseconds period_nsec) noexcept
+  {
+    snapshot clocks;
+    _results.assign(_timers.size(), std::error_code());
+
+    for (std::size_t i = 0; i < _timers.size(); i++)
+    {
+      auto tm = _timers[i];
+      std::chrono::nanoseconds now;
+
+      if (!clocks.now(*tm, now))
+      {
+        _results[i] = make_error_code(timer::error::posix_clock_gettime);
+        continue;
+      }
+
+      _results[i] = tm->set_period_batch(period_sec, period_nsec, now);
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_group_::set_period_all %lu timers", (unsigned long)_timers.size());
+    return _results;
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,44 @@
+#pragma once
+
+/* STL C++ headers */
+#include <chrono>
+#include <ctime>
+#include <vector>
+
+/* Local headers */
+#include "timer.h"
+#include "timer_group.h"
+
+namespace posixcpp
+{
+  class timer_group::timer_group_
+  {
+    /**
+     * Clock readings shared by all members of one batch
+     */
+    class snapshot
+    {
+      static constexpr std::size_t max_clocks = 8;
+
+      clockid_t _clocks[max_clocks];
+      std::chrono::nanoseconds _now[max_clocks];
+      std::size_t _size = 0;
+
+      public:
+      bool now(const timer::timer_& tm, std::chrono::nanoseconds& now) noexcept;
+    };
+
+    std::vector<timer::timer_*> _timers;
+    results_t _results;
+
+    public:
+    void add(timer::timer_* tm);
+    void remove(timer::timer_* tm) noexcept;
+    std::size_t size() const noexcept;
+
+    const results_t& start_all() noexcept;
+    const results_t& stop_all() noexcept;
+    const results_t& reset_all() noexcept;
+    const results_t& set_period_all(std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec) noexcept;
+  };
+} //namespace posixcpp
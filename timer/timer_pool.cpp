@@ -0,0 +1,29 @@
+/* Local headers */
+#include "timer_pool.h"
+#include "timer_pool_.h"
+
+namespace posixcpp
+{
+  timer_pool::timer_pool(std::size_t capacity, clockid_t clock, int sig) :
+    _pool(new timer_pool_(capacity, clock, sig))
+  {}
+
+  timer_pool::~timer_pool()
+  {}
+
+  std::size_t timer_pool::capacity() const noexcept
+  {
+    return _pool->capacity();
+  }
+
+  std::size_t timer_pool::available() const noexcept
+  {
+    return _pool->available();
+  }
+
+  clockid_t timer_pool::clock() const noexcept
+  {
+    return _pool->clock();
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,142 @@
+#include <stdexcept>
+
+#include "log.h"
+#include "timer_.h"
+#include "timer_pool_.h"
+
+namespace posixcpp
+{
+  timer_pool::timer_pool_::timer_pool_(std::size_t capacity, clockid_t clock, int sig) :
+    _capacity(capacity),
+    _clock(clock),
+    _signal(sig),
+    _slots(new slot[capacity]),
+    _created(0),
+    _free(capacity),
+    _available(0)
+  {
+    POSIXCPP_LOG(LOG_INFO, "timer_pool_ ctor capacity %lu, clock %d, signal %d", (unsigned long)capacity, clock, sig);
+
+    // the pooled timers share the handler of the regular ones, it tells a slot from a timer_ by the pointer tag
+    log::prepare_default_sink();
+    struct sigaction sa = {};
+    sa.sa_flags = SA_SIGINFO;
+    sa.sa_sigaction = timer::timer_::signal_handler;
+    sigemptyset(&sa.sa_mask);
+
+    if (sigaction(_signal, &sa, nullptr) != 0)
+    {
+      auto ec = make_error_code(timer::error::signal_handler_registration);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    for (; _created < _capacity; _created++)
+    {
+      auto& s = _slots[_created];
+      s._owner.store(nullptr, std::memory_order_relaxed);
+      s._generation.store(0, std::memory_order_relaxed);
+      s._armed.store(false, std::memory_order_relaxed);
+      s._registry = timer::timer_::reserve_registry();
+
+      if (!create(s, 0))
+      {
+        timer::timer_::unreserve_registry(s._registry);
+        auto ec = make_error_code(timer::error::posix_timer_creation);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        destroy();
+        throw std::system_error(ec);
+      }
+
+      _free.push(&s);
+      _available++;
+    }
+  }
+
+  bool timer_pool::timer_pool_::create(slot& s, std::uintptr_t generation) noexcept
+  {
+    struct sigevent sev = {};
+    sev.sigev_notify = SIGEV_SIGNAL;
+    sev.sigev_signo = _signal;
+    sev.sigev_value.sival_ptr = tag(&s, generation);
+
+    return timer_create(_clock, &sev, &s._timer) == 0;
+  }
+
+  timer_pool::timer_pool_::~timer_pool_()
+  {
+    destroy();
+  }
+
+  void timer_pool::timer_pool_::destroy() noexcept
+  {
+    for (std::size_t i = 0; i < _created; i++)
+    {
+      timer_delete(_slots[i]._timer);
+      timer::timer_::unreserve_registry(_slots[i]._registry);
+    }
+    _created = 0;
+  }
+
+  std::size_t timer_pool::timer_pool_::capacity() const noexcept
+  {
+    return _capacity;
+  }
+
+  std::size_t timer_pool::timer_pool_::available() const noexcept
+  {
+    return _available.load(std::memory_order_relaxed);
+  }
+
+  clockid_t timer_pool::timer_pool_::clock() const noexcept
+  {
+    return _clock;
+  }
+
+  int timer_pool::timer_pool_::signal() const noexcept
+  {
+    return _signal;
+  }
+
+  timer_pool::timer_pool_::slot* timer_pool::timer_pool_::acquire(timer::timer_* tm)
+  {
+    slot* s = nullptr;
+    if (!_free.pop(s))
+    {
+      auto ec = make_error_code(timer::error::pool_exhausted);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+
+    _available.fetch_sub(1, std::memory_order_relaxed);
+    s->_owner.store(tm, std::memory_order_release);
+    return s;
+  }
+
+  void timer_pool::timer_pool_::release(slot* s) noexcept
+  {
+    // the kernel timer is disarmed, a signal still pending for it finds no owner
+    s->_owner.store(nullptr, std::memory_order_release);
+
+    // a kernel timer which has been armed may have a signal pending still, it's re-created with the next generation
+    // so the signal is dropped even once the slot has a new owner; one never armed is handed out again as it is
+    if (s->_armed.exchange(false))
+    {
+      auto stale = s->_timer;
+      auto generation = s->_generation.load(std::memory_order_relaxed) + 1;
+      if (create(*s, generation))
+      {
+        s->_generation.store(generation, std::memory_order_release);
+        timer_delete(stale);
+      }
+      else
+      {
+        s->_timer = stale;
+        POSIXCPP_LOG(LOG_WARNING, "timer_pool_ can't re-create a kernel timer, a stale signal may reach its owner");
+      }
+    }
+    _free.push(s);
+    _available.fetch_add(1, std::memory_order_relaxed);
+  }
+
+} // namespace posixcpp
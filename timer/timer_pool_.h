@@ -0,0 +1,99 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+/* Linux system headers */
+#include <signal.h>
+#include <time.h>
+
+/* Local headers */
+#include "mpmc_ring.h"
+#include "timer.h"
+#include "timer_pool.h"
+
+namespace posixcpp
+{
+  class timer_pool::timer_pool_
+  {
+    public:
+    static constexpr std::uintptr_t alignment = 64;
+    static constexpr std::uintptr_t generations = alignment / 2; /**< generations told apart by a tagged pointer */
+
+    /**
+     * A pre-created kernel timer, its signal carries the slot address tagged with the low bit and the slot
+     * generation, see tag.
+     */
+    struct alignas(alignment) slot
+    {
+      timer_t _timer;
+      std::atomic<timer::timer_*> _owner;     /**< the pooled timer using the slot, nullptr while it's free */
+      std::atomic<std::uintptr_t> _generation; /**< generation of _timer, bumped when it's re-created */
+      std::atomic<bool> _armed;               /**< _timer has been armed since it was handed out */
+      std::size_t _registry;                  /**< timer_registry slot reserved for the pooled timers */
+    };
+
+    /**
+     * @return the sigev_value pointer of *s* at *generation*, the signal handler tells it from a timer_ pointer by
+     * the low bit
+     */
+    static void* tag(slot* s, std::uintptr_t generation) noexcept
+    {
+      return reinterpret_cast<void*>(reinterpret_cast<std::uintptr_t>(s) | (generation % generations) << 1 | 1);
+    }
+
+    /**
+     * @return the slot of a tagged sigev_value pointer, nullptr for a timer_ pointer
+     */
+    static slot* untag(void* ptr) noexcept
+    {
+      auto value = reinterpret_cast<std::uintptr_t>(ptr);
+      return (value & 1) ? reinterpret_cast<slot*>(value & ~(alignment - 1)) : nullptr;
+    }
+
+    /**
+     * @return false for a stale signal of a kernel timer *s* has re-created since, it must be dropped
+     */
+    static bool current(const slot* s, void* ptr) noexcept
+    {
+      auto value = reinterpret_cast<std::uintptr_t>(ptr);
+      return s->_generation.load(std::memory_order_acquire) % generations == (value & (alignment - 1)) >> 1;
+    }
+
+    private:
+    std::size_t _capacity;
+    clockid_t _clock;
+    int _signal;
+    std::unique_ptr<slot[]> _slots;
+    std::size_t _created;                     /**< kernel timers created, all of them unless the constructor failed */
+    mpmc_ring<slot*> _free;                   /**< FIFO of the free slots */
+    std::atomic<std::size_t> _available;
+
+    bool create(slot& s, std::uintptr_t generation) noexcept;
+    void destroy() noexcept;
+
+    public:
+    explicit timer_pool_(std::size_t capacity, clockid_t clock, int sig);
+
+    ~timer_pool_();
+
+    timer_pool_(const timer_pool_&) = delete;
+    timer_pool_(timer_pool_&&) = delete;
+    timer_pool_& operator=(const timer_pool_&) = delete;
+    timer_pool_& operator=(timer_pool_&&) = delete;
+
+    std::size_t capacity() const noexcept;
+    std::size_t available() const noexcept;
+    clockid_t clock() const noexcept;
+    int signal() const noexcept;
+
+    /**
+     * Hands a free kernel timer out to *tm*, it throws timer::error::pool_exhausted when there is none.
+     */
+    slot* acquire(timer::timer_* tm);
+
+    void release(slot* s) noexcept;
+  };
+} //namespace posixcpp
@@ -0,0 +1,20 @@
+/* Local headers */
+#include "timer_registry.h"
+#include "timer.h"
+#include "timer_.h"
+
+namespace posixcpp
+{
+  std::vector<timer_stats> timer_registry::snapshot()
+  {
+    std::vector<timer_stats> out;
+    timer::timer_::snapshot(out);
+    return out;
+  }
+
+  std::size_t timer_registry::size() noexcept
+  {
+    return timer::timer_::registered();
+  }
+
+} //namespace posixcpp
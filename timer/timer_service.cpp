@@ -0,0 +1,84 @@
+/* STL C++ headers */
+#include <stdexcept>
+
+/* Local headers */
+#include "timer_service.h"
+#include "timer_service_.h"
+
+namespace posixcpp
+{
+  timer_service::timer_service(std::size_t shards, std::size_t queue_size) :
+    _service(new timer_service_(shards, queue_size))
+  {}
+
+  timer_service::~timer_service()
+  {}
+
+  std::size_t timer_service::shards() const noexcept
+  {
+    return _service->shards();
+  }
+
+  std::size_t timer_service::local_shard() const noexcept
+  {
+    return _service->local_shard();
+  }
+
+  std::size_t timer_service::size() const noexcept
+  {
+    return _service->size();
+  }
+
+  timer_service::counters timer_service::stats() const noexcept
+  {
+    return _service->stats();
+  }
+
+  timer_service::counters timer_service::stats(std::size_t shard) const
+  {
+    return _service->stats(shard);
+  }
+
+  timer_service::timeout::timeout(timer_service& service, callback_t callback, void* data, std::size_t shard) :
+    _service(*service._service),
+    _shard(shard == local ? service.local_shard() : shard),
+    _callback(callback),
+    _data(data),
+    _word(0),
+    _refs(0),
+    _deadline(0),
+    _generation(0),
+    _index(npos)
+  {
+    if (_shard >= service.shards())
+    {
+      throw std::invalid_argument("timer_service::timeout shard is out of range");
+    }
+  }
+
+  timer_service::timeout::~timeout()
+  {
+    _service.release(*this);
+  }
+
+  void timer_service::timeout::arm(std::chrono::nanoseconds duration) noexcept
+  {
+    _service.arm(*this, duration);
+  }
+
+  bool timer_service::timeout::cancel() noexcept
+  {
+    return _service.cancel(*this);
+  }
+
+  bool timer_service::timeout::armed() const noexcept
+  {
+    return _word.load(std::memory_order_acquire) & 1;
+  }
+
+  std::size_t timer_service::timeout::shard() const noexcept
+  {
+    return _shard;
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,546 @@
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "timer_service_.h"
+#include "tsc_clock.h"
+
+namespace posixcpp
+{
+  thread_local timer_service::timer_service_::shard* timer_service::timer_service_::_self = nullptr;
+
+  timer_service::timer_service_::shard::shard(std::size_t index, int cpu, std::size_t queue_size) :
+    _index(index),
+    _cpu(cpu),
+    _timer_fd(-1),
+    _event_fd(-1),
+    _inbox(queue_size),
+    _programmed(0),
+    _firing(nullptr),
+    _sleep_until(awake),
+    _wake_pending(false),
+    _size(0),
+    _arms(0),
+    _cancels(0),
+    _remote(0),
+    _expirations(0),
+    _wakeups(0)
+  {}
+
+  timer_service::timer_service_::timer_service_(std::size_t shards, std::size_t queue_size) :
+    _running(true)
+  {
+    // the shards follow the process affinity mask, CPUs outside of it map onto them round robin
+    std::vector<int> cpus;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+      for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+      {
+        if (CPU_ISSET(cpu, &set))
+        {
+          cpus.push_back(cpu);
+        }
+      }
+    }
+    if (cpus.empty())
+    {
+      cpus.push_back(0);
+    }
+    if (shards == 0)
+    {
+      shards = cpus.size();
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "timer_service_ ctor shards %lu, queue size %lu", (unsigned long)shards,
+        (unsigned long)queue_size);
+
+    _cpu_shard.resize(static_cast<std::size_t>(cpus.back()) + 1);
+    for (std::size_t cpu = 0; cpu < _cpu_shard.size(); cpu++)
+    {
+      _cpu_shard[cpu] = cpu % shards;
+    }
+    for (std::size_t i = 0; i < cpus.size(); i++)
+    {
+      _cpu_shard[static_cast<std::size_t>(cpus[i])] = i % shards;
+    }
+
+    for (std::size_t i = 0; i < shards; i++)
+    {
+      _shards.emplace_back(new shard(i, cpus[i % cpus.size()], queue_size));
+      auto& s = *_shards.back();
+
+      s._timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+      s._event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+      if (s._timer_fd < 0 || s._event_fd < 0)
+      {
+        shutdown();
+        auto ec = make_error_code(timer::error::posix_timerfd_creation);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+    }
+
+    for (auto& s : _shards)
+    {
+      s->_thread = std::thread(&timer_service_::run, this, std::ref(*s));
+
+      cpu_set_t pin;
+      CPU_ZERO(&pin);
+      CPU_SET(s->_cpu, &pin);
+      if (pthread_setaffinity_np(s->_thread.native_handle(), sizeof(pin), &pin) != 0)
+      {
+        // restricted cpuset, the shard simply floats
+        POSIXCPP_LOG(LOG_WARNING, "timer_service_ can't pin shard %lu to core %d", (unsigned long)s->_index,
+            s->_cpu);
+      }
+    }
+  }
+
+  timer_service::timer_service_::~timer_service_()
+  {
+    shutdown();
+  }
+
+  void timer_service::timer_service_::shutdown() noexcept
+  {
+    _running.store(false);
+
+    for (auto& s : _shards)
+    {
+      if (s->_thread.joinable())
+      {
+        std::uint64_t one = 1;
+        if (write(s->_event_fd, &one, sizeof(one)) < 0)
+        {
+          POSIXCPP_LOG(LOG_ERR, "timer_service_ can't wake shard %lu up", (unsigned long)s->_index);
+        }
+        s->_thread.join();
+      }
+      close(s->_timer_fd);
+      close(s->_event_fd);
+    }
+  }
+
+  bool timer_service::timer_service_::less(shard& s, std::size_t a, std::size_t b) noexcept
+  {
+    return s._queue[a]->_deadline < s._queue[b]->_deadline;
+  }
+
+  void timer_service::timer_service_::swap(shard& s, std::size_t a, std::size_t b) noexcept
+  {
+    std::swap(s._queue[a], s._queue[b]);
+    s._queue[a]->_index = a;
+    s._queue[b]->_index = b;
+  }
+
+  void timer_service::timer_service_::sift_up(shard& s, std::size_t i) noexcept
+  {
+    while (i > 0 && less(s, i, (i - 1) / 2))
+    {
+      swap(s, i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void timer_service::timer_service_::sift_down(shard& s, std::size_t i) noexcept
+  {
+    for (;;)
+    {
+      auto smallest = i;
+      auto left = 2 * i + 1;
+      auto right = left + 1;
+
+      if (left < s._queue.size() && less(s, left, smallest))
+      {
+        smallest = left;
+      }
+      if (right < s._queue.size() && less(s, right, smallest))
+      {
+        smallest = right;
+      }
+      if (smallest == i)
+      {
+        return;
+      }
+      swap(s, i, smallest);
+      i = smallest;
+    }
+  }
+
+  void timer_service::timer_service_::remove(shard& s, std::size_t i) noexcept
+  {
+    auto last = s._queue.size() - 1;
+    s._queue[i]->_index = timeout::npos;
+
+    if (i != last)
+    {
+      s._queue[i] = s._queue[last];
+      s._queue[i]->_index = i;
+    }
+    s._queue.pop_back();
+    s._size.store(s._queue.size(), std::memory_order_relaxed);
+
+    if (i != last)
+    {
+      sift_down(s, i);
+      sift_up(s, i);
+    }
+  }
+
+  timer_service::timer_service_::shard* timer_service::timer_service_::self() const noexcept
+  {
+    auto s = _self;
+    return s && s->_index < _shards.size() && _shards[s->_index].get() == s ? s : nullptr;
+  }
+
+  void timer_service::timer_service_::wait(shard* own) noexcept
+  {
+    // a callback waiting for another shard keeps handling its own inbox, that shard may be waiting for this one
+    if (own)
+    {
+      drain(*own);
+    }
+    else
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  void timer_service::timer_service_::post(timeout& tm, message msg) noexcept
+  {
+    auto& s = *_shards[tm._shard];
+    auto own = self();
+    msg._remote = own != &s && local_shard() != tm._shard;
+
+    tm._refs.fetch_add(1, std::memory_order_relaxed);
+    while (!s._inbox.push(msg))
+    {
+      wait(own);
+    }
+
+    // pairs with the fence of run, either the shard sees the message or the poster sees its wakeup instant; a cancel
+    // leaves its stale entry to the next wakeup
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto until = s._sleep_until.load(std::memory_order_relaxed);
+    if (until != awake && (msg._urgent || (msg._deadline != 0 && msg._deadline < until)) &&
+        !s._wake_pending.exchange(true))
+    {
+      std::uint64_t one = 1;
+      if (write(s._event_fd, &one, sizeof(one)) < 0)
+      {
+        POSIXCPP_LOG(LOG_ERR, "timer_service_ can't wake shard %lu up", (unsigned long)s._index);
+      }
+    }
+  }
+
+  void timer_service::timer_service_::handle(shard& s, const message& msg) noexcept
+  {
+    auto& tm = *msg._timeout;
+    auto word = tm._word.load(std::memory_order_acquire);
+
+    if (msg._remote)
+    {
+      s._remote.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (msg._deadline)
+    {
+      s._arms.fetch_add(1, std::memory_order_relaxed);
+
+      // a later arm or a cancel has been made meanwhile, its own message follows
+      if (word != ((msg._generation << 1) | 1))
+      {
+        tm._refs.fetch_sub(1, std::memory_order_release);
+        return;
+      }
+
+      tm._deadline = msg._deadline;
+      tm._generation = msg._generation;
+      if (tm._index == timeout::npos)
+      {
+        try
+        {
+          s._queue.push_back(&tm);
+        }
+        catch (...)
+        {
+          POSIXCPP_LOG(LOG_ERR, "timer_service_ can't queue a timeout, it's cancelled");
+          tm._word.compare_exchange_strong(word, word & ~std::uint64_t(1));
+          tm._refs.fetch_sub(1, std::memory_order_release);
+          return;
+        }
+
+        // the queue entry holds the message's reference
+        tm._index = s._queue.size() - 1;
+        s._size.store(s._queue.size(), std::memory_order_relaxed);
+        sift_up(s, tm._index);
+        return;
+      }
+
+      sift_down(s, tm._index);
+      sift_up(s, tm._index);
+    }
+    else
+    {
+      s._cancels.fetch_add(1, std::memory_order_relaxed);
+
+      // the queued entry is dropped unless it has been re-armed meanwhile
+      if (tm._index != timeout::npos && word != ((tm._generation << 1) | 1))
+      {
+        remove(s, tm._index);
+        tm._refs.fetch_sub(1, std::memory_order_release);
+      }
+    }
+    tm._refs.fetch_sub(1, std::memory_order_release);
+  }
+
+  void timer_service::timer_service_::drain(shard& s) noexcept
+  {
+    message msg;
+    while (s._inbox.pop(msg))
+    {
+      handle(s, msg);
+    }
+  }
+
+  void timer_service::timer_service_::expire(shard& s) noexcept
+  {
+    auto now = tsc_clock::now().time_since_epoch().count();
+
+    while (!s._queue.empty() && s._queue.front()->_deadline <= now)
+    {
+      auto tm = s._queue.front();
+      remove(s, 0);
+
+      // a cancel racing the expiry wins or loses right here, the handle word decides
+      auto live = (tm->_generation << 1) | 1;
+      if (!tm->_word.compare_exchange_strong(live, tm->_generation << 1))
+      {
+        tm->_refs.fetch_sub(1, std::memory_order_release);
+        continue;
+      }
+      s._expirations.fetch_add(1, std::memory_order_relaxed);
+
+      // the entry's reference is kept while the callback runs, the callback may destroy the timeout
+      s._firing = tm;
+      if (tm->_callback)
+      {
+        try
+        {
+          tm->_callback(tm->_data);
+        }
+        catch (...)
+        {
+          POSIXCPP_LOG(LOG_ERR, "timer_service_::expire callback has thrown");
+        }
+      }
+      if (s._firing)
+      {
+        tm->_refs.fetch_sub(1, std::memory_order_release);
+      }
+      s._firing = nullptr;
+    }
+  }
+
+  void timer_service::timer_service_::sleep(shard& s, std::int64_t instant) noexcept
+  {
+    // an empty queue disarms the timerfd, a zero instant
+    if (instant == std::numeric_limits<std::int64_t>::max())
+    {
+      instant = 0;
+    }
+    if (instant != s._programmed)
+    {
+      struct itimerspec ts{};
+      ts.it_value.tv_sec = instant / 1000000000;
+      ts.it_value.tv_nsec = instant % 1000000000;
+      if (timerfd_settime(s._timer_fd, TFD_TIMER_ABSTIME, &ts, nullptr) != 0)
+      {
+        auto ec = make_error_code(timer::error::posix_timer_settime);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      }
+      s._programmed = instant;
+    }
+
+    struct pollfd fds[2] = {{s._timer_fd, POLLIN, 0}, {s._event_fd, POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0)
+    {
+      return;
+    }
+    s._wakeups.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t value;
+    if (fds[0].revents & POLLIN)
+    {
+      // a fired one shot timerfd is disarmed
+      if (read(s._timer_fd, &value, sizeof(value)) > 0)
+      {
+        s._programmed = 0;
+      }
+    }
+    if (fds[1].revents & POLLIN)
+    {
+      if (read(s._event_fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+      {
+        POSIXCPP_LOG(LOG_ERR, "timer_service_ can't read the wakeup eventfd");
+      }
+      s._wake_pending.store(false);
+    }
+  }
+
+  void timer_service::timer_service_::run(shard& s) noexcept
+  {
+    _self = &s;
+    while (_running.load())
+    {
+      s._sleep_until.store(awake, std::memory_order_relaxed);
+      drain(s);
+      expire(s);
+
+      auto instant = s._queue.empty() ? std::numeric_limits<std::int64_t>::max() : s._queue.front()->_deadline;
+      s._sleep_until.store(instant, std::memory_order_relaxed);
+
+      // pairs with the fence of post, a message posted before the store is seen here
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      message msg;
+      if (s._inbox.pop(msg))
+      {
+        s._sleep_until.store(awake, std::memory_order_relaxed);
+        handle(s, msg);
+        continue;
+      }
+
+      sleep(s, instant);
+    }
+  }
+
+  std::size_t timer_service::timer_service_::shards() const noexcept
+  {
+    return _shards.size();
+  }
+
+  std::size_t timer_service::timer_service_::local_shard() const noexcept
+  {
+    auto cpu = sched_getcpu();
+    if (cpu < 0)
+    {
+      return 0;
+    }
+    auto index = static_cast<std::size_t>(cpu);
+    return index < _cpu_shard.size() ? _cpu_shard[index] : index % _shards.size();
+  }
+
+  std::size_t timer_service::timer_service_::size() const noexcept
+  {
+    std::size_t size = 0;
+    for (auto& s : _shards)
+    {
+      size += s->_size.load(std::memory_order_relaxed);
+    }
+    return size;
+  }
+
+  timer_service::counters timer_service::timer_service_::stats() const noexcept
+  {
+    counters total{};
+    for (std::size_t i = 0; i < _shards.size(); i++)
+    {
+      auto c = stats(i);
+      total.arms += c.arms;
+      total.cancels += c.cancels;
+      total.remote += c.remote;
+      total.expirations += c.expirations;
+      total.wakeups += c.wakeups;
+    }
+    return total;
+  }
+
+  timer_service::counters timer_service::timer_service_::stats(std::size_t shard) const
+  {
+    auto& s = *_shards.at(shard);
+
+    counters c;
+    c.arms = s._arms.load(std::memory_order_relaxed);
+    c.cancels = s._cancels.load(std::memory_order_relaxed);
+    c.remote = s._remote.load(std::memory_order_relaxed);
+    c.expirations = s._expirations.load(std::memory_order_relaxed);
+    c.wakeups = s._wakeups.load(std::memory_order_relaxed);
+    return c;
+  }
+
+  void timer_service::timer_service_::arm(timeout& tm, std::chrono::nanoseconds duration) noexcept
+  {
+    // 0 tells a cancel message, a deadline is never at the clock epoch
+    auto deadline = std::max<std::int64_t>((tsc_clock::now().time_since_epoch() + duration).count(), 1);
+
+    auto word = tm._word.load(std::memory_order_relaxed);
+    std::uint64_t next;
+    do
+    {
+      next = (((word >> 1) + 1) << 1) | 1;
+    }
+    while (!tm._word.compare_exchange_weak(word, next, std::memory_order_acq_rel));
+
+    post(tm, message{&tm, next >> 1, deadline, false, false});
+  }
+
+  bool timer_service::timer_service_::cancel(timeout& tm) noexcept
+  {
+    auto word = tm._word.load(std::memory_order_relaxed);
+    do
+    {
+      if (!(word & 1))
+      {
+        return false;
+      }
+    }
+    while (!tm._word.compare_exchange_weak(word, ((word >> 1) + 1) << 1, std::memory_order_acq_rel));
+
+    // the timeout can't fire any more, the message only frees its queue entry
+    post(tm, message{&tm, 0, 0, false, false});
+    return true;
+  }
+
+  void timer_service::timer_service_::release(timeout& tm) noexcept
+  {
+    auto word = tm._word.load(std::memory_order_relaxed);
+    while (!tm._word.compare_exchange_weak(word, ((word >> 1) + 1) << 1, std::memory_order_acq_rel))
+    {}
+
+    auto& s = *_shards[tm._shard];
+    auto own = self();
+    if (own == &s)
+    {
+      // destroyed by a callback of its own shard, the messages and the queue entry are dropped in place
+      drain(s);
+      if (tm._index != timeout::npos)
+      {
+        remove(s, tm._index);
+        tm._refs.fetch_sub(1, std::memory_order_release);
+      }
+      if (s._firing == &tm)
+      {
+        s._firing = nullptr;
+        tm._refs.fetch_sub(1, std::memory_order_release);
+      }
+      return;
+    }
+
+    post(tm, message{&tm, 0, 0, true, false});
+    while (tm._refs.load(std::memory_order_acquire) != 0)
+    {
+      wait(own);
+    }
+  }
+
+} // namespace posixcpp
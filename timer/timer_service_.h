@@ -0,0 +1,106 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* Local headers */
+#include "mpmc_ring.h"
+#include "timer_service.h"
+
+namespace posixcpp
+{
+  class timer_service::timer_service_
+  {
+    /**
+     * Inbox message, the only way a thread other than the shard's changes the shard queue
+     */
+    struct message
+    {
+      timeout* _timeout;
+      std::uint64_t _generation;              /**< generation the arm was made with, stale when it has changed */
+      std::int64_t _deadline;                 /**< tsc_clock nanoseconds, 0 for a cancel */
+      bool _urgent;                           /**< wakes a sleeping shard up, the poster waits for it */
+      bool _remote;                           /**< posted from a thread on another core */
+    };
+
+    static constexpr std::int64_t awake = std::numeric_limits<std::int64_t>::min();
+
+    /**
+     * One CPU's timer structure and dispatcher thread, cache line aligned so the shards share nothing
+     */
+    struct alignas(64) shard
+    {
+      std::size_t _index;
+      int _cpu;                               /**< CPU the thread is pinned to */
+      int _timer_fd;                          /**< timerfd, CLOCK_MONOTONIC shares the tsc_clock epoch */
+      int _event_fd;                          /**< wakeup eventfd */
+      mpmc_ring<message> _inbox;              /**< posted by any thread, drained by the shard thread only */
+
+      /* owned by the shard thread */
+      std::vector<timeout*> _queue;           /**< binary min heap on timeout::_deadline */
+      std::int64_t _programmed;               /**< absolute wakeup the timerfd is armed at, 0 when disarmed */
+      timeout* _firing;                       /**< timeout whose callback runs, nullptr once it's destroyed */
+
+      alignas(64) std::atomic<std::int64_t> _sleep_until; /**< next wakeup of the sleeping thread, awake otherwise */
+      std::atomic<bool> _wake_pending;        /**< an eventfd write is on its way */
+      std::atomic<std::size_t> _size;
+      std::atomic<std::uint64_t> _arms;
+      std::atomic<std::uint64_t> _cancels;
+      std::atomic<std::uint64_t> _remote;
+      std::atomic<std::uint64_t> _expirations;
+      std::atomic<std::uint64_t> _wakeups;
+
+      std::thread _thread;
+
+      explicit shard(std::size_t index, int cpu, std::size_t queue_size);
+    };
+
+    std::vector<std::unique_ptr<shard>> _shards;
+    std::vector<std::size_t> _cpu_shard;      /**< shard of every CPU */
+    std::atomic<bool> _running;
+
+    static thread_local shard* _self;         /**< shard run by the calling thread, of any service */
+
+    static bool less(shard& s, std::size_t a, std::size_t b) noexcept;
+    static void swap(shard& s, std::size_t a, std::size_t b) noexcept;
+    static void sift_up(shard& s, std::size_t i) noexcept;
+    static void sift_down(shard& s, std::size_t i) noexcept;
+    static void remove(shard& s, std::size_t i) noexcept;
+
+    shard* self() const noexcept;
+    void wait(shard* own) noexcept;
+    void post(timeout& tm, message msg) noexcept;
+    void handle(shard& s, const message& msg) noexcept;
+    void drain(shard& s) noexcept;
+    void expire(shard& s) noexcept;
+    void sleep(shard& s, std::int64_t instant) noexcept;
+    void run(shard& s) noexcept;
+    void shutdown() noexcept;
+
+    public:
+    explicit timer_service_(std::size_t shards, std::size_t queue_size);
+
+    ~timer_service_();
+
+    timer_service_(const timer_service_&) = delete;
+    timer_service_(timer_service_&&) = delete;
+    timer_service_& operator=(const timer_service_&) = delete;
+    timer_service_& operator=(timer_service_&&) = delete;
+
+    std::size_t shards() const noexcept;
+    std::size_t local_shard() const noexcept;
+    std::size_t size() const noexcept;
+    counters stats() const noexcept;
+    counters stats(std::size_t shard) const;
+
+    void arm(timeout& tm, std::chrono::nanoseconds duration) noexcept;
+    bool cancel(timeout& tm) noexcept;
+    void release(timeout& tm) noexcept;
+  };
+} //namespace posixcpp
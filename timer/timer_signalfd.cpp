@@ -0,0 +1,29 @@
+/* Local headers */
+#include "timer_signalfd.h"
+#include "timer_signalfd_.h"
+
+namespace posixcpp
+{
+  timer_signalfd::timer_signalfd(int sig) :
+    _signalfd(new timer_signalfd_(sig))
+  {}
+
+  timer_signalfd::~timer_signalfd()
+  {}
+
+  std::size_t timer_signalfd::dispatch(std::chrono::milliseconds timeout)
+  {
+    return _signalfd->dispatch(timeout);
+  }
+
+  int timer_signalfd::fd() const noexcept
+  {
+    return _signalfd->fd();
+  }
+
+  std::uint64_t timer_signalfd::reads() const noexcept
+  {
+    return _signalfd->reads();
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,162 @@
+#include <cerrno>
+
+#include <poll.h>
+#include <sys/signalfd.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "timer_.h"
+#include "timer_signalfd_.h"
+
+namespace posixcpp
+{
+  timer_signalfd::timer_signalfd_::timer_signalfd_(int sig) :
+    _signal(sig),
+    _fd(-1),
+    _tid(static_cast<pid_t>(syscall(SYS_gettid))),
+    _reads(0)
+  {
+    POSIXCPP_LOG(LOG_INFO, "timer_signalfd_ ctor signal %d, thread %d", sig, (int)_tid);
+
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, _signal);
+
+    // the signal stays pending until it's read from the descriptor, no handler is ever run
+    pthread_sigmask(SIG_BLOCK, &set, &_previous);
+
+    _fd = signalfd(-1, &set, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (_fd < 0)
+    {
+      pthread_sigmask(SIG_SETMASK, &_previous, nullptr);
+      auto ec = make_error_code(timer::error::signalfd_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+  }
+
+  timer_signalfd::timer_signalfd_::~timer_signalfd_()
+  {
+    close(_fd);
+
+    // only the constructing thread can restore its own mask
+    if (static_cast<pid_t>(syscall(SYS_gettid)) == _tid && !sigismember(&_previous, _signal))
+    {
+      sigset_t set;
+      sigemptyset(&set);
+      sigaddset(&set, _signal);
+      pthread_sigmask(SIG_UNBLOCK, &set, nullptr);
+    }
+  }
+
+  int timer_signalfd::timer_signalfd_::signal() const noexcept
+  {
+    return _signal;
+  }
+
+  pid_t timer_signalfd::timer_signalfd_::tid() const noexcept
+  {
+    return _tid;
+  }
+
+  int timer_signalfd::timer_signalfd_::fd() const noexcept
+  {
+    return _fd;
+  }
+
+  std::uint64_t timer_signalfd::timer_signalfd_::reads() const noexcept
+  {
+    return _reads;
+  }
+
+  std::size_t timer_signalfd::timer_signalfd_::dispatch(std::chrono::milliseconds timeout)
+  {
+    if (timeout.count() != 0)
+    {
+      struct pollfd pfd = {};
+      pfd.fd = _fd;
+      pfd.events = POLLIN;
+
+      auto n = poll(&pfd, 1, timeout.count() < 0 ? -1 : static_cast<int>(timeout.count()));
+      if (n < 0 && errno != EINTR)
+      {
+        auto ec = make_error_code(timer::error::signalfd_failed);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+      if (n <= 0)
+      {
+        return 0;
+      }
+    }
+
+    struct signalfd_siginfo records[batch];
+    std::size_t delivered = 0;
+
+    for (;;)
+    {
+      auto bytes = read(_fd, records, sizeof(records));
+      if (bytes < 0)
+      {
+        if (errno == EAGAIN || errno == EINTR)
+        {
+          return delivered;
+        }
+
+        auto ec = make_error_code(timer::error::signalfd_failed);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+
+      auto n = static_cast<std::size_t>(bytes) / sizeof(struct signalfd_siginfo);
+      if (n == 0)
+      {
+        return delivered;
+      }
+      _reads++;
+
+      for (std::size_t i = 0; i < n; i++)
+      {
+        auto token = reinterpret_cast<void*>(static_cast<std::uintptr_t>(records[i].ssi_ptr));
+
+        // the timer may have been destroyed while its signal was pending
+        auto tm = records[i].ssi_code == SI_TIMER ? _slots.pin(token) : nullptr;
+        if (!tm)
+        {
+          continue;
+        }
+
+        try
+        {
+          tm->fired();
+          tm->expire(1 + static_cast<std::uint64_t>(records[i].ssi_overrun));
+        }
+        catch (...)
+        {
+          POSIXCPP_LOG(LOG_ERR, "timer_signalfd_::dispatch callback has thrown");
+        }
+        _slots.unpin(token);
+        delivered++;
+      }
+
+      // a short read has drained the queue, there is no need for another syscall to learn it
+      if (n < batch)
+      {
+        return delivered;
+      }
+    }
+  }
+
+  void* timer_signalfd::timer_signalfd_::attach(timer::timer_* tm)
+  {
+    return _slots.attach(tm);
+  }
+
+  void timer_signalfd::timer_signalfd_::detach(timer::timer_*, void* token) noexcept
+  {
+    // no new expiration can start now, waits for the one being dispatched
+    _slots.detach(token);
+  }
+
+} //namespace posixcpp
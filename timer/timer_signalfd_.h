@@ -0,0 +1,53 @@
+#pragma once
+
+/* STL C++ headers */
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/* Linux system headers */
+#include <signal.h>
+#include <sys/types.h>
+
+/* Local headers */
+#include "signal_slots.h"
+#include "timer.h"
+#include "timer_signalfd.h"
+
+namespace posixcpp
+{
+  class timer_signalfd::timer_signalfd_
+  {
+    int _signal;
+    int _fd;                                      /**< signalfd descriptor */
+    pid_t _tid;                                   /**< kernel thread id of the constructing thread */
+    sigset_t _previous;                           /**< signal mask of the thread before the constructor */
+    std::uint64_t _reads;
+
+    signal_slots<timer::timer_> _slots;           /**< attached timers, stale signals are ignored */
+
+    public:
+    explicit timer_signalfd_(int sig);
+
+    ~timer_signalfd_();
+
+    timer_signalfd_(const timer_signalfd_&) = delete;
+    timer_signalfd_(timer_signalfd_&&) = delete;
+    timer_signalfd_& operator=(const timer_signalfd_&) = delete;
+    timer_signalfd_& operator=(timer_signalfd_&&) = delete;
+
+    int signal() const noexcept;
+    pid_t tid() const noexcept;
+    int fd() const noexcept;
+    std::uint64_t reads() const noexcept;
+
+    std::size_t dispatch(std::chrono::milliseconds timeout);
+
+    /**
+     * @return the sigev_value pointer of *tm*
+     */
+    void* attach(timer::timer_* tm);
+
+    void detach(timer::timer_* tm, void* token) noexcept;
+  };
+} //namespace posixcpp
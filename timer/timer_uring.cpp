@@ -0,0 +1,45 @@
+/* Local headers */
+#include "timer_uring.h"
+#include "timer_uring_.h"
+
+namespace posixcpp
+{
+  constexpr timer_uring::shared_ring_t timer_uring::shared_ring;
+
+  timer_uring::timer_uring(unsigned entries) :
+    _uring(new timer_uring_(true, entries))
+  {}
+
+  timer_uring::timer_uring(shared_ring_t) :
+    _uring(new timer_uring_(false, 0))
+  {}
+
+  timer_uring::~timer_uring()
+  {}
+
+  std::size_t timer_uring::dispatch(std::chrono::milliseconds timeout)
+  {
+    return _uring->dispatch(timeout);
+  }
+
+  std::size_t timer_uring::prepare(const sqe_source_t& source)
+  {
+    return _uring->prepare(source);
+  }
+
+  bool timer_uring::complete(const io_uring_cqe& cqe)
+  {
+    return _uring->complete(cqe);
+  }
+
+  int timer_uring::fd() const noexcept
+  {
+    return _uring->fd();
+  }
+
+  timer_uring::counters timer_uring::stats() const noexcept
+  {
+    return _uring->stats();
+  }
+
+} //namespace posixcpp
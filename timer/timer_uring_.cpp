@@ -0,0 +1,636 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "timer_.h"
+#include "timer_uring_.h"
+
+namespace posixcpp
+{
+  namespace
+  {
+    std::int64_t clock_now(clockid_t clock) noexcept
+    {
+      struct timespec ts;
+      clock_gettime(clock, &ts);
+      return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    std::int64_t to_nanoseconds(const struct timespec& ts) noexcept
+    {
+      return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    struct timespec to_timespec(std::int64_t ns) noexcept
+    {
+      struct timespec ts;
+      ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+      ts.tv_nsec = static_cast<long>(ns % 1000000000);
+      return ts;
+    }
+
+    [[noreturn]] void fail()
+    {
+      auto ec = make_error_code(timer::error::uring_failed);
+      POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      throw std::system_error(ec);
+    }
+  }
+
+  timer_uring::timer_uring_::timer_uring_(bool own, unsigned entries) :
+    _own(own),
+    _fd(-1),
+    _event(-1),
+    _features(0),
+    _sq_ring(MAP_FAILED),
+    _cq_ring(MAP_FAILED),
+    _sq_ring_size(0),
+    _cq_ring_size(0),
+    _sqes(static_cast<io_uring_sqe*>(MAP_FAILED)),
+    _sqes_size(0),
+    _sq_entries(0),
+    _sq_head(nullptr),
+    _sq_tail(nullptr),
+    _sq_mask(nullptr),
+    _sq_array(nullptr),
+    _sq_flags(nullptr),
+    _sq_local(0),
+    _cq_head(nullptr),
+    _cq_tail(nullptr),
+    _cq_mask(nullptr),
+    _cqes(nullptr),
+    _wake_armed(false),
+    _wake_value(0),
+    _waiting(false),
+    _submissions(0),
+    _completions(0),
+    _enters(0),
+    _wakeups(0)
+  {
+    POSIXCPP_LOG(LOG_INFO, "timer_uring_ ctor %s ring, %u entries", own ? "own" : "shared", entries);
+
+    if (_own)
+    {
+      setup(entries);
+    }
+  }
+
+  timer_uring::timer_uring_::~timer_uring_()
+  {
+    if (_own)
+    {
+      // closing the ring cancels the timeouts still in flight
+      close(_fd);
+      unmap();
+      close(_event);
+    }
+  }
+
+  std::uint64_t timer_uring::timer_uring_::user_data(kind k, std::uint32_t index, std::uint16_t generation) noexcept
+  {
+    return (user_tag << 56) | (static_cast<std::uint64_t>(k) << 48) | (static_cast<std::uint64_t>(generation) << 32)
+        | index;
+  }
+
+  void timer_uring::timer_uring_::setup(unsigned entries)
+  {
+    // every periodic timer keeps a timeout in the ring, a roomy completion queue rarely overflows
+    struct io_uring_params params = {};
+    params.flags = IORING_SETUP_CLAMP | IORING_SETUP_CQSIZE;
+    params.cq_entries = entries * cq_factor;
+
+    _fd = static_cast<int>(syscall(SYS_io_uring_setup, entries, &params));
+    if (_fd < 0)
+    {
+      fail();
+    }
+    _features = params.features;
+
+    _sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    if (_features & IORING_FEAT_SINGLE_MMAP)
+    {
+      _sq_ring_size = _cq_ring_size = std::max(_sq_ring_size, _cq_ring_size);
+    }
+    _sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    // the rings are populated up front, filling an entry never faults
+    _sq_ring = mmap(nullptr, _sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd,
+        IORING_OFF_SQ_RING);
+    if (_sq_ring != MAP_FAILED)
+    {
+      _cq_ring = (_features & IORING_FEAT_SINGLE_MMAP) ? _sq_ring :
+          mmap(nullptr, _cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_CQ_RING);
+    }
+    if (_cq_ring != MAP_FAILED)
+    {
+      _sqes = static_cast<io_uring_sqe*>(mmap(nullptr, _sqes_size, PROT_READ | PROT_WRITE,
+          MAP_SHARED | MAP_POPULATE, _fd, IORING_OFF_SQES));
+    }
+    _event = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (_sqes == MAP_FAILED || _event < 0)
+    {
+      unmap();
+      close(_fd);
+      close(_event);
+      fail();
+    }
+
+    auto sq = static_cast<char*>(_sq_ring);
+    _sq_entries = params.sq_entries;
+    _sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    _sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    _sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    _sq_flags = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+    _sq_local = *_sq_tail;
+
+    auto cq = static_cast<char*>(_cq_ring);
+    _cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    _cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    _cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // the submission ring slots map to the entries one to one
+    for (unsigned i = 0; i < _sq_entries; i++)
+    {
+      _sq_array[i] = i;
+    }
+  }
+
+  void timer_uring::timer_uring_::unmap() noexcept
+  {
+    if (_sqes != MAP_FAILED)
+    {
+      munmap(_sqes, _sqes_size);
+    }
+    if (_cq_ring != MAP_FAILED && _cq_ring != _sq_ring)
+    {
+      munmap(_cq_ring, _cq_ring_size);
+    }
+    if (_sq_ring != MAP_FAILED)
+    {
+      munmap(_sq_ring, _sq_ring_size);
+    }
+  }
+
+  io_uring_sqe* timer_uring::timer_uring_::own_sqe() noexcept
+  {
+    auto head = __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+    if (_sq_local - head >= _sq_entries)
+    {
+      return nullptr;
+    }
+
+    auto sqe = &_sqes[_sq_local & *_sq_mask];
+    _sq_local++;
+    return sqe;
+  }
+
+  int timer_uring::timer_uring_::enter(unsigned to_submit, unsigned min_complete,
+      std::chrono::milliseconds timeout) noexcept
+  {
+    __atomic_store_n(_sq_tail, _sq_local, __ATOMIC_RELEASE);
+
+    unsigned flags = 0;
+    void* arg = nullptr;
+    std::size_t argsz = 0;
+    struct __kernel_timespec kts = {};
+    struct io_uring_getevents_arg ext = {};
+
+    if (min_complete)
+    {
+      flags |= IORING_ENTER_GETEVENTS;
+      if (timeout.count() > 0 && (_features & IORING_FEAT_EXT_ARG))
+      {
+        kts.tv_sec = timeout.count() / 1000;
+        kts.tv_nsec = (timeout.count() % 1000) * 1000000;
+        ext.ts = reinterpret_cast<std::uint64_t>(&kts);
+        flags |= IORING_ENTER_EXT_ARG;
+        arg = &ext;
+        argsz = sizeof(ext);
+      }
+      else if (timeout.count() > 0)
+      {
+        // no bounded wait in io_uring_enter, the completion is waited for with poll
+        if (to_submit && syscall(SYS_io_uring_enter, _fd, to_submit, 0, 0, nullptr, 0) < 0)
+        {
+          return -errno;
+        }
+        _enters++;
+        struct pollfd pfd = {_fd, POLLIN, 0};
+        return poll(&pfd, 1, static_cast<int>(timeout.count())) < 0 ? -errno : 0;
+      }
+    }
+    else if (!to_submit)
+    {
+      return 0;
+    }
+
+    _enters++;
+    auto n = syscall(SYS_io_uring_enter, _fd, to_submit, min_complete, flags, arg, argsz);
+    return n < 0 ? -errno : static_cast<int>(n);
+  }
+
+  void timer_uring::timer_uring_::queue(slot& s, std::uint32_t index)
+  {
+    if (!s._queued)
+    {
+      _pending.push_back(index);
+      s._queued = true;
+    }
+
+    if (_own && _waiting.load())
+    {
+      // the blocked dispatch returns, the entry is flushed by the next one
+      std::uint64_t one = 1;
+      if (write(_event, &one, sizeof(one)) == sizeof(one))
+      {
+        _wakeups++;
+      }
+    }
+  }
+
+  bool timer_uring::timer_uring_::sync(slot& s, std::uint32_t index, const sqe_source_t& source)
+  {
+    if (s._submitted && s._submitted_generation != s._generation)
+    {
+      auto sqe = source();
+      if (!sqe)
+      {
+        return false;
+      }
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_TIMEOUT_REMOVE;
+      sqe->fd = -1;
+      sqe->addr = user_data(kind::timeout, index, s._submitted_generation);
+      sqe->user_data = user_data(kind::remove, index, s._submitted_generation);
+      s._submitted = false;
+      _submissions++;
+    }
+
+    if (s._deadline && !s._submitted)
+    {
+      auto sqe = source();
+      if (!sqe)
+      {
+        return false;
+      }
+
+      // an absolute deadline, the delay until the ring is submitted doesn't shift it
+      s._ts.tv_sec = s._deadline / 1000000000;
+      s._ts.tv_nsec = s._deadline % 1000000000;
+      std::memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_TIMEOUT;
+      sqe->fd = -1;
+      sqe->addr = reinterpret_cast<std::uint64_t>(&s._ts);
+      sqe->len = 1;
+      sqe->timeout_flags = IORING_TIMEOUT_ABS | s._clock_flags;
+      sqe->user_data = user_data(kind::timeout, index, s._generation);
+      s._submitted = true;
+      s._submitted_generation = s._generation;
+      _submissions++;
+    }
+    return true;
+  }
+
+  std::size_t timer_uring::timer_uring_::flush(const sqe_source_t& source)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto before = _submissions.load();
+
+    if (_own && !_wake_armed)
+    {
+      if (auto sqe = source())
+      {
+        std::memset(sqe, 0, sizeof(*sqe));
+        sqe->opcode = IORING_OP_READ;
+        sqe->fd = _event;
+        sqe->addr = reinterpret_cast<std::uint64_t>(&_wake_value);
+        sqe->len = sizeof(_wake_value);
+        sqe->user_data = user_data(kind::wake, 0, 0);
+        _wake_armed = true;
+        _submissions++;
+      }
+    }
+
+    // a slot armed and cancelled since the last flush costs no entry at all
+    std::size_t done = 0;
+    for (; done < _pending.size(); done++)
+    {
+      auto& s = _slots[_pending[done]];
+      if (!sync(s, _pending[done], source))
+      {
+        break;
+      }
+      s._queued = false;
+    }
+    _pending.erase(_pending.begin(), _pending.begin() + done);
+
+    return static_cast<std::size_t>(_submissions.load() - before);
+  }
+
+  std::size_t timer_uring::timer_uring_::deliver(const io_uring_cqe& cqe)
+  {
+    auto k = static_cast<kind>((cqe.user_data >> 48) & 0xff);
+    auto index = static_cast<std::uint32_t>(cqe.user_data);
+    auto generation = static_cast<std::uint16_t>(cqe.user_data >> 32);
+    timer::timer_* tm = nullptr;
+    std::uint64_t expirations = 1;
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _completions++;
+
+      if (k == kind::wake)
+      {
+        _wake_armed = false;
+        return 0;
+      }
+      if (k != kind::timeout || index >= _slots.size())
+      {
+        return 0;
+      }
+
+      auto& s = _slots[index];
+      if (!s._submitted || s._submitted_generation != generation)
+      {
+        // a removed timeout, it's no longer in the ring
+        return 0;
+      }
+      s._submitted = false;
+
+      if (cqe.res != -ETIME || s._generation != generation || !s._timer)
+      {
+        // re-armed or cancelled meanwhile, the slot is queued already
+        return 0;
+      }
+
+      tm = s._timer;
+      if (s._interval)
+      {
+        // the next deadline stays on the grid, the periods missed meanwhile are reported as overruns
+        auto now = clock_now(s._clock);
+        if (now >= s._deadline)
+        {
+          expirations += static_cast<std::uint64_t>((now - s._deadline) / s._interval);
+        }
+        s._deadline += static_cast<std::int64_t>(expirations) * s._interval;
+        queue(s, index);
+      }
+      else
+      {
+        s._deadline = 0;
+      }
+      tm->_in_flight++;
+    }
+
+    try
+    {
+      tm->fired();
+      tm->expire(expirations);
+    }
+    catch (...)
+    {
+      POSIXCPP_LOG(LOG_ERR, "timer_uring_::deliver callback has thrown");
+    }
+    tm->_in_flight--;
+    return 1;
+  }
+
+  std::size_t timer_uring::timer_uring_::reap()
+  {
+    std::size_t delivered = 0;
+    auto head = *_cq_head;
+
+    for (;;)
+    {
+      if (head == __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE))
+      {
+        break;
+      }
+
+      // the entry is copied out, so the kernel may reuse it while the callback runs
+      auto cqe = _cqes[head & *_cq_mask];
+      __atomic_store_n(_cq_head, ++head, __ATOMIC_RELEASE);
+      if ((cqe.user_data >> 56) == user_tag)
+      {
+        delivered += deliver(cqe);
+      }
+    }
+    return delivered;
+  }
+
+  int timer_uring::timer_uring_::submit(const sqe_source_t& source, unsigned min_complete,
+      std::chrono::milliseconds timeout)
+  {
+    for (;;)
+    {
+      flush(source);
+
+      bool full;
+      {
+        std::lock_guard<std::mutex> lock(_mutex);
+        full = !_pending.empty();
+      }
+      auto to_submit = _sq_local - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+      if (!full)
+      {
+        // the last batch is submitted by the waiting enter itself
+        return enter(to_submit, min_complete, timeout);
+      }
+
+      // the submission ring is full, it's submitted and filled again
+      auto rc = enter(to_submit, 0, timeout);
+      if (rc <= 0)
+      {
+        return rc;
+      }
+    }
+  }
+
+  std::size_t timer_uring::timer_uring_::dispatch(std::chrono::milliseconds timeout)
+  {
+    if (!_own)
+    {
+      throw std::logic_error("timer_uring::dispatch requires an own ring");
+    }
+
+    auto source = sqe_source_t([this]() { return own_sqe(); });
+    auto check = [](int rc) {
+        if (rc < 0 && rc != -ETIME && rc != -EINTR && rc != -EBUSY && rc != -EAGAIN)
+        {
+          fail();
+        }
+      };
+
+    _waiting.store(timeout.count() != 0);
+    auto rc = submit(source, timeout.count() != 0 ? 1 : 0, timeout);
+    _waiting.store(false);
+    check(rc);
+
+    auto delivered = reap();
+    while (__atomic_load_n(_sq_flags, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)
+    {
+      // the completions which didn't fit the ring are moved into it by a getevents enter
+      _enters++;
+      if (syscall(SYS_io_uring_enter, _fd, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+      {
+        fail();
+      }
+      delivered += reap();
+    }
+
+    // the periodic re-arms and the callbacks' arms are submitted before returning, so the ring is up to date while
+    // the caller waits for fd() readiness
+    check(submit(source, 0, timeout));
+    return delivered;
+  }
+
+  std::size_t timer_uring::timer_uring_::prepare(const sqe_source_t& source)
+  {
+    return flush(source);
+  }
+
+  bool timer_uring::timer_uring_::complete(const io_uring_cqe& cqe)
+  {
+    if ((cqe.user_data >> 56) != user_tag)
+    {
+      return false;
+    }
+    deliver(cqe);
+    return true;
+  }
+
+  int timer_uring::timer_uring_::fd() const noexcept
+  {
+    return _fd;
+  }
+
+  timer_uring::counters timer_uring::timer_uring_::stats() const noexcept
+  {
+    return counters{_submissions.load(), _completions.load(), _enters.load(), _wakeups.load()};
+  }
+
+  std::uint32_t timer_uring::timer_uring_::attach(timer::timer_* tm, clockid_t clock)
+  {
+    unsigned flags;
+    switch (clock)
+    {
+      case CLOCK_MONOTONIC:
+        flags = 0;
+        break;
+      case CLOCK_BOOTTIME:
+        flags = IORING_TIMEOUT_BOOTTIME;
+        break;
+      case CLOCK_REALTIME:
+        flags = IORING_TIMEOUT_REALTIME;
+        break;
+      default:
+        throw std::invalid_argument("timer_uring supports CLOCK_MONOTONIC, CLOCK_BOOTTIME and CLOCK_REALTIME only");
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::uint32_t index;
+    if (!_free.empty())
+    {
+      index = _free.back();
+      _free.pop_back();
+    }
+    else
+    {
+      index = static_cast<std::uint32_t>(_slots.size());
+      _slots.emplace_back();
+    }
+
+    auto& s = _slots[index];
+    s._timer = tm;
+    s._deadline = 0;
+    s._interval = 0;
+    s._clock = clock;
+    s._clock_flags = flags;
+    return index;
+  }
+
+  void timer_uring::timer_uring_::detach(timer::timer_* tm, std::uint32_t index) noexcept
+  {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      auto& s = _slots[index];
+      s._timer = nullptr;
+      s._deadline = 0;
+      s._generation++;
+      if (s._submitted)
+      {
+        try
+        {
+          queue(s, index);
+        }
+        catch (...)
+        {
+          // the timeout completes on its own, it's stale by then
+        }
+      }
+      _free.push_back(index);
+    }
+
+    // no new expiration can start now, wait for the one in progress
+    while (tm->_in_flight.load() != 0)
+    {
+      std::this_thread::yield();
+    }
+  }
+
+  int timer_uring::timer_uring_::settime(std::uint32_t index, clockid_t clock, const struct itimerspec& ts, int flags,
+      struct itimerspec* old) noexcept
+  {
+    auto now = clock_now(clock);
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& s = _slots[index];
+
+    if (old)
+    {
+      *old = {};
+      if (s._deadline)
+      {
+        old->it_value = to_timespec(std::max<std::int64_t>(s._deadline - now, 1));
+        old->it_interval = to_timespec(s._interval);
+      }
+    }
+
+    auto value = to_nanoseconds(ts.it_value);
+    s._generation++;
+    s._interval = to_nanoseconds(ts.it_interval);
+    s._deadline = value == 0 ? 0 : (flags & TIMER_ABSTIME) ? value : now + value;
+
+    // nothing to remove and nothing to arm, e.g. stopping a timer which has expired already
+    if (!s._submitted && !s._deadline)
+    {
+      return 0;
+    }
+
+    try
+    {
+      queue(s, index);
+    }
+    catch (const std::bad_alloc&)
+    {
+      errno = ENOMEM;
+      return -1;
+    }
+    return 0;
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,129 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/* Linux system headers */
+#include <linux/io_uring.h>
+#include <time.h>
+
+/* Local headers */
+#include "timer.h"
+#include "timer_uring.h"
+
+namespace posixcpp
+{
+  class timer_uring::timer_uring_
+  {
+    /**
+     * Kind of a submission entry, it's kept in the user_data of the entry
+     */
+    enum class kind : std::uint8_t
+    {
+      timeout,                                /**< IORING_OP_TIMEOUT arming a timer */
+      remove,                                 /**< IORING_OP_TIMEOUT_REMOVE cancelling an outdated one */
+      wake                                    /**< IORING_OP_READ of the wakeup eventfd */
+    };
+
+    /**
+     * A timer attached to the ring. The generation changes with every arm and cancel, so the completions of a
+     * replaced timeout are recognised as stale; it's kept when the slot is reused by another timer. A changed slot is
+     * queued once, the flush brings the ring in line with its current state, see sync.
+     */
+    struct slot
+    {
+      timer::timer_* _timer;                  /**< nullptr while the slot is free */
+      std::uint16_t _generation;
+      std::int64_t _deadline;                 /**< absolute nanoseconds of the timer clock, 0 when not armed */
+      std::int64_t _interval;                 /**< period of a periodic timer, 0 for a single shot */
+      clockid_t _clock;
+      unsigned _clock_flags;                  /**< IORING_TIMEOUT_* clock of the timer */
+      bool _submitted;                        /**< a timeout is in the ring */
+      std::uint16_t _submitted_generation;    /**< generation of that timeout */
+      bool _queued;                           /**< the slot is in _pending */
+      struct __kernel_timespec _ts;           /**< read by the kernel when the entry is submitted */
+    };
+
+    static constexpr unsigned cq_factor = 8;  /**< completion queue entries per submission queue entry */
+
+    bool _own;                                /**< the ring is set up here, not the application's */
+    int _fd;                                  /**< ring descriptor, -1 with a shared ring */
+    int _event;                               /**< wakeup eventfd of the own ring */
+    unsigned _features;
+
+    /* own ring, mmapped */
+    void* _sq_ring;
+    void* _cq_ring;
+    std::size_t _sq_ring_size;
+    std::size_t _cq_ring_size;
+    io_uring_sqe* _sqes;
+    std::size_t _sqes_size;
+    unsigned _sq_entries;
+    unsigned* _sq_head;
+    unsigned* _sq_tail;
+    unsigned* _sq_mask;
+    unsigned* _sq_array;
+    unsigned* _sq_flags;
+    unsigned _sq_local;                       /**< tail of the filled entries, published by enter */
+    unsigned* _cq_head;
+    unsigned* _cq_tail;
+    unsigned* _cq_mask;
+    io_uring_cqe* _cqes;
+
+    std::mutex _mutex;                        /**< protects _slots, _free, _pending */
+    std::deque<slot> _slots;                  /**< stable addresses, the kernel reads slot::_ts */
+    std::vector<std::uint32_t> _free;
+    std::vector<std::uint32_t> _pending;      /**< slots changed since the last flush */
+    bool _wake_armed;                         /**< the eventfd read is in the ring */
+    std::uint64_t _wake_value;
+
+    std::atomic<bool> _waiting;               /**< a dispatch is blocked in io_uring_enter */
+    std::atomic<std::uint64_t> _submissions;
+    std::atomic<std::uint64_t> _completions;
+    std::atomic<std::uint64_t> _enters;
+    std::atomic<std::uint64_t> _wakeups;
+
+    static std::uint64_t user_data(kind k, std::uint32_t index, std::uint16_t generation) noexcept;
+
+    void setup(unsigned entries);
+    void unmap() noexcept;
+    io_uring_sqe* own_sqe() noexcept;
+    int enter(unsigned to_submit, unsigned min_complete, std::chrono::milliseconds timeout) noexcept;
+    void queue(slot& s, std::uint32_t index);
+    bool sync(slot& s, std::uint32_t index, const sqe_source_t& source);
+    std::size_t flush(const sqe_source_t& source);
+    int submit(const sqe_source_t& source, unsigned min_complete, std::chrono::milliseconds timeout);
+    std::size_t reap();
+    std::size_t deliver(const io_uring_cqe& cqe);
+
+    public:
+    explicit timer_uring_(bool own, unsigned entries);
+
+    ~timer_uring_();
+
+    timer_uring_(const timer_uring_&) = delete;
+    timer_uring_(timer_uring_&&) = delete;
+    timer_uring_& operator=(const timer_uring_&) = delete;
+    timer_uring_& operator=(timer_uring_&&) = delete;
+
+    std::size_t dispatch(std::chrono::milliseconds timeout);
+    std::size_t prepare(const sqe_source_t& source);
+    bool complete(const io_uring_cqe& cqe);
+    int fd() const noexcept;
+    counters stats() const noexcept;
+
+    std::uint32_t attach(timer::timer_* tm, clockid_t clock);
+    void detach(timer::timer_* tm, std::uint32_t index) noexcept;
+
+    /**
+     * timer_settime replacement of the attached timers, it queues the entries and returns at once
+     */
+    int settime(std::uint32_t index, clockid_t clock, const struct itimerspec& ts, int flags,
+        struct itimerspec* old) noexcept;
+  };
+} //namespace posixcpp
@@ -0,0 +1,109 @@
+/* STL C++ headers */
+#include <stdexcept>
+#include <system_error>
+
+/* Local headers */
+#include "log.h"
+#include "timer_wheel.h"
+#include "timer_wheel_.h"
+
+namespace posixcpp
+{
+  namespace
+  {
+    void raise(const std::error_code& ec)
+    {
+      if (ec)
+      {
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+    }
+  } // namespace
+
+  timer_wheel::timer_wheel(std::chrono::nanoseconds resolution, int sig) :
+    _wheel(new timer_wheel_(resolution, sig))
+  {}
+
+  timer_wheel::~timer_wheel()
+  {}
+
+  std::chrono::nanoseconds timer_wheel::resolution() const noexcept
+  {
+    return _wheel->resolution();
+  }
+
+  std::size_t timer_wheel::size() const noexcept
+  {
+    return _wheel->size();
+  }
+
+  timer_wheel::timer::timer(timer_wheel& wheel, std::chrono::seconds period_sec, std::chrono::nanoseconds period_nsec,
+      callback_t callback, void* data, bool is_single_shot) :
+    _wheel(*wheel._wheel),
+    _period(_wheel.ticks(period_sec + period_nsec)),
+    _callback(callback),
+    _data(data),
+    _is_single_shot(is_single_shot),
+    _expires(0),
+    _remaining(0),
+    _state(state::idle)
+  {}
+
+  timer_wheel::timer::~timer()
+  {
+    try_stop();
+  }
+
+  void timer_wheel::timer::start()
+  {
+    raise(try_start());
+  }
+
+  void timer_wheel::timer::reset()
+  {
+    raise(try_reset());
+  }
+
+  void timer_wheel::timer::suspend()
+  {
+    raise(try_suspend());
+  }
+
+  void timer_wheel::timer::resume()
+  {
+    raise(try_resume());
+  }
+
+  void timer_wheel::timer::stop()
+  {
+    raise(try_stop());
+  }
+
+  std::error_code timer_wheel::timer::try_start() noexcept
+  {
+    return _wheel.start(*this);
+  }
+
+  std::error_code timer_wheel::timer::try_reset() noexcept
+  {
+    auto ec = _wheel.stop(*this);
+    return ec ? ec : _wheel.start(*this);
+  }
+
+  std::error_code timer_wheel::timer::try_suspend() noexcept
+  {
+    return _wheel.suspend(*this);
+  }
+
+  std::error_code timer_wheel::timer::try_resume() noexcept
+  {
+    return _wheel.resume(*this);
+  }
+
+  std::error_code timer_wheel::timer::try_stop() noexcept
+  {
+    return _wheel.stop(*this);
+  }
+
+} //namespace posixcpp
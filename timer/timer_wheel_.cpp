@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "log.h"
+#include "timer_wheel_.h"
+
+namespace posixcpp
+{
+  timer_wheel::timer_wheel_::guard::guard(timer_wheel_& wheel) noexcept :
+    _wheel(wheel),
+    _locked(wheel._owner.load() != std::this_thread::get_id())
+  {
+    if (_locked)
+    {
+      while (_wheel._busy.exchange(true, std::memory_order_acquire))
+      {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  timer_wheel::timer_wheel_::guard::~guard()
+  {
+    if (_locked)
+    {
+      _wheel._busy.store(false, std::memory_order_release);
+      // a tick might have arrived while we were holding the wheel, either it sees the wheel free or we see the tick
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      _wheel.drain();
+    }
+  }
+
+  timer_wheel::timer_wheel_::timer_wheel_(std::chrono::nanoseconds resolution, int sig) :
+    _resolution(resolution),
+    _now(0),
+    _armed(0),
+    _pending(0),
+    _busy(false),
+    _owner(),
+    _ticking(false),
+    _tick_timer(std::chrono::duration_cast<std::chrono::seconds>(resolution),
+        resolution % std::chrono::seconds(1),
+        // the kernel merges the ticks missed under load into one delivery, every one of them is processed
+        [this](void*) { _pending.fetch_add(_tick_timer.expirations()); drain(); },
+        nullptr, false, sig)
+  {
+    if (resolution <= std::chrono::nanoseconds(0))
+    {
+      throw std::invalid_argument("timer_wheel resolution must be positive");
+    }
+
+    for (auto& level : _slots)
+    {
+      for (auto& head : level)
+      {
+        head._prev = head._next = &head;
+      }
+    }
+  }
+
+  timer_wheel::timer_wheel_::~timer_wheel_()
+  {
+    _tick_timer.try_stop();
+  }
+
+  void timer_wheel::timer_wheel_::unlink(hook* h) noexcept
+  {
+    h->_prev->_next = h->_next;
+    h->_next->_prev = h->_prev;
+    h->_prev = h->_next = nullptr;
+  }
+
+  void timer_wheel::timer_wheel_::link(hook& head, hook* h) noexcept
+  {
+    h->_prev = head._prev;
+    h->_next = &head;
+    head._prev->_next = h;
+    head._prev = h;
+  }
+
+  void timer_wheel::timer_wheel_::insert(timer& tm) noexcept
+  {
+    auto delta = tm._expires - _now;
+
+    if (delta > max_ticks)
+    {
+      // too far ahead, park it in the last reachable slot and re-cascade later
+      link(_slots[levels - 1][((_now + max_ticks) >> (level_bits * (levels - 1))) & slot_mask], &tm);
+      return;
+    }
+
+    std::size_t level = 0;
+    while (delta >= (std::uint64_t(1) << (level_bits * (level + 1))))
+    {
+      level++;
+    }
+
+    link(_slots[level][(tm._expires >> (level_bits * level)) & slot_mask], &tm);
+  }
+
+  void timer_wheel::timer_wheel_::cascade(hook& head) noexcept
+  {
+    hook list;
+    list._prev = list._next = &list;
+
+    if (head._next != &head)
+    {
+      // move the whole slot to the local list, then re-insert every timer closer to level 0
+      list._next = head._next;
+      list._prev = head._prev;
+      list._next->_prev = &list;
+      list._prev->_next = &list;
+      head._prev = head._next = &head;
+    }
+
+    while (list._next != &list)
+    {
+      auto tm = static_cast<timer*>(list._next);
+      unlink(tm);
+      insert(*tm);
+    }
+  }
+
+  std::uint64_t timer_wheel::timer_wheel_::deadline(std::uint64_t ticks) const noexcept
+  {
+    // the ticks arrived but not processed yet have elapsed as well; a running tick timer is somewhere between two
+    // ticks, the next one is partial and does not count, a stopped one starts its grid when the wheel is armed
+    return _now + _pending.load() + ticks + (_ticking ? 1 : 0);
+  }
+
+  void timer_wheel::timer_wheel_::advance() noexcept
+  {
+    _now++;
+    auto index = _now & slot_mask;
+
+    // the lower level has wrapped around, bring the next upper level slot down
+    for (std::size_t level = 1; index == 0 && level < levels; level++)
+    {
+      index = (_now >> (level_bits * level)) & slot_mask;
+      cascade(_slots[level][index]);
+    }
+
+    auto& head = _slots[0][_now & slot_mask];
+    hook expired;
+    expired._prev = expired._next = &expired;
+    if (head._next != &head)
+    {
+      expired._next = head._next;
+      expired._prev = head._prev;
+      expired._next->_prev = &expired;
+      expired._prev->_next = &expired;
+      head._prev = head._next = &head;
+    }
+
+    // callbacks may stop or start any timer, including the ones still in the expired list
+    while (expired._next != &expired)
+    {
+      auto tm = static_cast<timer*>(expired._next);
+      unlink(tm);
+
+      if (tm->_is_single_shot)
+      {
+        tm->_state = timer::state::expired;
+        _armed--;
+      }
+      else
+      {
+        tm->_expires = std::max(tm->_expires + tm->_period, _now + 1);
+        insert(*tm);
+      }
+
+      if (tm->_callback)
+      {
+        tm->_callback(tm->_data);
+      }
+    }
+  }
+
+  void timer_wheel::timer_wheel_::drain() noexcept
+  {
+    while (_pending.load() != 0)
+    {
+      if (_busy.exchange(true, std::memory_order_seq_cst))
+      {
+        // the holder drains pending ticks when it releases the wheel
+        return;
+      }
+
+      _owner.store(std::this_thread::get_id());
+      for (auto n = _pending.exchange(0); n != 0; n--)
+      {
+        advance();
+      }
+
+      if (_armed.load() == 0 && _ticking)
+      {
+        // nothing left to expire, there is no reason to keep waking up
+        _tick_timer.try_stop();
+        _ticking = false;
+      }
+
+      _owner.store(std::thread::id());
+      _busy.store(false, std::memory_order_release);
+      // pairs with the exchange above, a tick added meanwhile is seen by the loop or drains the wheel itself
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+  }
+
+  void timer_wheel::timer_wheel_::arm() noexcept
+  {
+    _armed++;
+    if (!_ticking)
+    {
+      auto ec = _tick_timer.try_start();
+      if (ec && !is_warning(ec))
+      {
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+      }
+      _ticking = true;
+    }
+  }
+
+  std::chrono::nanoseconds timer_wheel::timer_wheel_::resolution() const noexcept
+  {
+    return _resolution;
+  }
+
+  std::size_t timer_wheel::timer_wheel_::size() const noexcept
+  {
+    return _armed.load();
+  }
+
+  std::uint64_t timer_wheel::timer_wheel_::ticks(std::chrono::nanoseconds period) const noexcept
+  {
+    auto ticks = (period.count() + _resolution.count() - 1) / _resolution.count();
+    return std::max<std::uint64_t>(ticks, 1);
+  }
+
+  std::error_code timer_wheel::timer_wheel_::start(timer& tm) noexcept
+  {
+    guard lock(*this);
+
+    if (tm._state == timer::state::running)
+    {
+      return make_error_code(posixcpp::timer::error::start_already_started);
+    }
+
+    tm._expires = deadline(tm._period);
+    tm._state = timer::state::running;
+    insert(tm);
+    arm();
+    return std::error_code();
+  }
+
+  std::error_code timer_wheel::timer_wheel_::suspend(timer& tm) noexcept
+  {
+    guard lock(*this);
+
+    if (tm._state != timer::state::running)
+    {
+      return make_error_code(posixcpp::timer::error::suspend_while_not_running);
+    }
+
+    unlink(&tm);
+    _armed--;
+    auto now = _now + _pending.load();
+    tm._remaining = tm._expires > now ? tm._expires - now : 1;
+    tm._state = timer::state::suspended;
+    return std::error_code();
+  }
+
+  std::error_code timer_wheel::timer_wheel_::resume(timer& tm) noexcept
+  {
+    guard lock(*this);
+
+    if (tm._state == timer::state::running)
+    {
+      return make_error_code(posixcpp::timer::error::resume_already_running);
+    }
+
+    if (tm._state != timer::state::suspended)
+    {
+      // like posixcpp::timer, resuming a stopped timer does nothing
+      return std::error_code();
+    }
+
+    tm._expires = deadline(tm._remaining);
+    tm._state = timer::state::running;
+    insert(tm);
+    arm();
+    return std::error_code();
+  }
+
+  std::error_code timer_wheel::timer_wheel_::stop(timer& tm) noexcept
+  {
+    guard lock(*this);
+
+    if (tm._state == timer::state::idle)
+    {
+      return make_error_code(posixcpp::timer::error::stop_while_not_running);
+    }
+
+    if (tm._state == timer::state::running)
+    {
+      unlink(&tm);
+      _armed--;
+    }
+    tm._state = timer::state::idle;
+    return std::error_code();
+  }
+
+} // namespace posixcpp
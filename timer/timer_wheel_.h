@@ -0,0 +1,77 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/* Local headers */
+#include "timer.h"
+#include "timer_wheel.h"
+
+namespace posixcpp
+{
+  class timer_wheel::timer_wheel_
+  {
+    static constexpr unsigned level_bits = 8;
+    static constexpr std::size_t levels = 4;
+    static constexpr std::size_t slots = 1 << level_bits;
+    static constexpr std::uint64_t slot_mask = slots - 1;
+    static constexpr std::uint64_t max_ticks = (std::uint64_t(1) << (level_bits * levels)) - 1;
+
+    /**
+     * Serialises wheel updates between user threads and the tick. The tick may run in signal context, so it never
+     * waits: when the wheel is busy the tick is left pending and processed by the thread releasing the guard.
+     * Callbacks may re-enter the wheel, the ticking thread does not take the guard again.
+     */
+    class guard
+    {
+      timer_wheel_& _wheel;
+      bool _locked;
+
+      public:
+      explicit guard(timer_wheel_& wheel) noexcept;
+      ~guard();
+    };
+
+    std::chrono::nanoseconds _resolution;
+    hook _slots[levels][slots];               /**< list sentinels */
+    std::uint64_t _now;                       /**< last tick processed */
+    std::atomic<std::size_t> _armed;          /**< number of linked timers */
+    std::atomic<std::uint64_t> _pending;      /**< ticks not processed yet */
+    std::atomic<bool> _busy;
+    std::atomic<std::thread::id> _owner;      /**< thread running the tick */
+    bool _ticking;
+    posixcpp::timer _tick_timer;              /**< backing POSIX timer */
+
+    static void unlink(hook* h) noexcept;
+    static void link(hook& head, hook* h) noexcept;
+
+    void insert(timer& tm) noexcept;
+    void cascade(hook& head) noexcept;
+    std::uint64_t deadline(std::uint64_t ticks) const noexcept;
+    void advance() noexcept;
+    void drain() noexcept;
+    void arm() noexcept;
+
+    public:
+    explicit timer_wheel_(std::chrono::nanoseconds resolution, int sig);
+
+    ~timer_wheel_();
+
+    timer_wheel_(const timer_wheel_&) = delete;
+    timer_wheel_(timer_wheel_&&) = delete;
+    timer_wheel_& operator=(const timer_wheel_&) = delete;
+    timer_wheel_& operator=(timer_wheel_&&) = delete;
+
+    std::chrono::nanoseconds resolution() const noexcept;
+    std::size_t size() const noexcept;
+    std::uint64_t ticks(std::chrono::nanoseconds period) const noexcept;
+
+    std::error_code start(timer& tm) noexcept;
+    std::error_code suspend(timer& tm) noexcept;
+    std::error_code resume(timer& tm) noexcept;
+    std::error_code stop(timer& tm) noexcept;
+  };
+} //namespace posixcpp
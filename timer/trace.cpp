@@ -0,0 +1,301 @@
+/* STL C++ headers */
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+
+/* C headers */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/* Local headers */
+#include "log.h"
+#include "timer.h"
+#include "trace.h"
+#include "tsc_clock.h"
+
+namespace posixcpp
+{
+  namespace trace
+  {
+    namespace detail
+    {
+      std::atomic<bool> _enabled(false);
+    }
+
+    namespace
+    {
+      /**
+       * The mapped trace buffer. It is never unmapped at exit, threads may still record while the statics are
+       * destroyed; a restart replaces it.
+       */
+      struct buffer
+      {
+        std::mutex _mutex;                    /**< serialises start and stop */
+        void* _base = nullptr;
+        std::size_t _size = 0;
+        int _fd = -1;
+        file_header* _header = nullptr;
+        std::size_t _ring_size = 0;           /**< ring_header and records of one ring */
+        std::atomic<std::uint64_t> _session{0}; /**< bumped by every start, outdates the rings of the threads */
+        bool _raw = false;                    /**< the records hold counter values rather than nanoseconds */
+      };
+
+      buffer _buffer;
+
+      /* initial-exec TLS is a plain fs relative load, no __tls_get_addr call, so recording is signal safe */
+      thread_local ring_header* _ring __attribute__((tls_model("initial-exec"))) = nullptr;
+      thread_local std::uint64_t _ring_session __attribute__((tls_model("initial-exec"))) = 0;
+
+      const char* names[] = {"arm", "disarm", "expire", "callback_begin", "callback_end"};
+
+      ring_header* ring(std::size_t index) noexcept
+      {
+        return reinterpret_cast<ring_header*>(reinterpret_cast<char*>(_buffer._header + 1) +
+            index * _buffer._ring_size);
+      }
+
+      record* records(ring_header* r) noexcept
+      {
+        return reinterpret_cast<record*>(r + 1);
+      }
+
+      /**
+       * Hands the next free ring to the calling thread, or the ring of a thread which has exited, nullptr when all are
+       * taken by live threads
+       */
+      ring_header* claim(std::uint64_t session) noexcept
+      {
+        // a signal handler may be claiming, errno of the interrupted code is kept
+        int err = errno;
+        file_header* h = _buffer._header;
+        auto tid = static_cast<std::uint32_t>(syscall(SYS_gettid));
+        std::uint32_t index = h->_claimed.fetch_add(1, std::memory_order_relaxed);
+
+        _ring_session = session;
+        _ring = nullptr;
+        if (index < h->_threads)
+        {
+          _ring = ring(index);
+          _ring->_tid.store(tid, std::memory_order_relaxed);
+        }
+        else
+        {
+          auto pid = getpid();
+          for (std::uint32_t i = 0; i < h->_threads && !_ring; i++)
+          {
+            // the owner has exited if its thread id is gone, the id may be reused meanwhile, which only misses the ring
+            std::uint32_t owner = ring(i)->_tid.load(std::memory_order_relaxed);
+            if (syscall(SYS_tgkill, pid, owner, 0) == -1 && errno == ESRCH &&
+                ring(i)->_tid.compare_exchange_strong(owner, tid, std::memory_order_relaxed))
+            {
+              _ring = ring(i);
+            }
+          }
+        }
+
+        if (_ring)
+        {
+          prctl(PR_GET_NAME, _ring->_name, 0, 0, 0);
+        }
+        errno = err;
+        return _ring;
+      }
+
+      /**
+       * Stores the current counter calibration into the header, a longer trace gets a more accurate one
+       */
+      void calibrate(file_header* h) noexcept
+      {
+        if (_buffer._raw)
+        {
+          h->_counter = tsc_clock::counter();
+          h->_origin = tsc_clock::now().time_since_epoch().count();
+          h->_frequency = tsc_clock::frequency();
+        }
+      }
+
+      void unmap() noexcept
+      {
+        if (_buffer._base)
+        {
+          munmap(_buffer._base, _buffer._size);
+          _buffer._base = nullptr;
+        }
+        if (_buffer._fd != -1)
+        {
+          close(_buffer._fd);
+          _buffer._fd = -1;
+        }
+        _buffer._header = nullptr;
+      }
+
+      [[noreturn]] void fail()
+      {
+        unmap();
+        auto ec = make_error_code(timer::error::trace_failed);
+        POSIXCPP_LOG(LOG_ERR, "error %d: %s,", ec.value(), ec);
+        throw std::system_error(ec);
+      }
+    }
+
+    void start(const options& opt)
+    {
+      std::lock_guard<std::mutex> lock(_buffer._mutex);
+
+      detail::_enabled.store(false);
+      unmap();
+
+      std::size_t capacity = 2;
+      while (capacity < opt.capacity)
+      {
+        capacity <<= 1;
+      }
+      std::size_t threads = std::max<std::size_t>(opt.threads, 1);
+
+      _buffer._ring_size = sizeof(ring_header) + capacity * sizeof(record);
+      _buffer._size = sizeof(file_header) + threads * _buffer._ring_size;
+
+      if (opt.path)
+      {
+        _buffer._fd = open(opt.path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (_buffer._fd == -1 || ftruncate(_buffer._fd, static_cast<off_t>(_buffer._size)) == -1)
+        {
+          fail();
+        }
+        _buffer._base = mmap(nullptr, _buffer._size, PROT_READ | PROT_WRITE, MAP_SHARED, _buffer._fd, 0);
+      }
+      else
+      {
+        _buffer._base = mmap(nullptr, _buffer._size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      }
+      if (_buffer._base == MAP_FAILED)
+      {
+        _buffer._base = nullptr;
+        fail();
+      }
+
+      // the records hold raw counter values once the clock has been calibrated, a few milliseconds after its first read
+      tsc_clock::now();
+      for (int i = 0; i < 20 && !tsc_clock::uses_tsc(); i++)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        tsc_clock::now();
+      }
+      _buffer._raw = tsc_clock::uses_tsc();
+
+      // both mappings come zero filled, so do the ring heads
+      auto h = new (_buffer._base) file_header();
+      std::memcpy(h->_magic, magic, sizeof(magic));
+      h->_record_size = sizeof(record);
+      h->_threads = static_cast<std::uint32_t>(threads);
+      h->_capacity = capacity;
+      h->_pid = static_cast<std::uint32_t>(getpid());
+      calibrate(h);
+      _buffer._header = h;
+
+      _buffer._session.fetch_add(1);
+      detail::_enabled.store(true);
+    }
+
+    void stop() noexcept
+    {
+      std::lock_guard<std::mutex> lock(_buffer._mutex);
+
+      detail::_enabled.store(false);
+      if (_buffer._header)
+      {
+        calibrate(_buffer._header);
+      }
+      if (_buffer._fd != -1)
+      {
+        msync(_buffer._base, _buffer._size, MS_SYNC);
+      }
+    }
+
+    void write(event e, const void* id, std::uint64_t arg) noexcept
+    {
+      std::uint64_t session = _buffer._session.load(std::memory_order_acquire);
+      ring_header* r = _ring;
+
+      if (_ring_session != session)
+      {
+        r = claim(session);
+      }
+      if (!r)
+      {
+        _buffer._header->_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+      }
+
+      // the slot is taken before it's written, an event recorded by a signal handler interrupting this one gets the
+      // next slot
+      std::uint64_t head = r->_head.load(std::memory_order_relaxed);
+      r->_head.store(head + 1, std::memory_order_relaxed);
+      std::atomic_signal_fence(std::memory_order_seq_cst);
+
+      record& slot = records(r)[head & (_buffer._header->_capacity - 1)];
+      slot._timestamp = _buffer._raw ? tsc_clock::counter() :
+        static_cast<std::uint64_t>(tsc_clock::now().time_since_epoch().count());
+      slot._id = reinterpret_cast<std::uint64_t>(id);
+      slot._arg = arg;
+      slot._event = e;
+      slot._tid = r->_tid.load(std::memory_order_relaxed);
+    }
+
+    std::vector<record> snapshot()
+    {
+      std::lock_guard<std::mutex> lock(_buffer._mutex);
+      std::vector<record> result;
+      file_header* h = _buffer._header;
+
+      if (!h)
+      {
+        return result;
+      }
+      calibrate(h);
+
+      std::size_t rings = std::min<std::size_t>(h->_claimed.load(), h->_threads);
+      for (std::size_t i = 0; i < rings; i++)
+      {
+        ring_header* r = ring(i);
+        std::uint64_t head = r->_head.load(std::memory_order_acquire);
+        std::uint64_t n = std::min<std::uint64_t>(head, h->_capacity);
+
+        for (std::uint64_t j = head - n; j < head; j++)
+        {
+          result.push_back(records(r)[j & (h->_capacity - 1)]);
+        }
+      }
+
+      std::stable_sort(result.begin(), result.end(), [](const record& a, const record& b) {
+          return a._timestamp < b._timestamp;
+        });
+      for (auto& r : result)
+      {
+        r._timestamp = nanoseconds(*h, r._timestamp);
+      }
+      return result;
+    }
+
+    std::uint64_t dropped() noexcept
+    {
+      std::lock_guard<std::mutex> lock(_buffer._mutex);
+      return _buffer._header ? _buffer._header->_dropped.load() : 0;
+    }
+
+    const char* name(event e) noexcept
+    {
+      auto i = static_cast<std::size_t>(e);
+      return i < sizeof(names) / sizeof(names[0]) ? names[i] : "unknown";
+    }
+
+  } // namespace trace
+} // namespace posixcpp
@@ -0,0 +1,146 @@
+/* STL C++ headers */
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+/* Local headers */
+#include "tsc_clock.h"
+
+namespace posixcpp
+{
+  // zero initialized before any dynamic initialization, the clock is usable from static constructors
+  tsc_clock::state tsc_clock::_state;
+
+  namespace
+  {
+    constexpr std::chrono::milliseconds warmup_interval(10); /**< first calibration span */
+
+    bool invariant_tsc() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      unsigned eax, ebx, ecx, edx;
+      if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+      {
+        return false;
+      }
+      // the counter ticks at a constant rate in all P, C and T states
+      return (edx & (1u << 8)) != 0;
+#elif defined(__aarch64__)
+      // the generic timer virtual counter always runs at a constant rate
+      return true;
+#else
+      return false;
+#endif
+    }
+
+    std::int64_t monotonic_ns() noexcept
+    {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+  } // namespace
+
+  std::chrono::nanoseconds tsc_clock::warmup() noexcept
+  {
+    auto ns = monotonic_ns();
+    auto support = _state._support.load(std::memory_order_acquire);
+
+    if (support == 0)
+    {
+      bool expected = false;
+      if (_state._writing.compare_exchange_strong(expected, true, std::memory_order_acquire))
+      {
+        if (_state._support.load(std::memory_order_relaxed) == 0)
+        {
+          // the counter is read on both sides of the clock, the midpoint is the best estimate of its value
+          auto before = ticks();
+          auto origin = monotonic_ns();
+          auto after = ticks();
+          _state._origin_tsc.store(before + (after - before) / 2, std::memory_order_relaxed);
+          _state._origin_ns.store(origin, std::memory_order_relaxed);
+          _state._support.store(invariant_tsc() ? 1 : -1, std::memory_order_release);
+        }
+        _state._writing.store(false, std::memory_order_release);
+      }
+    }
+    else if (support > 0 && ns - _state._origin_ns.load(std::memory_order_relaxed) >=
+        std::chrono::nanoseconds(warmup_interval).count())
+    {
+      recalibrate();
+    }
+
+    return std::chrono::nanoseconds(ns);
+  }
+
+  void tsc_clock::recalibrate() noexcept
+  {
+    if (_state._support.load(std::memory_order_acquire) <= 0)
+    {
+      return;
+    }
+
+    bool expected = false;
+    if (!_state._writing.compare_exchange_strong(expected, true, std::memory_order_acquire))
+    {
+      // somebody else is recalibrating, the readers go on with the current slot
+      return;
+    }
+
+    auto before = ticks();
+    auto ns = monotonic_ns();
+    auto after = ticks();
+    auto tsc = before + (after - before) / 2;
+
+    auto origin_tsc = _state._origin_tsc.load(std::memory_order_relaxed);
+    auto origin_ns = _state._origin_ns.load(std::memory_order_relaxed);
+    if (tsc <= origin_tsc || ns <= origin_ns)
+    {
+      _state._writing.store(false, std::memory_order_release);
+      return;
+    }
+
+    // the rate is measured over the whole span since the origin, the reading error is amortized over it
+    auto mult = static_cast<std::uint64_t>((static_cast<unsigned __int128>(ns - origin_ns) << shift) /
+        (tsc - origin_tsc));
+    auto interval = static_cast<std::uint64_t>((static_cast<unsigned __int128>(recalibration_interval.count()) << shift) /
+        mult);
+
+    if (_state._ready.load(std::memory_order_relaxed))
+    {
+      // the clock goes on from its current reading and its offset against CLOCK_MONOTONIC is slewed out over the next
+      // interval: both slots agree at tsc, so switching them never steps the clock, and the rate changes by half at most
+      auto current = convert(tsc).count();
+      auto span = recalibration_interval.count();
+      auto offset = std::clamp<std::int64_t>(ns - current, -span / 2, span / 2);
+      mult = static_cast<std::uint64_t>((static_cast<unsigned __int128>(span + offset) << shift) / interval);
+      ns = current;
+    }
+
+    auto generation = _state._generation.load(std::memory_order_relaxed);
+    auto& c = _state._slots[(generation + 1) & 1];
+    c._tsc.store(tsc, std::memory_order_relaxed);
+    c._ns.store(ns, std::memory_order_relaxed);
+    c._mult.store(mult, std::memory_order_relaxed);
+    _state._generation.store(generation + 1, std::memory_order_release);
+
+    _state._next.store(tsc + interval, std::memory_order_relaxed);
+    _state._ready.store(true, std::memory_order_release);
+    _state._writing.store(false, std::memory_order_release);
+  }
+
+  double tsc_clock::frequency() noexcept
+  {
+    if (!uses_tsc())
+    {
+      return 0;
+    }
+
+    auto generation = _state._generation.load(std::memory_order_acquire);
+    auto mult = _state._slots[generation & 1]._mult.load(std::memory_order_relaxed);
+    return 1e9 * static_cast<double>(std::uint64_t(1) << shift) / static_cast<double>(mult);
+  }
+
+} //namespace posixcpp
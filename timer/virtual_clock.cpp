@@ -0,0 +1,44 @@
+/* Local headers */
+#include "virtual_clock.h"
+#include "virtual_clock_.h"
+
+namespace posixcpp
+{
+  virtual_clock::virtual_clock(std::chrono::nanoseconds start) :
+    _clock(new virtual_clock_(start))
+  {}
+
+  virtual_clock::~virtual_clock()
+  {}
+
+  std::chrono::nanoseconds virtual_clock::now() const noexcept
+  {
+    return _clock->now();
+  }
+
+  std::size_t virtual_clock::advance(std::chrono::nanoseconds duration)
+  {
+    return _clock->advance_to(_clock->now() + duration);
+  }
+
+  std::size_t virtual_clock::advance_to(std::chrono::nanoseconds instant)
+  {
+    return _clock->advance_to(instant);
+  }
+
+  std::chrono::nanoseconds virtual_clock::next_deadline() const noexcept
+  {
+    return _clock->next_deadline();
+  }
+
+  std::size_t virtual_clock::size() const noexcept
+  {
+    return _clock->size();
+  }
+
+  virtual_clock::counters virtual_clock::stats() const noexcept
+  {
+    return _clock->stats();
+  }
+
+} //namespace posixcpp
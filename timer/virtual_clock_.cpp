@@ -0,0 +1,319 @@
+/* STL C++ headers */
+#include <algorithm>
+#include <limits>
+
+/* Local headers */
+#include "log.h"
+#include "timer_.h"
+#include "virtual_clock_.h"
+
+namespace posixcpp
+{
+  namespace
+  {
+    std::int64_t to_nanoseconds(const struct timespec& ts) noexcept
+    {
+      return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    struct timespec to_timespec(std::int64_t ns) noexcept
+    {
+      struct timespec ts;
+      ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+      ts.tv_nsec = static_cast<long>(ns % 1000000000);
+      return ts;
+    }
+  }
+
+  virtual_clock::virtual_clock_::virtual_clock_(std::chrono::nanoseconds start) :
+    _now(start.count()),
+    _sequence(0),
+    _advances(0),
+    _deliveries(0),
+    _expirations(0)
+  {}
+
+  bool virtual_clock::virtual_clock_::less(std::size_t a, std::size_t b) const noexcept
+  {
+    auto& x = _slots[_queue[a]];
+    auto& y = _slots[_queue[b]];
+    return x._deadline < y._deadline || (x._deadline == y._deadline && x._sequence < y._sequence);
+  }
+
+  void virtual_clock::virtual_clock_::swap(std::size_t a, std::size_t b) noexcept
+  {
+    std::swap(_queue[a], _queue[b]);
+    _slots[_queue[a]]._index = a;
+    _slots[_queue[b]]._index = b;
+  }
+
+  void virtual_clock::virtual_clock_::sift_up(std::size_t i) noexcept
+  {
+    while (i > 0 && less(i, (i - 1) / 2))
+    {
+      swap(i, (i - 1) / 2);
+      i = (i - 1) / 2;
+    }
+  }
+
+  void virtual_clock::virtual_clock_::sift_down(std::size_t i) noexcept
+  {
+    for (;;)
+    {
+      auto smallest = i;
+      auto left = 2 * i + 1;
+      auto right = left + 1;
+
+      if (left < _queue.size() && less(left, smallest))
+      {
+        smallest = left;
+      }
+      if (right < _queue.size() && less(right, smallest))
+      {
+        smallest = right;
+      }
+      if (smallest == i)
+      {
+        return;
+      }
+      swap(i, smallest);
+      i = smallest;
+    }
+  }
+
+  void virtual_clock::virtual_clock_::push(std::uint32_t index) noexcept
+  {
+    // the queue has a place for every slot reserved by attach
+    _slots[index]._index = _queue.size();
+    _queue.push_back(index);
+    sift_up(_queue.size() - 1);
+  }
+
+  void virtual_clock::virtual_clock_::remove(std::uint32_t index) noexcept
+  {
+    auto i = _slots[index]._index;
+    auto last = _queue.size() - 1;
+    _slots[index]._index = npos;
+
+    if (i != last)
+    {
+      _queue[i] = _queue[last];
+      _slots[_queue[i]]._index = i;
+    }
+    _queue.pop_back();
+
+    if (i != last)
+    {
+      sift_down(i);
+      sift_up(i);
+    }
+  }
+
+  void virtual_clock::virtual_clock_::release(std::uint32_t index) noexcept
+  {
+    // a detached slot is reused once no advance refers to it anymore
+    auto& s = _slots[index];
+    if (!s._timer && !s._busy && !s._parked)
+    {
+      s = slot();
+      _free.push_back(index);
+    }
+  }
+
+  std::chrono::nanoseconds virtual_clock::virtual_clock_::now() const noexcept
+  {
+    return std::chrono::nanoseconds(_now.load(std::memory_order_acquire));
+  }
+
+  std::size_t virtual_clock::virtual_clock_::advance_to(std::chrono::nanoseconds instant)
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    std::vector<std::uint32_t> parked;
+    std::size_t delivered = 0;
+
+    // the busy timers of the enclosing advances stay off the queue until this one returns, their periods elapsing
+    // meanwhile are overruns
+    struct unpark
+    {
+      virtual_clock_& _clock;
+      std::vector<std::uint32_t>& _parked;
+
+      ~unpark()
+      {
+        for (auto index : _parked)
+        {
+          auto& s = _clock._slots[index];
+          s._parked = false;
+          if (s._timer && s._deadline != 0)
+          {
+            _clock.push(index);
+          }
+          _clock.release(index);
+        }
+      }
+    } restore{*this, parked};
+
+    _advances++;
+    while (!_queue.empty())
+    {
+      auto index = _queue.front();
+      auto& s = _slots[index];
+
+      // a nested advance may have moved the time beyond this one's instant, whatever is due by now is delivered
+      if (s._deadline > std::max(instant.count(), _now.load(std::memory_order_relaxed)))
+      {
+        break;
+      }
+
+      remove(index);
+      if (s._busy)
+      {
+        s._parked = true;
+        parked.push_back(index);
+        continue;
+      }
+
+      // the time moves to the deadline, every period elapsed up to now is delivered by this expiry
+      auto now = std::max(_now.load(std::memory_order_relaxed), s._deadline);
+      _now.store(now, std::memory_order_release);
+      std::uint64_t expirations = 1;
+      if (s._interval > 0)
+      {
+        expirations += static_cast<std::uint64_t>((now - s._deadline) / s._interval);
+        s._deadline += s._interval * static_cast<std::int64_t>(expirations);
+        s._sequence = _sequence++;
+        push(index);
+      }
+      else
+      {
+        s._deadline = 0;
+      }
+
+      s._busy = true;
+      s._owner = std::this_thread::get_id();
+      _deliveries++;
+      _expirations += expirations;
+      delivered++;
+
+      auto tm = s._timer;
+      lock.unlock();
+
+      struct done
+      {
+        virtual_clock_& _clock;
+        std::unique_lock<std::mutex>& _lock;
+        std::uint32_t _index;
+
+        ~done()
+        {
+          _lock.lock();
+          _clock._slots[_index]._busy = false;
+          _clock.release(_index);
+          _clock._delivered.notify_all();
+        }
+      } finish{*this, lock, index};
+
+      tm->fired();
+      tm->expire(expirations);
+    }
+
+    if (instant.count() > _now.load(std::memory_order_relaxed))
+    {
+      _now.store(instant.count(), std::memory_order_release);
+    }
+    return delivered;
+  }
+
+  std::chrono::nanoseconds virtual_clock::virtual_clock_::next_deadline() const noexcept
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+
+    if (_queue.empty())
+    {
+      return std::chrono::nanoseconds::max();
+    }
+    return std::chrono::nanoseconds(_slots[_queue.front()]._deadline);
+  }
+
+  std::size_t virtual_clock::virtual_clock_::size() const noexcept
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _queue.size();
+  }
+
+  virtual_clock::counters virtual_clock::virtual_clock_::stats() const noexcept
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return counters{_advances, _deliveries, _expirations};
+  }
+
+  std::uint32_t virtual_clock::virtual_clock_::attach(timer::timer_* tm)
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    std::uint32_t index;
+
+    if (!_free.empty())
+    {
+      index = _free.back();
+      _free.pop_back();
+    }
+    else
+    {
+      index = static_cast<std::uint32_t>(_slots.size());
+      _slots.emplace_back();
+      _queue.reserve(_slots.size());
+    }
+
+    _slots[index]._timer = tm;
+    return index;
+  }
+
+  void virtual_clock::virtual_clock_::detach(std::uint32_t index) noexcept
+  {
+    std::unique_lock<std::mutex> lock(_mutex);
+    auto& s = _slots[index];
+
+    // an expiry delivered by another thread is waited for, one delivered by this thread is its own caller
+    _delivered.wait(lock, [&s]() { return !s._busy || s._owner == std::this_thread::get_id(); });
+
+    if (s._index != npos)
+    {
+      remove(index);
+    }
+    s._timer = nullptr;
+    s._deadline = 0;
+    release(index);
+  }
+
+  int virtual_clock::virtual_clock_::settime(std::uint32_t index, const struct itimerspec& ts, int flags,
+      struct itimerspec* old) noexcept
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto& s = _slots[index];
+    auto now = _now.load(std::memory_order_relaxed);
+
+    if (old)
+    {
+      // like the kernel, a timer due but not delivered yet has 1ns left
+      old->it_value = to_timespec(s._deadline != 0 ? std::max<std::int64_t>(s._deadline - now, 1) : 0);
+      old->it_interval = to_timespec(s._interval);
+    }
+
+    if (s._index != npos)
+    {
+      remove(index);
+    }
+
+    auto value = to_nanoseconds(ts.it_value);
+    s._deadline = value == 0 ? 0 : (flags & TIMER_ABSTIME) ? value : now + value;
+    s._interval = value == 0 ? 0 : to_nanoseconds(ts.it_interval);
+    s._sequence = _sequence++;
+
+    // a parked slot is queued again by the advance which has parked it
+    if (s._deadline != 0 && !s._parked)
+    {
+      push(index);
+    }
+    return 0;
+  }
+} //namespace posixcpp
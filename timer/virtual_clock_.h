@@ -0,0 +1,81 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* C headers */
+#include <time.h>
+
+/* Local headers */
+#include "timer.h"
+#include "virtual_clock.h"
+
+namespace posixcpp
+{
+  class virtual_clock::virtual_clock_
+  {
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+    /**
+     * Virtual kernel timer of one timer
+     */
+    struct slot
+    {
+      timer::timer_* _timer = nullptr;        /**< nullptr once the timer is detached */
+      std::int64_t _deadline = 0;             /**< virtual nanoseconds, 0 when disarmed */
+      std::int64_t _interval = 0;
+      std::uint64_t _sequence = 0;            /**< arming order, breaks the ties of equal deadlines */
+      std::size_t _index = npos;              /**< position in the queue, npos when not queued */
+      bool _busy = false;                     /**< the expiry is being delivered */
+      bool _parked = false;                   /**< taken off the queue by a nested advance while busy */
+      std::thread::id _owner;                 /**< thread delivering the expiry */
+    };
+
+    mutable std::mutex _mutex;
+    std::condition_variable _delivered;       /**< a busy slot has been delivered */
+    std::atomic<std::int64_t> _now;
+    std::deque<slot> _slots;
+    std::vector<std::uint32_t> _free;
+    std::vector<std::uint32_t> _queue;        /**< binary min heap on slot::_deadline and slot::_sequence */
+    std::uint64_t _sequence;
+    std::uint64_t _advances;
+    std::uint64_t _deliveries;
+    std::uint64_t _expirations;
+
+    bool less(std::size_t a, std::size_t b) const noexcept;
+    void swap(std::size_t a, std::size_t b) noexcept;
+    void sift_up(std::size_t i) noexcept;
+    void sift_down(std::size_t i) noexcept;
+    void push(std::uint32_t index) noexcept;
+    void remove(std::uint32_t index) noexcept;
+    void release(std::uint32_t index) noexcept;
+
+    public:
+    explicit virtual_clock_(std::chrono::nanoseconds start);
+
+    ~virtual_clock_() = default;
+
+    virtual_clock_(const virtual_clock_&) = delete;
+    virtual_clock_(virtual_clock_&&) = delete;
+    virtual_clock_& operator=(const virtual_clock_&) = delete;
+    virtual_clock_& operator=(virtual_clock_&&) = delete;
+
+    std::chrono::nanoseconds now() const noexcept;
+    std::size_t advance_to(std::chrono::nanoseconds instant);
+    std::chrono::nanoseconds next_deadline() const noexcept;
+    std::size_t size() const noexcept;
+    counters stats() const noexcept;
+
+    /* the timer_ side */
+    std::uint32_t attach(timer::timer_* tm);
+    void detach(std::uint32_t index) noexcept;
+    int settime(std::uint32_t index, const struct itimerspec& ts, int flags, struct itimerspec* old) noexcept;
+  };
+} //namespace posixcpp
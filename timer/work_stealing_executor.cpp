@@ -0,0 +1,34 @@
+/* Local headers */
+#include "executor.h"
+#include "work_stealing_executor_.h"
+
+namespace posixcpp
+{
+  work_stealing_executor::work_stealing_executor(std::size_t workers, std::size_t queue_size, bool pin) :
+    _executor(new work_stealing_executor_(workers, queue_size, pin))
+  {}
+
+  work_stealing_executor::~work_stealing_executor()
+  {}
+
+  bool work_stealing_executor::execute(task_t task, std::size_t worker) noexcept
+  {
+    return _executor->execute(task, worker);
+  }
+
+  std::size_t work_stealing_executor::concurrency() const noexcept
+  {
+    return _executor->concurrency();
+  }
+
+  std::uint64_t work_stealing_executor::stolen() const noexcept
+  {
+    return _executor->stolen();
+  }
+
+  std::uint64_t work_stealing_executor::rejected() const noexcept
+  {
+    return _executor->rejected();
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "log.h"
+#include "work_stealing_executor_.h"
+
+namespace posixcpp
+{
+  work_stealing_executor::work_stealing_executor_::worker::worker(std::size_t queue_size) :
+    _queue(queue_size),
+    _pinned(queue_size),
+    _sleeping(false)
+  {
+    sem_init(&_ready, 0, 0);
+  }
+
+  work_stealing_executor::work_stealing_executor_::worker::~worker()
+  {
+    sem_destroy(&_ready);
+  }
+
+  work_stealing_executor::work_stealing_executor_::work_stealing_executor_(std::size_t workers,
+      std::size_t queue_size, bool pin) :
+    _running(true),
+    _next(0),
+    _stolen(0),
+    _rejected(0)
+  {
+    if (workers == 0)
+    {
+      throw std::invalid_argument("work_stealing_executor needs at least one worker");
+    }
+
+    POSIXCPP_LOG(LOG_INFO, "work_stealing_executor_ ctor workers %lu, queue size %lu", (unsigned long)workers,
+        (unsigned long)queue_size);
+
+    for (std::size_t i = 0; i < workers; i++)
+    {
+      _workers.emplace_back(new worker(queue_size));
+    }
+
+    auto cores = std::max(std::thread::hardware_concurrency(), 1u);
+    for (std::size_t i = 0; i < workers; i++)
+    {
+      auto& w = *_workers[i];
+      w._thread = std::thread(&work_stealing_executor_::run, this, i);
+
+      if (pin)
+      {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(i % cores, &set);
+        if (pthread_setaffinity_np(w._thread.native_handle(), sizeof(set), &set) != 0)
+        {
+          // restricted cpuset, the worker simply floats
+          POSIXCPP_LOG(LOG_WARNING, "work_stealing_executor_ can't pin worker %lu to core %lu", (unsigned long)i,
+              (unsigned long)(i % cores));
+        }
+      }
+    }
+  }
+
+  work_stealing_executor::work_stealing_executor_::~work_stealing_executor_()
+  {
+    _running.store(false);
+
+    for (auto& w : _workers)
+    {
+      sem_post(&w->_ready);
+    }
+
+    for (auto& w : _workers)
+    {
+      w->_thread.join();
+    }
+  }
+
+  bool work_stealing_executor::work_stealing_executor_::take(std::size_t index, task_t& task) noexcept
+  {
+    auto& own = *_workers[index];
+
+    if (own._pinned.pop(task) || own._queue.pop(task))
+    {
+      return true;
+    }
+
+    // steal, starting with the neighbour, so the thieves don't all hit the same victim
+    for (std::size_t i = 1; i < _workers.size(); i++)
+    {
+      if (_workers[(index + i) % _workers.size()]->_queue.pop(task))
+      {
+        _stolen++;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool work_stealing_executor::work_stealing_executor_::wake(worker& w) noexcept
+  {
+    // pairs with the fence of run, either the worker sees the queued task or we see it sleeping; the one clearing the
+    // flag posts, so the semaphore never counts more than one wakeup
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (w._sleeping.load() && w._sleeping.exchange(false))
+    {
+      sem_post(&w._ready);
+      return true;
+    }
+    return false;
+  }
+
+  void work_stealing_executor::work_stealing_executor_::wake_idle() noexcept
+  {
+    for (auto& w : _workers)
+    {
+      if (wake(*w))
+      {
+        return;
+      }
+    }
+  }
+
+  void work_stealing_executor::work_stealing_executor_::run(std::size_t index) noexcept
+  {
+    auto& w = *_workers[index];
+    task_t task;
+
+    while (true)
+    {
+      if (!take(index, task))
+      {
+        if (!_running.load())
+        {
+          break;
+        }
+
+        // announce the sleep first, then look once more, a producer either sees the flag or we see its task
+        w._sleeping.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!take(index, task))
+        {
+          while (sem_wait(&w._ready) != 0)
+          {
+            // EINTR, try again
+          }
+          w._sleeping.store(false);
+          continue;
+        }
+
+        if (!w._sleeping.exchange(false))
+        {
+          // a producer has cleared the flag first, its post is consumed here rather than by the next sleep
+          while (sem_wait(&w._ready) != 0)
+          {
+            // EINTR, try again
+          }
+        }
+      }
+
+      try
+      {
+        task();
+      }
+      catch (...)
+      {
+        POSIXCPP_LOG(LOG_ERR, "work_stealing_executor_ worker %lu task has thrown", (unsigned long)index);
+      }
+      task = nullptr;
+    }
+  }
+
+  bool work_stealing_executor::work_stealing_executor_::execute(task_t& task, std::size_t worker) noexcept
+  {
+    if (worker != executor::any)
+    {
+      auto& w = *_workers[worker % _workers.size()];
+      if (!w._pinned.push(task))
+      {
+        _rejected++;
+        return false;
+      }
+      wake(w);
+      return true;
+    }
+
+    auto first = _next.fetch_add(1);
+    for (std::size_t i = 0; i < _workers.size(); i++)
+    {
+      auto& w = *_workers[(first + i) % _workers.size()];
+      if (w._queue.push(task))
+      {
+        if (!wake(w))
+        {
+          // the owner is busy, let an idle worker steal the task
+          wake_idle();
+        }
+        return true;
+      }
+    }
+
+    _rejected++;
+    return false;
+  }
+
+  std::size_t work_stealing_executor::work_stealing_executor_::concurrency() const noexcept
+  {
+    return _workers.size();
+  }
+
+  std::uint64_t work_stealing_executor::work_stealing_executor_::stolen() const noexcept
+  {
+    return _stolen.load();
+  }
+
+  std::uint64_t work_stealing_executor::work_stealing_executor_::rejected() const noexcept
+  {
+    return _rejected.load();
+  }
+
+} //namespace posixcpp
@@ -0,0 +1,59 @@
+#pragma once
+
+/* STL C++ headers */
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/* Linux system headers */
+#include <semaphore.h>
+
+/* Local headers */
+#include "executor.h"
+#include "mpmc_ring.h"
+
+namespace posixcpp
+{
+  class work_stealing_executor::work_stealing_executor_
+  {
+    struct worker
+    {
+      mpmc_ring<task_t> _queue;                   /**< tasks without affinity, other workers steal from it */
+      mpmc_ring<task_t> _pinned;                  /**< tasks with affinity to this worker */
+      sem_t _ready;                               /**< posted once per sleep, by the producer clearing _sleeping */
+      std::atomic<bool> _sleeping;
+      std::thread _thread;
+
+      explicit worker(std::size_t queue_size);
+      ~worker();
+    };
+
+    std::atomic<bool> _running;
+    std::atomic<std::size_t> _next;               /**< round robin worker index */
+    std::atomic<std::uint64_t> _stolen;
+    std::atomic<std::uint64_t> _rejected;
+    std::vector<std::unique_ptr<worker>> _workers;
+
+    bool take(std::size_t index, task_t& task) noexcept;
+    static bool wake(worker& w) noexcept;
+    void wake_idle() noexcept;
+    void run(std::size_t index) noexcept;
+
+    public:
+    explicit work_stealing_executor_(std::size_t workers, std::size_t queue_size, bool pin);
+
+    ~work_stealing_executor_();
+
+    work_stealing_executor_(const work_stealing_executor_&) = delete;
+    work_stealing_executor_(work_stealing_executor_&&) = delete;
+    work_stealing_executor_& operator=(const work_stealing_executor_&) = delete;
+    work_stealing_executor_& operator=(work_stealing_executor_&&) = delete;
+
+    bool execute(task_t& task, std::size_t worker) noexcept;
+    std::size_t concurrency() const noexcept;
+    std::uint64_t stolen() const noexcept;
+    std::uint64_t rejected() const noexcept;
+  };
+} //namespace posixcpp
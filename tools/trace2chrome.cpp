@@ -0,0 +1,185 @@
+//
+// Converts a posixcpp::trace file into Chrome trace JSON, to be opened with chrome://tracing or ui.perfetto.dev.
+//
+// Usage: trace2chrome <trace file> [<json file>]
+//
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+using namespace std;
+using namespace posixcpp;
+
+namespace
+{
+  /**
+   * Maps the trace file read-only, the mapping keeps the alignment of the headers
+   */
+  const char* load(const char* path, size_t& size)
+  {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+    {
+      return nullptr;
+    }
+
+    struct stat st;
+    void* data = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+    {
+      size = static_cast<size_t>(st.st_size);
+      data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    else
+    {
+      errno = EINVAL;
+    }
+    int err = errno;
+    close(fd);
+    errno = err;
+    return data == MAP_FAILED ? nullptr : static_cast<const char*>(data);
+  }
+
+  void write_string(FILE* out, const char* s, size_t max)
+  {
+    fputc('"', out);
+    for (size_t i = 0; i < max && s[i]; i++)
+    {
+      unsigned char c = static_cast<unsigned char>(s[i]);
+      if (c == '"' || c == '\\')
+      {
+        fprintf(out, "\\%c", c);
+      }
+      else if (c < 0x20)
+      {
+        fprintf(out, "\\u%04x", c);
+      }
+      else
+      {
+        fputc(c, out);
+      }
+    }
+    fputc('"', out);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2 || argc > 3)
+  {
+    fprintf(stderr, "usage: %s <trace file> [<json file>]\n", argv[0]);
+    return 1;
+  }
+
+  size_t size = 0;
+  const char* data = load(argv[1], size);
+  if (!data)
+  {
+    fprintf(stderr, "%s: cannot read %s: %s\n", argv[0], argv[1], strerror(errno));
+    return 1;
+  }
+
+  auto header = reinterpret_cast<const trace::file_header*>(data);
+  if (size < sizeof(trace::file_header) || memcmp(header->_magic, trace::magic, sizeof(trace::magic)) != 0 ||
+      header->_record_size != sizeof(trace::record) || header->_capacity == 0 ||
+      (header->_capacity & (header->_capacity - 1)) != 0)
+  {
+    fprintf(stderr, "%s: %s is not a posixcpp trace\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  size_t ring_size = sizeof(trace::ring_header) + header->_capacity * sizeof(trace::record);
+  size_t rings = min<size_t>(header->_claimed.load(), header->_threads);
+  if (size < sizeof(trace::file_header) + header->_threads * ring_size)
+  {
+    fprintf(stderr, "%s: %s is truncated\n", argv[0], argv[1]);
+    return 1;
+  }
+
+  FILE* out = argc == 3 ? fopen(argv[2], "w") : stdout;
+  if (!out)
+  {
+    fprintf(stderr, "%s: cannot write %s: %s\n", argv[0], argv[2], strerror(errno));
+    return 1;
+  }
+
+  // the rings, a crashed process may have left the newest slot of a ring unwritten
+  vector<trace::record> records;
+  fprintf(out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+  fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%" PRIu32 ",\"args\":{\"name\":\"posixcpp\"}}",
+      header->_pid);
+  for (size_t i = 0; i < rings; i++)
+  {
+    auto ring = reinterpret_cast<const trace::ring_header*>(data + sizeof(trace::file_header) + i * ring_size);
+    auto slots = reinterpret_cast<const trace::record*>(ring + 1);
+    uint64_t head = ring->_head.load();
+    uint64_t n = min<uint64_t>(head, header->_capacity);
+
+    fprintf(out, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32
+        ",\"args\":{\"name\":", header->_pid, ring->_tid.load());
+    write_string(out, ring->_name, sizeof(ring->_name));
+    fprintf(out, "}}");
+
+    for (uint64_t j = head - n; j < head; j++)
+    {
+      const trace::record& r = slots[j & (header->_capacity - 1)];
+      if (r._timestamp != 0)
+      {
+        records.push_back(r);
+      }
+    }
+  }
+
+  stable_sort(records.begin(), records.end(), [](const trace::record& a, const trace::record& b) {
+      return a._timestamp < b._timestamp;
+    });
+
+  // Chrome trace time stamps are microseconds, relative to the first event
+  for (auto& r : records)
+  {
+    r._timestamp = trace::nanoseconds(*header, r._timestamp);
+  }
+  uint64_t origin = records.empty() ? 0 : records.front()._timestamp;
+  for (auto& r : records)
+  {
+    const char* name = trace::name(r._event);
+    const char* phase = "i";
+    if (r._event == trace::event::callback_begin)
+    {
+      name = "callback";
+      phase = "B";
+    }
+    else if (r._event == trace::event::callback_end)
+    {
+      name = "callback";
+      phase = "E";
+    }
+
+    uint64_t ts = r._timestamp - origin;
+    fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"timer\",\"ph\":\"%s\",%s\"ts\":%" PRIu64 ".%03" PRIu64
+        ",\"pid\":%" PRIu32 ",\"tid\":%" PRIu32 ",\"args\":{\"timer\":\"0x%" PRIx64 "\",\"arg\":%" PRIu64 "}}",
+        name, phase, phase[0] == 'i' ? "\"s\":\"t\"," : "", ts / 1000, ts % 1000, header->_pid, r._tid, r._id,
+        r._arg);
+  }
+  fprintf(out, "\n]}\n");
+
+  if (argc == 3 && fclose(out) != 0)
+  {
+    fprintf(stderr, "%s: cannot write %s: %s\n", argv[0], argv[2], strerror(errno));
+    return 1;
+  }
+  fprintf(stderr, "%zu events of %zu threads, %" PRIu64 " dropped\n", records.size(), rings,
+      header->_dropped.load());
+  return 0;
+}